@@ -21,6 +21,7 @@ bool parseCommandLine(int argc, char* argv[], Options* opt)
       ("trans,t",  po::value<std::string>(&opt->host), "Transmit")
       ("recv,r", "Receive")
       ("nodelay,D", "set TCP_NODELAY")
+      ("zerocopy,z", "Transmit with MSG_ZEROCOPY, ttcp_muduo only")
       ;
 
   po::variables_map vm;
@@ -30,6 +31,7 @@ bool parseCommandLine(int argc, char* argv[], Options* opt)
   opt->transmit = vm.count("trans");
   opt->receive = vm.count("recv");
   opt->nodelay = vm.count("nodelay");
+  opt->zerocopy = vm.count("zerocopy");
   if (vm.count("help"))
   {
     std::cout << desc << std::endl;
@@ -47,6 +49,10 @@ bool parseCommandLine(int argc, char* argv[], Options* opt)
   {
     printf("buffer length = %d\n", opt->length);
     printf("number of buffers = %d\n", opt->number);
+    if (opt->zerocopy)
+    {
+      printf("zero copy\n");
+    }
   }
   else
   {
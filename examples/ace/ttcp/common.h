@@ -8,11 +8,11 @@ struct Options
   uint16_t port;
   int length;
   int number;
-  bool transmit, receive, nodelay;
+  bool transmit, receive, nodelay, zerocopy;
   std::string host;
   Options()
     : port(0), length(0), number(0),
-      transmit(false), receive(false), nodelay(false)
+      transmit(false), receive(false), nodelay(false), zerocopy(false)
   {
   }
 };
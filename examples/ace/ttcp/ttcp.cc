@@ -18,6 +18,7 @@ struct Context
   int64_t bytes;
   SessionMessage session;
   Buffer output;
+  Slice payload;  // output, for zero-copy
 
   Context()
     : count(0),
@@ -35,6 +36,18 @@ struct Context
 namespace trans
 {
 
+void send(const TcpConnectionPtr& conn, const Context& context)
+{
+  if (!context.payload.empty())
+  {
+    conn->send(context.payload);
+  }
+  else
+  {
+    conn->send(context.output.toStringPiece());
+  }
+}
+
 void onConnection(const Options& opt, const TcpConnectionPtr& conn)
 {
   if (conn->connected())
@@ -52,6 +65,11 @@ void onConnection(const Options& opt, const TcpConnectionPtr& conn)
       context.output.beginWrite()[i] = "0123456789ABCDEF"[i % 16];
     }
     context.output.hasWritten(opt.length);
+    if (opt.zerocopy && conn->setZeroCopy())
+    {
+      // sent as is, no copy into the output buffer, nor into the kernel
+      context.payload = Slice::copyOf(context.output.toStringPiece());
+    }
     conn->setContext(context);
 
     SessionMessage sessionMessage = { 0, 0 };
@@ -59,7 +77,7 @@ void onConnection(const Options& opt, const TcpConnectionPtr& conn)
     sessionMessage.length = htonl(opt.length);
     conn->send(&sessionMessage, sizeof(sessionMessage));
 
-    conn->send(context.output.toStringPiece());
+    send(conn, context);
   }
   else
   {
@@ -79,7 +97,7 @@ void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp time)
     {
       if (context->count < context->session.number)
       {
-        conn->send(context->output.toStringPiece());
+        send(conn, *context);
         ++context->count;
         context->bytes += length;
       }
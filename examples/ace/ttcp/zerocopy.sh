@@ -0,0 +1,29 @@
+#!/bin/sh
+
+# Compares ttcp_muduo throughput of copy-based sends and MSG_ZEROCOPY.
+# Usage: zerocopy.sh [bin_dir] [host] [length] [number]
+# Over loopback the kernel copies anyway, run the receiver on another host
+# (ttcp_muduo -r) and give its address to see the difference.
+
+BIN=${1:-../../../../build/release-cpp11/bin}
+HOST=${2:-127.0.0.1}
+LENGTH=${3:-16777216}
+NUMBER=${4:-64}
+PORT=5001
+
+run()
+{
+  echo "==== $1"
+  if [ "$HOST" = "127.0.0.1" ]; then
+    $BIN/ttcp_muduo -r -p $PORT > /dev/null 2>&1 &
+    RECEIVER=$!
+    sleep 1
+  fi
+  $BIN/ttcp_muduo -t $HOST -p $PORT -l $LENGTH -n $NUMBER $2 2>&1 | grep 'MiB'
+  if [ "$HOST" = "127.0.0.1" ]; then
+    wait $RECEIVER 2> /dev/null
+  fi
+}
+
+run copy
+run zerocopy -z
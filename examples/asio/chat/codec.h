@@ -4,6 +4,7 @@
 #include "muduo/base/Logging.h"
 #include "muduo/net/Buffer.h"
 #include "muduo/net/Endian.h"
+#include "muduo/net/Slice.h"
 #include "muduo/net/TcpConnection.h"
 
 class LengthHeaderCodec : muduo::noncopyable
@@ -60,6 +61,16 @@ class LengthHeaderCodec : muduo::noncopyable
     conn->send(&buf);
   }
 
+  /// Encoded once, to be sent to many by reference.
+  static muduo::net::Slice encode(const muduo::StringPiece& message)
+  {
+    muduo::string encoded(kHeaderLen + message.size(), '\0');
+    int32_t be32 = muduo::net::sockets::hostToNetwork32(static_cast<int32_t>(message.size()));
+    memcpy(&encoded[0], &be32, sizeof be32);
+    memcpy(&encoded[kHeaderLen], message.data(), message.size());
+    return muduo::net::Slice(std::move(encoded));
+  }
+
  private:
   StringMessageCallback messageCallback_;
   const static size_t kHeaderLen = sizeof(int32_t);
@@ -2,6 +2,7 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/net/Broadcast.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpServer.h"
 
@@ -52,12 +53,7 @@ class ChatServer : noncopyable
                        const string& message,
                        Timestamp)
   {
-    for (ConnectionList::iterator it = connections_.begin();
-        it != connections_.end();
-        ++it)
-    {
-      codec_.send(get_pointer(*it), message);
-    }
+    broadcast(connections_, LengthHeaderCodec::encode(message));
   }
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
@@ -2,6 +2,7 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/net/Broadcast.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpServer.h"
 
@@ -58,13 +59,9 @@ class ChatServer : noncopyable
                        const string& message,
                        Timestamp)
   {
+    Slice encoded = LengthHeaderCodec::encode(message);
     MutexLockGuard lock(mutex_);
-    for (ConnectionList::iterator it = connections_.begin();
-        it != connections_.end();
-        ++it)
-    {
-      codec_.send(get_pointer(*it), message);
-    }
+    broadcast(connections_, encoded);
   }
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
@@ -2,6 +2,7 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/net/Broadcast.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpServer.h"
 
@@ -68,13 +69,8 @@ class ChatServer : noncopyable
                        const string& message,
                        Timestamp)
   {
-    ConnectionListPtr connections = getConnectionList();;
-    for (ConnectionList::iterator it = connections->begin();
-        it != connections->end();
-        ++it)
-    {
-      codec_.send(get_pointer(*it), message);
-    }
+    ConnectionListPtr connections = getConnectionList();
+    broadcast(*connections, LengthHeaderCodec::encode(message));
   }
 
   ConnectionListPtr getConnectionList()
@@ -59,7 +59,9 @@ class ChatServer : noncopyable
                        const string& message,
                        Timestamp)
   {
-    EventLoop::Functor f = std::bind(&ChatServer::distributeMessage, this, message);
+    // encoded once, shared by all loops
+    EventLoop::Functor f = std::bind(&ChatServer::distributeMessage, this,
+                                     LengthHeaderCodec::encode(message));
     LOG_DEBUG;
 
     MutexLockGuard lock(mutex_);
@@ -74,14 +76,14 @@ class ChatServer : noncopyable
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
 
-  void distributeMessage(const string& message)
+  void distributeMessage(const Slice& message)
   {
     LOG_DEBUG << "begin";
     for (ConnectionList::iterator it = LocalConnections::instance().begin();
         it != LocalConnections::instance().end();
         ++it)
     {
-      codec_.send(get_pointer(*it), message);
+      (*it)->send(message);
     }
     LOG_DEBUG << "end";
   }
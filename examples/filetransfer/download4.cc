@@ -0,0 +1,70 @@
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpServer.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// Zero-copy version of download3.cc, the kernel sends the file
+// with sendfile(2), no read(2) into user space.
+
+const char* g_file = NULL;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  LOG_INFO << "FileServer - " << conn->peerAddress().toIpPort() << " -> "
+           << conn->localAddress().toIpPort() << " is "
+           << (conn->connected() ? "UP" : "DOWN");
+  if (conn->connected())
+  {
+    LOG_INFO << "FileServer - Sending file " << g_file
+             << " to " << conn->peerAddress().toIpPort();
+    int fd = ::open(g_file, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0)
+    {
+      // fd is closed by conn
+      conn->sendFile(fd, 0, static_cast<size_t>(st.st_size));
+    }
+    else
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+      LOG_INFO << "FileServer - no such file";
+    }
+    conn->shutdown();
+  }
+}
+
+void onWriteComplete(const TcpConnectionPtr& conn)
+{
+  LOG_INFO << "FileServer - done";
+}
+
+int main(int argc, char* argv[])
+{
+  LOG_INFO << "pid = " << getpid();
+  if (argc > 1)
+  {
+    g_file = argv[1];
+
+    EventLoop loop;
+    InetAddress listenAddr(2021);
+    TcpServer server(&loop, listenAddr, "FileServer");
+    server.setConnectionCallback(onConnection);
+    server.setWriteCompleteCallback(onWriteComplete);
+    server.start();
+    loop.loop();
+  }
+  else
+  {
+    fprintf(stderr, "Usage: %s file_for_downloading\n", argv[0]);
+  }
+}
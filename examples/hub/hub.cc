@@ -1,6 +1,7 @@
 #include "examples/hub/codec.h"
 
 #include "muduo/base/Logging.h"
+#include "muduo/net/Broadcast.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpServer.h"
 
@@ -42,13 +43,8 @@ class Topic : public muduo::copyable
   {
     content_ = content;
     lastPubTime_ = time;
-    string message = makeMessage();
-    for (std::set<TcpConnectionPtr>::iterator it = audiences_.begin();
-         it != audiences_.end();
-         ++it)
-    {
-      (*it)->send(message);
-    }
+    // one copy for all audiences
+    broadcast(audiences_, Slice(makeMessage()));
   }
 
  private:
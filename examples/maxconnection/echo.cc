@@ -1,6 +1,9 @@
 #include "examples/maxconnection/echo.h"
+#include "examples/maxconnection/rss.h"
 
 #include "muduo/base/Logging.h"
+#include "muduo/net/BufferPool.h"
+#include "muduo/net/EventLoop.h"
 
 using namespace muduo;
 using namespace muduo::net;
@@ -8,9 +11,11 @@ using namespace muduo::net;
 EchoServer::EchoServer(EventLoop* loop,
                        const InetAddress& listenAddr,
                        int maxConnections)
-  : server_(loop, listenAddr, "EchoServer"),
+  : loop_(loop),
+    server_(loop, listenAddr, "EchoServer"),
     numConnected_(0),
-    kMaxConnections_(maxConnections)
+    kMaxConnections_(maxConnections),
+    startRss_(residentBytes())
 {
   server_.setConnectionCallback(
       std::bind(&EchoServer::onConnection, this, _1));
@@ -23,6 +28,25 @@ void EchoServer::start()
   server_.start();
 }
 
+void EchoServer::printFootprintEvery(double seconds)
+{
+  loop_->runEvery(seconds, std::bind(&EchoServer::printFootprint, this));
+}
+
+void EchoServer::printFootprint()
+{
+  const long rss = residentBytes();
+  const BufferPool* pool = loop_->bufferPool();
+  LOG_INFO << "connections " << numConnected_
+           << " rss " << rss
+           << " rss/conn " << (numConnected_ > 0 ? (rss - startRss_) / numConnected_ : 0)
+           << " buffers " << pool->bytesInUse()
+           << " buffers/conn " << (numConnected_ > 0 ? pool->bytesInUse() / numConnected_ : 0)
+           << " cached " << pool->cachedBytes()
+           << " hits " << pool->hits()
+           << " misses " << pool->misses();
+}
+
 void EchoServer::onConnection(const TcpConnectionPtr& conn)
 {
   LOG_INFO << "EchoServer - " << conn->peerAddress().toIpPort() << " -> "
@@ -13,6 +13,9 @@ class EchoServer
 
   void start();
 
+  /// Prints memory footprint of connections every @c seconds.
+  void printFootprintEvery(double seconds);
+
  private:
   void onConnection(const muduo::net::TcpConnectionPtr& conn);
 
@@ -20,9 +23,13 @@ class EchoServer
                  muduo::net::Buffer* buf,
                  muduo::Timestamp time);
 
+  void printFootprint();
+
+  muduo::net::EventLoop* loop_;
   muduo::net::TcpServer server_;
   int numConnected_; // should be atomic_int
   const int kMaxConnections_;
+  long startRss_;  // in bytes
 };
 
 #endif  // MUDUO_EXAMPLES_MAXCONNECTION_ECHO_H
@@ -0,0 +1,163 @@
+// Opens idle connections to a TcpServer in the same process and loop,
+// then reports the user space memory taken by each of them.
+//
+// eg. maxconnection_idle 1000000, as root or with ulimit -n above 2000010,
+// and fs.nr_open raised to match.  Clients bind to 127.0.0.2 and up,
+// kPerSourceAddress connections each, so ip_local_port_range is no limit.
+// Kernel memory of sockets is not counted, see /proc/net/sockstat for it.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "examples/maxconnection/rss.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/BufferPool.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpServer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef IP_BIND_ADDRESS_NO_PORT
+#define IP_BIND_ADDRESS_NO_PORT 24
+#endif
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2008;
+const int kPerSourceAddress = 50000;
+const int kBatch = 1000;  // connecting at a time
+
+EventLoop* g_loop;
+int g_total;
+int g_connected;
+std::vector<int> g_clients;
+long g_startRss;
+int64_t g_startBuffers;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    ++g_connected;
+  }
+  else
+  {
+    --g_connected;
+  }
+}
+
+bool connectOne()
+{
+  const int n = static_cast<int>(g_clients.size());
+  int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (sockfd < 0)
+  {
+    LOG_SYSERR << "socket, " << n << " opened";
+    return false;
+  }
+  int on = 1;
+  ::setsockopt(sockfd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof on);
+  struct sockaddr_in addr;
+  memZero(&addr, sizeof addr);
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + n / kPerSourceAddress);
+  int ret = ::bind(sockfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr);
+  if (ret == 0)
+  {
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(kPort);
+    ret = ::connect(sockfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr);
+  }
+  if (ret < 0 && errno != EINPROGRESS)
+  {
+    LOG_SYSERR << "connect, " << n << " opened";
+    ::close(sockfd);
+    return false;
+  }
+  g_clients.push_back(sockfd);
+  return true;
+}
+
+void report()
+{
+  const int n = std::max(g_connected, 1);
+  const long rss = residentBytes() - g_startRss;
+  const int64_t buffers = g_loop->bufferPool()->bytesInUse() - g_startBuffers;
+  printf("%d idle connections, rss %ld bytes, %ld bytes per connection\n",
+         g_connected, rss, rss / n);
+  printf("buffers %" PRId64 " bytes, %" PRId64 " bytes per connection\n",
+         buffers, buffers / n);
+  printf("sizeof(TcpConnection) = %zu\n", sizeof(TcpConnection));
+}
+
+void connectMore()
+{
+  if (g_connected == g_total)
+  {
+    report();
+    g_loop->quit();
+    return;
+  }
+  while (static_cast<int>(g_clients.size()) < g_total
+         && static_cast<int>(g_clients.size()) - g_connected < kBatch)
+  {
+    if (!connectOne())
+    {
+      g_total = static_cast<int>(g_clients.size());
+      LOG_WARN << "stopped at " << g_total << " connections";
+      break;
+    }
+  }
+}
+
+void begin()
+{
+  g_startRss = residentBytes();
+  g_startBuffers = g_loop->bufferPool()->bytesInUse();
+  g_loop->runEvery(0.01, connectMore);
+}
+
+int main(int argc, char* argv[])
+{
+  g_total = argc > 1 ? atoi(argv[1]) : 10000;
+  struct rlimit rl;
+  rl.rlim_cur = rl.rlim_max = 2 * g_total + 10;
+  if (::setrlimit(RLIMIT_NOFILE, &rl) == -1)
+  {
+    perror("setrlimit");
+    ::getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &rl);
+    g_total = std::min(g_total, static_cast<int>(rl.rlim_cur - 10) / 2);
+    printf("%d connections at most, by ulimit -Hn\n", g_total);
+  }
+  Logger::setLogLevel(Logger::WARN);
+
+  EventLoop loop;
+  g_loop = &loop;
+  TcpServer server(&loop, InetAddress(kPort, true), "IdleServer");
+  server.setConnectionCallback(onConnection);
+  server.start();
+  g_clients.reserve(g_total);
+  loop.runAfter(0.1, begin);
+  loop.loop();
+
+  for (int sockfd : g_clients)
+  {
+    ::close(sockfd);
+  }
+}
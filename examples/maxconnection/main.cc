@@ -20,6 +20,11 @@ int main(int argc, char* argv[])
   }
   LOG_INFO << "maxConnections = " << maxConnections;
   EchoServer server(&loop, listenAddr, maxConnections);
+  if (argc > 2)
+  {
+    // eg. maxconnection_echo 10000 5, to see the memory footprint every 5s
+    server.printFootprintEvery(atof(argv[2]));
+  }
   server.start();
   loop.loop();
 }
@@ -0,0 +1,19 @@
+#ifndef MUDUO_EXAMPLES_MAXCONNECTION_RSS_H
+#define MUDUO_EXAMPLES_MAXCONNECTION_RSS_H
+
+#include "muduo/base/FileUtil.h"
+#include "muduo/base/ProcessInfo.h"
+
+#include <stdio.h>
+
+/// Resident set size of this process, from /proc/self/statm.
+inline long residentBytes()
+{
+  muduo::string statm;
+  muduo::FileUtil::readFile("/proc/self/statm", 64, &statm);
+  long size = 0, resident = 0;
+  sscanf(statm.c_str(), "%ld %ld", &size, &resident);
+  return resident * muduo::ProcessInfo::pageSize();
+}
+
+#endif  // MUDUO_EXAMPLES_MAXCONNECTION_RSS_H
@@ -7,6 +7,7 @@
 #include "muduo/net/TcpClient.h"
 #include "muduo/net/TcpServer.h"
 
+#include <map>
 #include <queue>
 #include <utility>
 
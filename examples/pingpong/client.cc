@@ -9,6 +9,7 @@
 #include <utility>
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -205,7 +206,9 @@ int main(int argc, char* argv[])
     int timeout = atoi(argv[6]);
 
     EventLoop loop;
-    InetAddress serverAddr(ip, port);
+    // "unix:/path" or "unix:@name" for a Unix domain socket, port is ignored
+    InetAddress serverAddr = strncmp(ip, "unix:", 5) == 0 ?
+        InetAddress::unixDomain(ip + 5) : InetAddress(ip, port);
 
     Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount);
     loop.loop();
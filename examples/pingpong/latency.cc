@@ -0,0 +1,192 @@
+// Round-trip latency of one pingpong session, with and without busy polling.
+//
+// Usage: pingpong_latency [busy_poll_us [round_trips [message_size]]]
+// Without arguments, compares blocking polls with 50us busy polls.
+// Busy polling needs a spare CPU for each spinning loop, otherwise it hurts.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Histogram.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2011;
+const int kWarmUp = 1000;
+
+int64_t nowNanoSeconds()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->setTcpNoDelay(true);
+  }
+}
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+class LatencyClient : noncopyable
+{
+ public:
+  LatencyClient(EventLoop* loop, const InetAddress& serverAddr,
+                int roundTrips, int messageSize)
+    : loop_(loop),
+      client_(loop, serverAddr, "LatencyClient"),
+      message_(messageSize, 'P'),
+      roundTrips_(roundTrips),
+      sent_(0),
+      sentNanoSeconds_(0)
+  {
+    client_.setConnectionCallback(
+        std::bind(&LatencyClient::onConnection, this, _1));
+    client_.setMessageCallback(
+        std::bind(&LatencyClient::onMessage, this, _1, _2, _3));
+  }
+
+  void connect()
+  {
+    client_.connect();
+  }
+
+  // nanoseconds
+  const Histogram& latencies() const { return latencies_; }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      conn->setTcpNoDelay(true);
+      ping(conn);
+    }
+    else
+    {
+      loop_->quit();
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+  {
+    if (buf->readableBytes() < message_.size())
+    {
+      return;
+    }
+    const int64_t now = nowNanoSeconds();
+    buf->retrieve(message_.size());
+    if (sent_ > kWarmUp)
+    {
+      latencies_.add(now - sentNanoSeconds_);
+    }
+    if (latencies_.count() < roundTrips_)
+    {
+      ping(conn);
+    }
+    else
+    {
+      conn->shutdown();
+    }
+  }
+
+  void ping(const TcpConnectionPtr& conn)
+  {
+    ++sent_;
+    sentNanoSeconds_ = nowNanoSeconds();
+    conn->send(message_);
+  }
+
+  EventLoop* loop_;
+  TcpClient client_;
+  const string message_;
+  const int roundTrips_;
+  int sent_;
+  int64_t sentNanoSeconds_;
+  Histogram latencies_;
+};
+
+void printPollStats(const char* name, const EventLoop::PollStats& stats)
+{
+  const int64_t total = stats.spinMicroSeconds + stats.blockMicroSeconds;
+  printf("  %s loop: spin %.1f%% idle %.1f%%, %" PRId64 " spin polls,"
+         " %" PRId64 " spin hits, %" PRId64 " blocking polls\n",
+         name,
+         total ? 100.0 * static_cast<double>(stats.spinMicroSeconds) / static_cast<double>(total) : 0.0,
+         total ? 100.0 * static_cast<double>(stats.blockMicroSeconds) / static_cast<double>(total) : 0.0,
+         stats.spinPolls, stats.spinHits, stats.blockingPolls);
+}
+
+// upper bounds of power of two buckets
+void printHistogram(const Histogram& latencies)
+{
+  const double percentiles[] = { 50, 90, 99, 99.9, 99.99 };
+  printf("  mean %.1fus  ", latencies.mean() / 1000);
+  for (double p : percentiles)
+  {
+    printf("p%g %.1fus  ", p, static_cast<double>(latencies.percentile(p)) / 1000);
+  }
+  printf("max %.1fus\n", static_cast<double>(latencies.max()) / 1000);
+}
+
+void run(int busyPollMicroSeconds, int roundTrips, int messageSize)
+{
+  EventLoop loop;  // the client loop, also the acceptor loop
+  loop.setBusyPoll(busyPollMicroSeconds);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "LatencyServer");
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.setThreadNum(1);
+  server.setBusyPoll(busyPollMicroSeconds);
+  server.start();
+
+  LatencyClient client(&loop, serverAddr, roundTrips, messageSize);
+  client.connect();
+  loop.loop();
+
+  printf("busy poll %dus: %d round trips of %d bytes\n",
+         busyPollMicroSeconds, roundTrips, messageSize);
+  if (client.latencies().count() > 0)
+  {
+    printHistogram(client.latencies());
+  }
+  printPollStats("client", loop.pollStats());
+  printPollStats("server", server.threadPool()->getAllLoops()[0]->pollStats());
+}
+
+int main(int argc, char* argv[])
+{
+  Logger::setLogLevel(Logger::WARN);
+  int roundTrips = argc > 2 ? atoi(argv[2]) : 50000;
+  int messageSize = argc > 3 ? atoi(argv[3]) : 64;
+  if (argc > 1)
+  {
+    run(atoi(argv[1]), roundTrips, messageSize);
+  }
+  else
+  {
+    run(0, roundTrips, messageSize);
+    run(50, roundTrips, messageSize);
+  }
+}
@@ -0,0 +1,29 @@
+#!/bin/sh
+
+# Compares pingpong throughput of poll(2), epoll(4) and io_uring(7) backends.
+# Usage: pollers.sh [bin_dir] [threads] [blocksize] [sessions] [seconds]
+
+BIN=${1:-../../../build/release-cpp11/bin}
+THREADS=${2:-1}
+BLOCKSIZE=${3:-16384}
+SESSIONS=${4:-100}
+TIME=${5:-10}
+PORT=33333
+
+run()
+{
+  echo "==== $1"
+  env $2 $BIN/pingpong_server 0.0.0.0 $PORT $THREADS > /dev/null 2>&1 &
+  SERVER=$!
+  sleep 1
+  env $2 $BIN/pingpong_client 127.0.0.1 $PORT $THREADS $BLOCKSIZE $SESSIONS $TIME 2>&1 \
+    | grep 'throughput'
+  kill $SERVER
+  wait $SERVER 2> /dev/null
+  PORT=$((PORT+1))
+}
+
+# the variables read by Poller::newDefaultPoller(), epoll(4) if none
+run poll MUDUO_USE_POLL=1
+run epoll
+run io_uring MUDUO_USE_IOURING=1
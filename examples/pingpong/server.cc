@@ -9,6 +9,7 @@
 #include <utility>
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -40,7 +41,9 @@ int main(int argc, char* argv[])
 
     const char* ip = argv[1];
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
-    InetAddress listenAddr(ip, port);
+    // "unix:/path" or "unix:@name" for a Unix domain socket, port is ignored
+    InetAddress listenAddr = strncmp(ip, "unix:", 5) == 0 ?
+        InetAddress::unixDomain(ip + 5) : InetAddress(ip, port);
     int threadCount = atoi(argv[3]);
 
     EventLoop loop;
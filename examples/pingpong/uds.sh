@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# Compares pingpong throughput of loopback TCP and Unix domain sockets.
+# Usage: uds.sh [bin_dir] [threads] [blocksize] [sessions] [seconds]
+
+BIN=${1:-../../../build/release-cpp11/bin}
+THREADS=${2:-1}
+BLOCKSIZE=${3:-16384}
+SESSIONS=${4:-100}
+TIME=${5:-10}
+PORT=33333
+
+if [ ! -x $BIN/pingpong_server ] || [ ! -x $BIN/pingpong_client ]; then
+  echo "no pingpong_server or pingpong_client in $BIN" >&2
+  exit 1
+fi
+
+run()
+{
+  echo "==== $1"
+  $BIN/pingpong_server $2 $PORT $THREADS > /dev/null 2>&1 &
+  SERVER=$!
+  sleep 1
+  $BIN/pingpong_client $3 $PORT $THREADS $BLOCKSIZE $SESSIONS $TIME 2>&1 \
+    | grep 'throughput'
+  kill $SERVER
+  wait $SERVER 2> /dev/null
+  PORT=$((PORT+1))
+}
+
+run "loopback TCP" 0.0.0.0 127.0.0.1
+run "Unix domain socket" unix:/tmp/pingpong.sock unix:/tmp/pingpong.sock
+run "abstract Unix domain socket" unix:@pingpong unix:@pingpong
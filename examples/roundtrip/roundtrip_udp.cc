@@ -1,131 +1,96 @@
 #include "muduo/base/Logging.h"
-#include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
-#include "muduo/net/Socket.h"
-#include "muduo/net/SocketsOps.h"
-#include "muduo/net/TcpClient.h"
-#include "muduo/net/TcpServer.h"
+#include "muduo/net/UdpSocket.h"
 
 #include <stdio.h>
+#include <string.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
 const size_t frameLen = 2*sizeof(int64_t);
 
-int createNonblockingUDP()
-{
-  int sockfd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
-  if (sockfd < 0)
-  {
-    LOG_SYSFATAL << "::socket";
-  }
-  return sockfd;
-}
-
 /////////////////////////////// Server ///////////////////////////////
 
-void serverReadCallback(int sockfd, muduo::Timestamp receiveTime)
+void serverMessageCallback(UdpSocket* socket,
+                           const std::vector<UdpDatagram>& datagrams,
+                           muduo::Timestamp receiveTime)
 {
-  int64_t message[2];
-  struct sockaddr peerAddr;
-  memZero(&peerAddr, sizeof peerAddr);
-  socklen_t addrLen = sizeof peerAddr;
-  ssize_t nr = ::recvfrom(sockfd, message, sizeof message, 0, &peerAddr, &addrLen);
-
-  char addrStr[64];
-  sockets::toIpPort(addrStr, sizeof addrStr, &peerAddr);
-  LOG_DEBUG << "received " << nr << " bytes from " << addrStr;
-
-  if (nr < 0)
-  {
-    LOG_SYSERR << "::recvfrom";
-  }
-  else if (implicit_cast<size_t>(nr) == frameLen)
+  for (const UdpDatagram& datagram : datagrams)
   {
-    message[1] = receiveTime.microSecondsSinceEpoch();
-    ssize_t nw = ::sendto(sockfd, message, sizeof message, 0, &peerAddr, addrLen);
-    if (nw < 0)
+    LOG_DEBUG << "received " << datagram.size << " bytes from "
+              << datagram.peer.toIpPort();
+    if (datagram.size == frameLen)
     {
-      LOG_SYSERR << "::sendto";
+      int64_t message[2];
+      memcpy(message, datagram.data, sizeof message);
+      message[1] = receiveTime.microSecondsSinceEpoch();
+      socket->sendTo(message, sizeof message, datagram.peer);
     }
-    else if (implicit_cast<size_t>(nw) != frameLen)
+    else
     {
-      LOG_ERROR << "Expect " << frameLen << " bytes, wrote " << nw << " bytes.";
+      LOG_ERROR << "Expect " << frameLen << " bytes, received " << datagram.size << " bytes.";
     }
   }
-  else
-  {
-    LOG_ERROR << "Expect " << frameLen << " bytes, received " << nr << " bytes.";
-  }
 }
 
 void runServer(uint16_t port)
 {
-  Socket sock(createNonblockingUDP());
-  sock.bindAddress(InetAddress(port));
   EventLoop loop;
-  Channel channel(&loop, sock.fd());
-  channel.setReadCallback(std::bind(&serverReadCallback, sock.fd(), _1));
-  channel.enableReading();
+  UdpSocket socket(&loop);
+  if (!socket.bind(InetAddress(port)))
+  {
+    return;
+  }
+  socket.setMessageCallback(serverMessageCallback);
+  socket.startReading();
   loop.loop();
 }
 
 /////////////////////////////// Client ///////////////////////////////
 
-void clientReadCallback(int sockfd, muduo::Timestamp receiveTime)
+void clientMessageCallback(UdpSocket*,
+                           const std::vector<UdpDatagram>& datagrams,
+                           muduo::Timestamp receiveTime)
 {
-  int64_t message[2];
-  ssize_t nr = sockets::read(sockfd, message, sizeof message);
-
-  if (nr < 0)
+  for (const UdpDatagram& datagram : datagrams)
   {
-    LOG_SYSERR << "::read";
-  }
-  else if (implicit_cast<size_t>(nr) == frameLen)
-  {
-    int64_t send = message[0];
-    int64_t their = message[1];
-    int64_t back = receiveTime.microSecondsSinceEpoch();
-    int64_t mine = (back+send)/2;
-    LOG_INFO << "round trip " << back - send
-             << " clock error " << their - mine;
-  }
-  else
-  {
-    LOG_ERROR << "Expect " << frameLen << " bytes, received " << nr << " bytes.";
+    if (datagram.size == frameLen)
+    {
+      int64_t message[2];
+      memcpy(message, datagram.data, sizeof message);
+      int64_t send = message[0];
+      int64_t their = message[1];
+      int64_t back = receiveTime.microSecondsSinceEpoch();
+      int64_t mine = (back+send)/2;
+      LOG_INFO << "round trip " << back - send
+               << " clock error " << their - mine;
+    }
+    else
+    {
+      LOG_ERROR << "Expect " << frameLen << " bytes, received " << datagram.size << " bytes.";
+    }
   }
 }
 
-void sendMyTime(int sockfd)
+void sendMyTime(UdpSocket* socket)
 {
   int64_t message[2] = { 0, 0 };
   message[0] = Timestamp::now().microSecondsSinceEpoch();
-  ssize_t nw = sockets::write(sockfd, message, sizeof message);
-  if (nw < 0)
-  {
-    LOG_SYSERR << "::write";
-  }
-  else if (implicit_cast<size_t>(nw) != frameLen)
-  {
-    LOG_ERROR << "Expect " << frameLen << " bytes, wrote " << nw << " bytes.";
-  }
+  socket->send(message, sizeof message);
 }
 
 void runClient(const char* ip, uint16_t port)
 {
-  Socket sock(createNonblockingUDP());
-  InetAddress serverAddr(ip, port);
-  int ret = sockets::connect(sock.fd(), serverAddr.getSockAddr());
-  if (ret < 0)
+  EventLoop loop;
+  UdpSocket socket(&loop);
+  if (!socket.connect(InetAddress(ip, port)))
   {
-    LOG_SYSFATAL << "::connect";
+    return;
   }
-  EventLoop loop;
-  Channel channel(&loop, sock.fd());
-  channel.setReadCallback(std::bind(&clientReadCallback, sock.fd(), _1));
-  channel.enableReading();
-  loop.runEvery(0.2, std::bind(sendMyTime, sock.fd()));
+  socket.setMessageCallback(clientMessageCallback);
+  socket.startReading();
+  loop.runEvery(0.2, std::bind(sendMyTime, &socket));
   loop.loop();
 }
 
@@ -1,6 +1,9 @@
 #include "examples/socks4a/tunnel.h"
 
 #include "muduo/base/ThreadLocal.h"
+
+#include <map>
+
 #include <stdio.h>
 
 using namespace muduo;
@@ -1,6 +1,9 @@
 #include "examples/socks4a/tunnel.h"
 
 #include "muduo/net/Endian.h"
+
+#include <map>
+
 #include <stdio.h>
 #include <netdb.h>
 #include <unistd.h>
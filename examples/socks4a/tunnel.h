@@ -36,10 +36,6 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
         std::bind(&Tunnel::onClientConnection, shared_from_this(), _1));
     client_.setMessageCallback(
         std::bind(&Tunnel::onClientMessage, shared_from_this(), _1, _2, _3));
-    serverConn_->setHighWaterMarkCallback(
-        std::bind(&Tunnel::onHighWaterMarkWeak,
-                  std::weak_ptr<Tunnel>(shared_from_this()), kServer, _1, _2),
-        1024*1024);
   }
 
   void connect()
@@ -54,6 +50,9 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
   }
 
  private:
+  static const size_t kHighWaterMark = 1024*1024;
+  static const size_t kLowWaterMark = 256*1024;
+
   void teardown()
   {
     client_.setConnectionCallback(muduo::net::defaultConnectionCallback);
@@ -68,17 +67,13 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
 
   void onClientConnection(const muduo::net::TcpConnectionPtr& conn)
   {
-    using std::placeholders::_1;
-    using std::placeholders::_2;
-
     LOG_DEBUG << (conn->connected() ? "UP" : "DOWN");
     if (conn->connected())
     {
       conn->setTcpNoDelay(true);
-      conn->setHighWaterMarkCallback(
-          std::bind(&Tunnel::onHighWaterMarkWeak,
-                    std::weak_ptr<Tunnel>(shared_from_this()), kClient, _1, _2),
-          1024*1024);
+      // either side stops reading while the other can't keep up
+      conn->setFlowControl(kHighWaterMark, kLowWaterMark, serverConn_);
+      serverConn_->setFlowControl(kHighWaterMark, kLowWaterMark, conn);
       serverConn_->setContext(conn);
       serverConn_->startRead();
       clientConn_ = conn;
@@ -109,83 +104,6 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
     }
   }
 
-  enum ServerClient
-  {
-    kServer, kClient
-  };
-
-  void onHighWaterMark(ServerClient which,
-                       const muduo::net::TcpConnectionPtr& conn,
-                       size_t bytesToSent)
-  {
-    using std::placeholders::_1;
-
-    LOG_INFO << (which == kServer ? "server" : "client")
-             << " onHighWaterMark " << conn->name()
-             << " bytes " << bytesToSent;
-
-    if (which == kServer)
-    {
-      if (serverConn_->outputBuffer()->readableBytes() > 0)
-      {
-        clientConn_->stopRead();
-        serverConn_->setWriteCompleteCallback(
-            std::bind(&Tunnel::onWriteCompleteWeak,
-                      std::weak_ptr<Tunnel>(shared_from_this()), kServer, _1));
-      }
-    }
-    else
-    {
-      if (clientConn_->outputBuffer()->readableBytes() > 0)
-      {
-        serverConn_->stopRead();
-        clientConn_->setWriteCompleteCallback(
-            std::bind(&Tunnel::onWriteCompleteWeak,
-                      std::weak_ptr<Tunnel>(shared_from_this()), kClient, _1));
-      }
-    }
-  }
-
-  static void onHighWaterMarkWeak(const std::weak_ptr<Tunnel>& wkTunnel,
-                                  ServerClient which,
-                                  const muduo::net::TcpConnectionPtr& conn,
-                                  size_t bytesToSent)
-  {
-    std::shared_ptr<Tunnel> tunnel = wkTunnel.lock();
-    if (tunnel)
-    {
-      tunnel->onHighWaterMark(which, conn, bytesToSent);
-    }
-  }
-
-  void onWriteComplete(ServerClient which, const muduo::net::TcpConnectionPtr& conn)
-  {
-    LOG_INFO << (which == kServer ? "server" : "client")
-             << " onWriteComplete " << conn->name();
-    if (which == kServer)
-    {
-      clientConn_->startRead();
-      serverConn_->setWriteCompleteCallback(muduo::net::WriteCompleteCallback());
-    }
-    else
-    {
-      serverConn_->startRead();
-      clientConn_->setWriteCompleteCallback(muduo::net::WriteCompleteCallback());
-    }
-  }
-
-  static void onWriteCompleteWeak(const std::weak_ptr<Tunnel>& wkTunnel,
-                                  ServerClient which,
-                                  const muduo::net::TcpConnectionPtr& conn)
-  {
-    std::shared_ptr<Tunnel> tunnel = wkTunnel.lock();
-    if (tunnel)
-    {
-      tunnel->onWriteComplete(which, conn);
-    }
-  }
-
- private:
   muduo::net::TcpClient client_;
   muduo::net::TcpConnectionPtr serverConn_;
   muduo::net::TcpConnectionPtr clientConn_;
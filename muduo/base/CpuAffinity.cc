@@ -0,0 +1,178 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/base/CpuAffinity.h"
+
+#include "muduo/base/FileUtil.h"
+#include "muduo/base/Logging.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+
+namespace
+{
+
+std::vector<int> allowedCpus()
+{
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof set, &set) == 0)
+  {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &set))
+      {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+}  // namespace
+
+std::vector<int> CpuAffinity::parseCpuList(StringArg list)
+{
+  std::vector<int> cpus;
+  const char* p = list.c_str();
+  while (*p)
+  {
+    char* end = NULL;
+    long first = ::strtol(p, &end, 10);
+    if (end == p)
+    {
+      break;
+    }
+    long last = first;
+    p = end;
+    if (*p == '-')
+    {
+      last = ::strtol(p+1, &end, 10);
+      p = end;
+    }
+    for (long cpu = first; cpu <= last; ++cpu)
+    {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+    while (*p == ',' || *p == '\n' || *p == ' ')
+    {
+      ++p;
+    }
+  }
+  return cpus;
+}
+
+std::vector<std::vector<int>> CpuAffinity::numaNodes()
+{
+  std::vector<int> allowed = allowedCpus();
+  std::vector<std::vector<int>> nodes;
+  for (int node = 0; ; ++node)
+  {
+    char filename[64];
+    snprintf(filename, sizeof filename, "/sys/devices/system/node/node%d/cpulist", node);
+    string content;
+    if (FileUtil::readFile(filename, 4096, &content) != 0)
+    {
+      break;
+    }
+    std::vector<int> cpus;
+    for (int cpu : parseCpuList(content))
+    {
+      if (std::binary_search(allowed.begin(), allowed.end(), cpu))
+      {
+        cpus.push_back(cpu);
+      }
+    }
+    nodes.push_back(cpus);
+  }
+  if (nodes.empty())
+  {
+    // no NUMA, or no sysfs
+    nodes.push_back(allowed);
+  }
+  return nodes;
+}
+
+int CpuAffinity::numaNodeOf(int cpu)
+{
+  std::vector<std::vector<int>> nodes = numaNodes();
+  for (size_t node = 0; node < nodes.size(); ++node)
+  {
+    if (std::find(nodes[node].begin(), nodes[node].end(), cpu) != nodes[node].end())
+    {
+      return static_cast<int>(node);
+    }
+  }
+  return -1;
+}
+
+CpuAffinity CpuAffinity::spread()
+{
+  std::vector<std::vector<int>> nodes = numaNodes();
+  std::vector<int> cpus;
+  for (size_t i = 0; ; ++i)
+  {
+    bool more = false;
+    for (const auto& node : nodes)
+    {
+      if (i < node.size())
+      {
+        cpus.push_back(node[i]);
+        more = true;
+      }
+    }
+    if (!more)
+    {
+      break;
+    }
+  }
+  return CpuAffinity(cpus);
+}
+
+CpuAffinity CpuAffinity::compact()
+{
+  std::vector<int> cpus;
+  for (const auto& node : numaNodes())
+  {
+    cpus.insert(cpus.end(), node.begin(), node.end());
+  }
+  return CpuAffinity(cpus);
+}
+
+CpuAffinity CpuAffinity::onNode(int node)
+{
+  std::vector<std::vector<int>> nodes = numaNodes();
+  if (node < 0 || static_cast<size_t>(node) >= nodes.size() || nodes[node].empty())
+  {
+    LOG_ERROR << "CpuAffinity::onNode no CPU of NUMA node " << node;
+    return CpuAffinity();
+  }
+  return CpuAffinity(nodes[node]);
+}
+
+bool CurrentThread::setCpuAffinity(int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+  if (ret != 0)
+  {
+    errno = ret;
+    LOG_SYSERR << "CurrentThread::setCpuAffinity " << cpu;
+  }
+  return ret == 0;
+}
+
+int CurrentThread::cpu()
+{
+  return ::sched_getcpu();
+}
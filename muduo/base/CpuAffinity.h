@@ -0,0 +1,70 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef MUDUO_BASE_CPUAFFINITY_H
+#define MUDUO_BASE_CPUAFFINITY_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+
+#include <vector>
+
+namespace muduo
+{
+
+///
+/// Placement of the threads of a pool on CPUs.
+///
+/// Thread i of a pool runs on cpus()[i % cpus().size()], or anywhere if empty.
+/// Memory is allocated on the NUMA node of the CPU touching it first by default,
+/// so per-thread data created after pinning, eg. EventLoop and its buffers,
+/// stays on the node of the thread.
+class CpuAffinity : public muduo::copyable
+{
+ public:
+  /// Not pinned.
+  CpuAffinity() {}
+
+  /// Pinned to the CPUs in this order.
+  explicit CpuAffinity(const std::vector<int>& cpus)
+    : cpus_(cpus)
+  { }
+
+  /// Thread i goes to NUMA node i % nodes, to use memory channels of all nodes.
+  static CpuAffinity spread();
+  /// Threads fill up a NUMA node before the next one, to share caches.
+  static CpuAffinity compact();
+  /// Threads go to the CPUs of NUMA @c node only, eg. the node of the NIC.
+  static CpuAffinity onNode(int node);
+
+  bool pinned() const { return !cpus_.empty(); }
+  const std::vector<int>& cpus() const { return cpus_; }
+
+  /// CPU of thread @c index, -1 if not pinned.
+  int cpuOf(int index) const
+  { return cpus_.empty() ? -1 : cpus_[static_cast<size_t>(index) % cpus_.size()]; }
+
+  /// "0-3,8,10-11" to CPU numbers.
+  static std::vector<int> parseCpuList(StringArg list);
+
+  /// CPUs this process may run on, grouped by NUMA node.
+  static std::vector<std::vector<int>> numaNodes();
+  /// -1 if unknown.
+  static int numaNodeOf(int cpu);
+
+ private:
+  std::vector<int> cpus_;
+};
+
+namespace CurrentThread
+{
+  /// @return false if failed.
+  bool setCpuAffinity(int cpu);
+  /// The CPU running this thread right now.
+  int cpu();
+}  // namespace CurrentThread
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_CPUAFFINITY_H
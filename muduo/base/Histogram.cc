@@ -0,0 +1,65 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Histogram.h"
+
+#include <algorithm>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace muduo;
+
+void Histogram::merge(const Histogram& rhs)
+{
+  for (int i = 0; i < kBuckets; ++i)
+  {
+    counts_[i] += rhs.counts_[i];
+  }
+  count_ += rhs.count_;
+  sum_ += rhs.sum_;
+  max_ = std::max(max_, rhs.max_);
+}
+
+void Histogram::reset()
+{
+  memset(counts_, 0, sizeof counts_);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+int64_t Histogram::percentile(double p) const
+{
+  if (count_ == 0)
+  {
+    return 0;
+  }
+  const double rank = p / 100.0 * static_cast<double>(count_);
+  int64_t seen = 0;
+  for (int i = 0; i < kBuckets; ++i)
+  {
+    seen += counts_[i];
+    if (seen > 0 && static_cast<double>(seen) >= rank)
+    {
+      int64_t upper = i == 0 ? 0 : (static_cast<int64_t>(1) << i) - 1;
+      return std::min(upper, max_);
+    }
+  }
+  return max_;
+}
+
+string Histogram::toString() const
+{
+  char buf[256];
+  snprintf(buf, sizeof buf,
+           "count %" PRId64 " mean %.1f p50 %" PRId64 " p90 %" PRId64
+           " p99 %" PRId64 " max %" PRId64,
+           count_, mean(), percentile(50), percentile(90), percentile(99), max_);
+  return buf;
+}
@@ -0,0 +1,74 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef MUDUO_BASE_HISTOGRAM_H
+#define MUDUO_BASE_HISTOGRAM_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/Types.h"
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Counts of non-negative values in power-of-two buckets,
+/// bucket 0 for 0, bucket i for [2^(i-1), 2^i).
+///
+/// Fixed size and O(1) to add, cheap enough for hot paths.
+/// Not thread safe, keep one per thread and merge them.
+class Histogram : public muduo::copyable
+{
+ public:
+  static const int kBuckets = 48;
+
+  Histogram() { reset(); }
+
+  void add(int64_t value)
+  {
+    if (value < 0)
+    {
+      value = 0;
+    }
+    ++counts_[bucketOf(value)];
+    ++count_;
+    sum_ += value;
+    if (value > max_)
+    {
+      max_ = value;
+    }
+  }
+
+  void merge(const Histogram& rhs);
+  void reset();
+
+  int64_t count() const { return count_; }
+  int64_t sum() const { return sum_; }
+  int64_t max() const { return max_; }
+  double mean() const
+  { return count_ > 0 ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+  /// Upper bound of the bucket of the @c p th percentile, at most max().
+  /// 0 <= p <= 100.
+  int64_t percentile(double p) const;
+
+  /// count, mean, p50, p90, p99 and max in one line.
+  string toString() const;
+
+  static int bucketOf(int64_t value)
+  {
+    int bucket = value == 0 ? 0 : 64 - __builtin_clzll(static_cast<uint64_t>(value));
+    return bucket < kBuckets ? bucket : kBuckets - 1;
+  }
+
+ private:
+  int64_t counts_[kBuckets];
+  int64_t count_;
+  int64_t sum_;
+  int64_t max_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_HISTOGRAM_H
@@ -4,6 +4,7 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include "muduo/base/Thread.h"
+#include "muduo/base/CpuAffinity.h"
 #include "muduo/base/CurrentThread.h"
 #include "muduo/base/Exception.h"
 #include "muduo/base/Logging.h"
@@ -56,19 +57,27 @@ struct ThreadData
   string name_;
   pid_t* tid_;
   CountDownLatch* latch_;
+  int cpu_;
 
   ThreadData(ThreadFunc func,
              const string& name,
              pid_t* tid,
-             CountDownLatch* latch)
+             CountDownLatch* latch,
+             int cpu)
     : func_(std::move(func)),
       name_(name),
       tid_(tid),
-      latch_(latch)
+      latch_(latch),
+      cpu_(cpu)
   { }
 
   void runInThread()
   {
+    if (cpu_ >= 0)
+    {
+      // before func_ allocates anything, which goes to the NUMA node of cpu_
+      CurrentThread::setCpuAffinity(cpu_);
+    }
     *tid_ = muduo::CurrentThread::tid();
     tid_ = NULL;
     latch_->countDown();
@@ -144,6 +153,7 @@ Thread::Thread(ThreadFunc func, const string& n)
     joined_(false),
     pthreadId_(0),
     tid_(0),
+    cpu_(-1),
     func_(std::move(func)),
     name_(n),
     latch_(1)
@@ -175,7 +185,7 @@ void Thread::start()
   assert(!started_);
   started_ = true;
   // FIXME: move(func_)
-  detail::ThreadData* data = new detail::ThreadData(func_, name_, &tid_, &latch_);
+  detail::ThreadData* data = new detail::ThreadData(func_, name_, &tid_, &latch_, cpu_);
   if (pthread_create(&pthreadId_, NULL, &detail::startThread, data))
   {
     started_ = false;
@@ -26,6 +26,11 @@ class Thread : noncopyable
   // FIXME: make it movable in C++11
   ~Thread();
 
+  /// Pins the thread to @c cpu, before running the ThreadFunc.
+  /// Must be called before start().
+  void setCpu(int cpu) { cpu_ = cpu; }
+  int cpu() const { return cpu_; }
+
   void start();
   int join(); // return pthread_join()
 
@@ -43,6 +48,7 @@ class Thread : noncopyable
   bool       joined_;
   pthread_t  pthreadId_;
   pid_t      tid_;
+  int        cpu_;  // -1 for not pinned
   ThreadFunc func_;
   string     name_;
   CountDownLatch latch_;
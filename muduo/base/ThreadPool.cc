@@ -30,7 +30,7 @@ ThreadPool::~ThreadPool()
   }
 }
 
-void ThreadPool::start(int numThreads)
+void ThreadPool::start(int numThreads, const CpuAffinity& affinity)
 {
   assert(threads_.empty());
   running_ = true;
@@ -41,6 +41,7 @@ void ThreadPool::start(int numThreads)
     snprintf(id, sizeof id, "%d", i+1);
     threads_.emplace_back(new muduo::Thread(
           std::bind(&ThreadPool::runInThread, this), name_+id));
+    threads_[i]->setCpu(affinity.cpuOf(i));
     threads_[i]->start();
   }
   if (numThreads == 0 && threadInitCallback_)
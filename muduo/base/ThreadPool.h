@@ -7,6 +7,7 @@
 #define MUDUO_BASE_THREADPOOL_H
 
 #include "muduo/base/Condition.h"
+#include "muduo/base/CpuAffinity.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Thread.h"
 #include "muduo/base/Types.h"
@@ -30,7 +31,8 @@ class ThreadPool : noncopyable
   void setThreadInitCallback(const Task& cb)
   { threadInitCallback_ = cb; }
 
-  void start(int numThreads);
+  /// Thread i runs on affinity.cpuOf(i), if pinned.
+  void start(int numThreads, const CpuAffinity& affinity = CpuAffinity());
   void stop();
 
   const string& name() const
@@ -0,0 +1,46 @@
+#include "muduo/base/CpuAffinity.h"
+#include "muduo/base/Thread.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+void checkCpu(int cpu)
+{
+  printf("tid=%d cpu=%d node=%d\n",
+         CurrentThread::tid(), CurrentThread::cpu(), CpuAffinity::numaNodeOf(cpu));
+  assert(CurrentThread::cpu() == cpu);
+}
+
+int main()
+{
+  std::vector<int> cpus = CpuAffinity::parseCpuList("0-3,8,10-11\n");
+  assert(cpus.size() == 7);
+  assert(cpus[0] == 0 && cpus[3] == 3 && cpus[4] == 8 && cpus[6] == 11);
+  assert(CpuAffinity::parseCpuList("").empty());
+
+  CpuAffinity none;
+  assert(!none.pinned());
+  assert(none.cpuOf(0) == -1);
+
+  CpuAffinity two(CpuAffinity::parseCpuList("5,7"));
+  assert(two.cpuOf(0) == 5 && two.cpuOf(1) == 7 && two.cpuOf(2) == 5);
+
+  std::vector<std::vector<int>> nodes = CpuAffinity::numaNodes();
+  assert(!nodes.empty());
+  size_t total = 0;
+  for (const auto& node : nodes)
+  {
+    total += node.size();
+  }
+  assert(CpuAffinity::spread().cpus().size() == total);
+  assert(CpuAffinity::compact().cpus().size() == total);
+  printf("%zd NUMA nodes, %zd CPUs\n", nodes.size(), total);
+
+  int last = CpuAffinity::compact().cpus().back();
+  Thread t(std::bind(checkCpu, last), "pinned");
+  t.setCpu(last);
+  t.start();
+  t.join();
+}
@@ -0,0 +1,40 @@
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Histogram.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::Histogram;
+
+int main()
+{
+  assert(Histogram::bucketOf(0) == 0);
+  assert(Histogram::bucketOf(1) == 1);
+  assert(Histogram::bucketOf(2) == 2);
+  assert(Histogram::bucketOf(3) == 2);
+  assert(Histogram::bucketOf(4) == 3);
+  assert(Histogram::bucketOf(INT64_MAX) == Histogram::kBuckets - 1);
+
+  Histogram h;
+  assert(h.count() == 0 && h.percentile(99) == 0);
+  for (int i = 0; i < 100; ++i)
+  {
+    h.add(i < 90 ? 10 : 1000);
+  }
+  h.add(-5);  // as 0
+  assert(h.count() == 101);
+  assert(h.sum() == 90 * 10 + 10 * 1000);
+  assert(h.max() == 1000);
+  assert(h.percentile(0) == 0);
+  assert(h.percentile(50) == 15);    // [8, 16)
+  assert(h.percentile(99) == 1000);  // [512, 1024), capped by max
+  printf("%s\n", h.toString().c_str());
+
+  Histogram other;
+  other.add(100000);
+  h.merge(other);
+  assert(h.count() == 102 && h.max() == 100000);
+  h.reset();
+  assert(h.count() == 0 && h.sum() == 0 && h.max() == 0);
+}
@@ -16,22 +16,70 @@
 #include <errno.h>
 #include <fcntl.h>
 //#include <sys/types.h>
-//#include <sys/stat.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+const int Acceptor::kDefaultAcceptBatch;
+
+namespace
+{
+
+// a socket file nobody listens on, left by a previous run which crashed
+bool isStaleSocketFile(const InetAddress& addr)
+{
+  const struct sockaddr_un* un =
+      static_cast<const struct sockaddr_un*>(implicit_cast<const void*>(addr.getSockAddr()));
+  struct stat st;
+  if (::stat(un->sun_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+  {
+    return false;
+  }
+  // a live server accepts, or refuses with EAGAIN when its backlog is full
+  int sockfd = sockets::createNonblockingOrDie(AF_UNIX);
+  int ret = sockets::connect(sockfd, addr.getSockAddr(), addr.getSockAddrLength());
+  int savedErrno = (ret == 0) ? 0 : errno;
+  sockets::close(sockfd);
+  return savedErrno == ECONNREFUSED;
+}
+
+}  // namespace
+
 Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
   : loop_(loop),
     acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
     acceptChannel_(loop, acceptSocket_.fd()),
     listenning_(false),
-    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+    acceptBatch_(kDefaultAcceptBatch),
+    accepted_(0),
+    shed_(0),
+    batches_(0),
+    maxBatch_(0)
 {
   assert(idleFd_ >= 0);
-  acceptSocket_.setReuseAddr(true);
-  acceptSocket_.setReusePort(reuseport);
+  if (listenAddr.isUnixDomain())
+  {
+    const struct sockaddr_un* addr =
+        static_cast<const struct sockaddr_un*>(implicit_cast<const void*>(listenAddr.getSockAddr()));
+    if (addr->sun_path[0] != '\0')
+    {
+      // a stale socket file fails bind(2) with EADDRINUSE, as does a live one
+      unixPath_ = addr->sun_path;
+      if (isStaleSocketFile(listenAddr))
+      {
+        ::unlink(addr->sun_path);
+      }
+    }
+  }
+  else
+  {
+    acceptSocket_.setReuseAddr(true);
+    acceptSocket_.setReusePort(reuseport);
+  }
   acceptSocket_.bindAddress(listenAddr);
   acceptChannel_.setReadCallback(
       std::bind(&Acceptor::handleRead, this));
@@ -42,6 +90,10 @@ Acceptor::~Acceptor()
   acceptChannel_.disableAll();
   acceptChannel_.remove();
   ::close(idleFd_);
+  if (!unixPath_.empty())
+  {
+    ::unlink(unixPath_.c_str());
+  }
 }
 
 void Acceptor::listen()
@@ -55,35 +107,66 @@ void Acceptor::listen()
 void Acceptor::handleRead()
 {
   loop_->assertInLoopThread();
-  InetAddress peerAddr;
-  //FIXME loop until no more
-  int connfd = acceptSocket_.accept(&peerAddr);
-  if (connfd >= 0)
+  int accepted = 0;
+  int shed = 0;
+  for (int i = 0; i < acceptBatch_; ++i)
   {
-    // string hostport = peerAddr.toIpPort();
-    // LOG_TRACE << "Accepts of " << hostport;
-    if (newConnectionCallback_)
+    InetAddress peerAddr;
+    int connfd = acceptSocket_.accept(&peerAddr);
+    if (connfd >= 0)
     {
-      newConnectionCallback_(connfd, peerAddr);
+      // string hostport = peerAddr.toIpPort();
+      // LOG_TRACE << "Accepts of " << hostport;
+      if (newConnectionCallback_)
+      {
+        ++accepted;
+        newConnectionCallback_(connfd, peerAddr);
+      }
+      else
+      {
+        ++shed;
+        sockets::close(connfd);
+      }
+    }
+    else if (errno == EAGAIN)
+    {
+      // drained
+      break;
     }
     else
     {
-      sockets::close(connfd);
+      int savedErrno = errno;
+      LOG_SYSERR << "in Acceptor::handleRead";
+      // Read the section named "The special problem of
+      // accept()ing when you can't" in libev's doc.
+      // By Marc Lehmann, author of libev.
+      if (savedErrno == EMFILE)
+      {
+        ::close(idleFd_);
+        idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
+        if (idleFd_ >= 0)
+        {
+          ++shed;
+        }
+        ::close(idleFd_);
+        idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+      }
+      // otherwise, the error is of this connection, goes on with the next one
     }
   }
-  else
+
+  if (accepted + shed > 0)
   {
-    LOG_SYSERR << "in Acceptor::handleRead";
-    // Read the section named "The special problem of
-    // accept()ing when you can't" in libev's doc.
-    // By Marc Lehmann, author of libev.
-    if (errno == EMFILE)
+    // written in loop thread only
+    accepted_.store(accepted_.load(std::memory_order_relaxed) + accepted,
+                    std::memory_order_relaxed);
+    shed_.store(shed_.load(std::memory_order_relaxed) + shed,
+                std::memory_order_relaxed);
+    batches_.store(batches_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    if (accepted + shed > maxBatch_.load(std::memory_order_relaxed))
     {
-      ::close(idleFd_);
-      idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
-      ::close(idleFd_);
-      idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+      maxBatch_.store(accepted + shed, std::memory_order_relaxed);
     }
   }
 }
-
@@ -11,6 +11,7 @@
 #ifndef MUDUO_NET_ACCEPTOR_H
 #define MUDUO_NET_ACCEPTOR_H
 
+#include <atomic>
 #include <functional>
 
 #include "muduo/net/Channel.h"
@@ -25,12 +26,13 @@ class EventLoop;
 class InetAddress;
 
 ///
-/// Acceptor of incoming TCP connections.
+/// Acceptor of incoming TCP or Unix domain stream connections.
 ///
 class Acceptor : noncopyable
 {
  public:
   typedef std::function<void (int sockfd, const InetAddress&)> NewConnectionCallback;
+  static const int kDefaultAcceptBatch = 64;
 
   Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport);
   ~Acceptor();
@@ -38,9 +40,28 @@ class Acceptor : noncopyable
   void setNewConnectionCallback(const NewConnectionCallback& cb)
   { newConnectionCallback_ = cb; }
 
+  EventLoop* getLoop() const { return loop_; }
   bool listenning() const { return listenning_; }
   void listen();
 
+  /// Accepts at most @c batch connections per readable event,
+  /// until EAGAIN, so that the backlog drains during connect storms.
+  void setAcceptBatch(int batch)
+  { acceptBatch_ = batch; }
+
+  /// Thread safe.
+  int64_t numAccepted() const { return accepted_.load(std::memory_order_relaxed); }
+  /// Closed right away, because of EMFILE, or no callback.  Thread safe.
+  int64_t numShed() const { return shed_.load(std::memory_order_relaxed); }
+  /// Readable events which accepted or shed any.  Thread safe.
+  int64_t numBatches() const { return batches_.load(std::memory_order_relaxed); }
+  /// Of the largest batch.  Thread safe.
+  int64_t maxBatch() const { return maxBatch_.load(std::memory_order_relaxed); }
+
+  /// see Socket::setReusePortCpuSteering()
+  bool setCpuSteering(int numAcceptors)
+  { return acceptSocket_.setReusePortCpuSteering(numAcceptors); }
+
  private:
   void handleRead();
 
@@ -50,6 +71,12 @@ class Acceptor : noncopyable
   NewConnectionCallback newConnectionCallback_;
   bool listenning_;
   int idleFd_;
+  string unixPath_;  // socket file to remove
+  int acceptBatch_;
+  std::atomic<int64_t> accepted_;
+  std::atomic<int64_t> shed_;
+  std::atomic<int64_t> batches_;
+  std::atomic<int64_t> maxBatch_;
 };
 
 }  // namespace net
@@ -0,0 +1,39 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/Broadcast.h"
+
+#include "muduo/net/EventLoop.h"
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void sendAll(const std::vector<TcpConnectionPtr>& connections, const Slice& message)
+{
+  for (const TcpConnectionPtr& conn : connections)
+  {
+    conn->send(message);
+  }
+}
+
+}  // namespace
+
+void muduo::net::detail::broadcastByLoop(ConnectionsByLoop* connections,
+                                         const Slice& message)
+{
+  for (auto& it : *connections)
+  {
+    EventLoop* loop = it.first;
+    if (loop->isInLoopThread())
+    {
+      sendAll(it.second, message);
+    }
+    else
+    {
+      loop->queueInLoop(std::bind(sendAll, std::move(it.second), message));
+    }
+  }
+}
@@ -0,0 +1,49 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_BROADCAST_H
+#define MUDUO_NET_BROADCAST_H
+
+#include "muduo/net/Slice.h"
+#include "muduo/net/TcpConnection.h"
+
+#include <map>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+namespace detail
+{
+typedef std::map<EventLoop*, std::vector<TcpConnectionPtr>> ConnectionsByLoop;
+
+void broadcastByLoop(ConnectionsByLoop* connections, const Slice& message);
+}  // namespace detail
+
+///
+/// Sends @c message to all connections of @c audiences,
+/// which is referenced by their output queues, not copied.
+///
+/// Connections of the loop of this thread are sent to right away,
+/// those of another loop in one task of that loop,
+/// instead of one task per connection.
+/// Thread safe, @c audiences is not referenced after return.
+template<typename Container>
+void broadcast(const Container& audiences, const Slice& message)
+{
+  detail::ConnectionsByLoop connections;
+  for (const TcpConnectionPtr& conn : audiences)
+  {
+    connections[conn->getLoop()].push_back(conn);
+  }
+  detail::broadcastByLoop(&connections, message);
+}
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_BROADCAST_H
@@ -21,11 +21,91 @@ const char Buffer::kCRLF[] = "\r\n";
 
 const size_t Buffer::kCheapPrepend;
 const size_t Buffer::kInitialSize;
+char Buffer::s_emptyBlock[kCheapPrepend];
+
+Buffer::Buffer(const Buffer& rhs)
+  : buffer_(s_emptyBlock),
+    capacity_(rhs.capacity_),
+    blockSize_(0),
+    readerIndex_(rhs.readerIndex_),
+    writerIndex_(rhs.writerIndex_)
+{
+  if (rhs.blockSize_ > 0)
+  {
+    buffer_ = BufferPool::allocateBlock(capacity_);
+    blockSize_ = BufferPool::blockSize(capacity_);
+    std::copy(rhs.begin(), rhs.begin() + writerIndex_, begin());
+  }
+}
+
+Buffer::Buffer(Buffer&& rhs) noexcept
+  : buffer_(rhs.buffer_),
+    capacity_(rhs.capacity_),
+    blockSize_(rhs.blockSize_),
+    readerIndex_(rhs.readerIndex_),
+    writerIndex_(rhs.writerIndex_)
+{
+  rhs.buffer_ = s_emptyBlock;
+  rhs.capacity_ = kCheapPrepend;
+  rhs.blockSize_ = 0;
+  rhs.readerIndex_ = kCheapPrepend;
+  rhs.writerIndex_ = kCheapPrepend;
+}
+
+Buffer::~Buffer()
+{
+  if (blockSize_ > 0)
+  {
+    BufferPool::deallocateBlock(buffer_, blockSize_);
+  }
+}
+
+bool Buffer::releaseIfEmpty()
+{
+  if (readableBytes() > 0 || blockSize_ == 0)
+  {
+    return false;
+  }
+  BufferPool::deallocateBlock(buffer_, blockSize_);
+  buffer_ = s_emptyBlock;
+  capacity_ = kCheapPrepend;
+  blockSize_ = 0;
+  readerIndex_ = kCheapPrepend;
+  writerIndex_ = kCheapPrepend;
+  return true;
+}
+
+void Buffer::grow(size_t len)
+{
+  // a released one starts over at the initial size
+  const size_t newCapacity = blockSize_ > 0 ? writerIndex_ + len
+      : std::max(writerIndex_ + len, kCheapPrepend + kInitialSize);
+  if (newCapacity <= blockSize_)
+  {
+    capacity_ = newCapacity;
+    return;
+  }
+  // geometric growth, as std::vector
+  const size_t bytes = BufferPool::blockSize(std::max(newCapacity, 2 * blockSize_));
+  char* block = BufferPool::allocateBlock(bytes);
+  std::copy(begin(), begin() + writerIndex_, block);
+  if (blockSize_ > 0)
+  {
+    BufferPool::deallocateBlock(buffer_, blockSize_);
+  }
+  buffer_ = block;
+  capacity_ = newCapacity;
+  blockSize_ = bytes;
+}
 
 ssize_t Buffer::readFd(int fd, int* savedErrno)
 {
   // saved an ioctl()/FIONREAD call to tell how much to read
   char extrabuf[65536];
+  if (blockSize_ == 0)
+  {
+    makeSpace(kInitialSize);
+  }
   struct iovec vec[2];
   const size_t writable = writableBytes();
   vec[0].iov_base = begin()+writerIndex_;
@@ -46,7 +126,7 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
   }
   else
   {
-    writerIndex_ = buffer_.size();
+    writerIndex_ = capacity_;
     append(extrabuf, n - writable);
   }
   // if (n == writable + sizeof extrabuf)
@@ -15,6 +15,7 @@
 #include "muduo/base/StringPiece.h"
 #include "muduo/base/Types.h"
 
+#include "muduo/net/BufferPool.h"
 #include "muduo/net/Endian.h"
 
 #include <algorithm>
@@ -39,14 +40,20 @@ namespace net
 /// |                   |                  |                  |
 /// 0      <=      readerIndex   <=   writerIndex    <=     size
 /// @endcode
+///
+/// Storage comes from the BufferPool of the current thread, if any.
 class Buffer : public muduo::copyable
 {
  public:
   static const size_t kCheapPrepend = 8;
   static const size_t kInitialSize = 1024;
 
+  /// Buffer(0) holds no storage until written, as a released one.
   explicit Buffer(size_t initialSize = kInitialSize)
-    : buffer_(kCheapPrepend + initialSize),
+    : buffer_(initialSize > 0 ? BufferPool::allocateBlock(kCheapPrepend + initialSize)
+                              : s_emptyBlock),
+      capacity_(kCheapPrepend + initialSize),
+      blockSize_(initialSize > 0 ? BufferPool::blockSize(capacity_) : 0),
       readerIndex_(kCheapPrepend),
       writerIndex_(kCheapPrepend)
   {
@@ -55,12 +62,21 @@ class Buffer : public muduo::copyable
     assert(prependableBytes() == kCheapPrepend);
   }
 
-  // implicit copy-ctor, move-ctor, dtor and assignment are fine
-  // NOTE: implicit move-ctor is added in g++ 4.6
+  Buffer(const Buffer& rhs);
+  Buffer(Buffer&& rhs) noexcept;
+  ~Buffer();
+
+  Buffer& operator=(Buffer rhs)
+  {
+    swap(rhs);
+    return *this;
+  }
 
   void swap(Buffer& rhs)
   {
-    buffer_.swap(rhs.buffer_);
+    std::swap(buffer_, rhs.buffer_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(blockSize_, rhs.blockSize_);
     std::swap(readerIndex_, rhs.readerIndex_);
     std::swap(writerIndex_, rhs.writerIndex_);
   }
@@ -69,7 +85,7 @@ class Buffer : public muduo::copyable
   { return writerIndex_ - readerIndex_; }
 
   size_t writableBytes() const
-  { return buffer_.size() - writerIndex_; }
+  { return capacity_ - writerIndex_; }
 
   size_t prependableBytes() const
   { return readerIndex_; }
@@ -353,6 +369,10 @@ class Buffer : public muduo::copyable
 
   void prepend(const void* /*restrict*/ data, size_t len)
   {
+    if (blockSize_ == 0)
+    {
+      makeSpace(0);
+    }
     assert(len <= prependableBytes());
     readerIndex_ -= len;
     const char* d = static_cast<const char*>(data);
@@ -370,9 +390,14 @@ class Buffer : public muduo::copyable
 
   size_t internalCapacity() const
   {
-    return buffer_.capacity();
+    return blockSize_;
   }
 
+  /// Gives the storage back to the BufferPool if empty,
+  /// it's allocated again when written.
+  /// @return true if released.
+  bool releaseIfEmpty();
+
   /// Read data directly into buffer.
   ///
   /// It may implement with readv(2)
@@ -382,17 +407,20 @@ class Buffer : public muduo::copyable
  private:
 
   char* begin()
-  { return &*buffer_.begin(); }
+  { return buffer_; }
 
   const char* begin() const
-  { return &*buffer_.begin(); }
+  { return buffer_; }
+
+  // resizes to writerIndex_+len, or allocates if released
+  void grow(size_t len);
 
   void makeSpace(size_t len)
   {
-    if (writableBytes() + prependableBytes() < len + kCheapPrepend)
+    if (blockSize_ == 0 || writableBytes() + prependableBytes() < len + kCheapPrepend)
     {
       // FIXME: move readable data
-      buffer_.resize(writerIndex_+len);
+      grow(len);
     }
     else
     {
@@ -409,11 +437,14 @@ class Buffer : public muduo::copyable
   }
 
  private:
-  std::vector<char> buffer_;
+  char* buffer_;       // s_emptyBlock if released
+  size_t capacity_;    // as vector::size()
+  size_t blockSize_;   // allocated bytes, 0 if released
   size_t readerIndex_;
   size_t writerIndex_;
 
   static const char kCRLF[];
+  static char s_emptyBlock[kCheapPrepend];
 };
 
 }  // namespace net
@@ -0,0 +1,147 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/BufferPool.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Logging.h"
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int BufferPool::kNumClasses;
+const size_t BufferPool::kMinBlockSize;
+const size_t BufferPool::kMaxBlockSize;
+const size_t BufferPool::kDefaultMaxCachedBytes;
+
+namespace
+{
+__thread BufferPool* t_bufferPool = NULL;
+}  // namespace
+
+BufferPool::BufferPool()
+  : maxCachedBytes_(kDefaultMaxCachedBytes),
+    cachedBytes_(0),
+    bytesInUse_(0),
+    hits_(0),
+    misses_(0)
+{
+  memZero(freeLists_, sizeof freeLists_);
+  if (t_bufferPool)
+  {
+    LOG_FATAL << "Another BufferPool " << t_bufferPool
+              << " exists in this thread " << CurrentThread::tid();
+  }
+  t_bufferPool = this;
+}
+
+BufferPool::~BufferPool()
+{
+  trim(0);
+  t_bufferPool = NULL;
+}
+
+BufferPool* BufferPool::current()
+{
+  return t_bufferPool;
+}
+
+int BufferPool::sizeClass(size_t size)
+{
+  int cls = 0;
+  size_t blockSize = kMinBlockSize;
+  while (blockSize < size)
+  {
+    blockSize = 8 + ((blockSize - 8) << 1);
+    ++cls;
+  }
+  return cls;
+}
+
+size_t BufferPool::blockSize(size_t size)
+{
+  if (size > kMaxBlockSize)
+  {
+    return size;
+  }
+  return 8 + ((kMinBlockSize - 8) << sizeClass(size));
+}
+
+char* BufferPool::allocateBlock(size_t size)
+{
+  BufferPool* pool = t_bufferPool;
+  return pool ? pool->allocate(size) : new char[blockSize(size)];
+}
+
+void BufferPool::deallocateBlock(char* block, size_t blockSize)
+{
+  BufferPool* pool = t_bufferPool;
+  if (pool)
+  {
+    pool->deallocate(block, blockSize);
+  }
+  else
+  {
+    delete[] block;
+  }
+}
+
+char* BufferPool::allocate(size_t size)
+{
+  const size_t bytes = blockSize(size);
+  bytesInUse_ += static_cast<int64_t>(bytes);
+  if (bytes <= kMaxBlockSize)
+  {
+    FreeBlock*& head = freeLists_[sizeClass(bytes)];
+    if (head)
+    {
+      FreeBlock* block = head;
+      head = block->next;
+      cachedBytes_ -= bytes;
+      ++hits_;
+      return reinterpret_cast<char*>(block);
+    }
+  }
+  ++misses_;
+  return new char[bytes];
+}
+
+void BufferPool::deallocate(char* block, size_t blockSize)
+{
+  if (block == NULL)
+  {
+    return;
+  }
+  bytesInUse_ -= static_cast<int64_t>(blockSize);
+  if (blockSize <= kMaxBlockSize && cachedBytes_ + blockSize <= maxCachedBytes_)
+  {
+    assert(blockSize == BufferPool::blockSize(blockSize));
+    FreeBlock* freeBlock = reinterpret_cast<FreeBlock*>(block);
+    FreeBlock*& head = freeLists_[sizeClass(blockSize)];
+    freeBlock->next = head;
+    head = freeBlock;
+    cachedBytes_ += blockSize;
+  }
+  else
+  {
+    delete[] block;
+  }
+}
+
+void BufferPool::trim(size_t maxCachedBytes)
+{
+  // frees larger blocks first
+  for (int cls = kNumClasses-1; cls >= 0 && cachedBytes_ > maxCachedBytes; --cls)
+  {
+    const size_t bytes = 8 + ((kMinBlockSize - 8) << cls);
+    while (freeLists_[cls] && cachedBytes_ > maxCachedBytes)
+    {
+      FreeBlock* block = freeLists_[cls];
+      freeLists_[cls] = block->next;
+      cachedBytes_ -= bytes;
+      delete[] reinterpret_cast<char*>(block);
+    }
+  }
+}
@@ -0,0 +1,87 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_BUFFERPOOL_H
+#define MUDUO_NET_BUFFERPOOL_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Size-classed cache of Buffer storage, one per EventLoop.
+///
+/// Buffers allocate from the pool of the current thread, if any,
+/// and give blocks back to it.  Blocks are plain new char[], so a Buffer
+/// may be freed in any thread, a block from another pool is just cached
+/// here, or deleted in threads without a pool.
+///
+/// Not thread safe, used by its own thread only.
+class BufferPool : noncopyable
+{
+ public:
+  static const int kNumClasses = 9;
+  static const size_t kMinBlockSize = 8 + 256;
+  static const size_t kMaxBlockSize = 8 + (256 << (kNumClasses-1));  // 64k + 8
+  static const size_t kDefaultMaxCachedBytes = 4*1024*1024;
+
+  BufferPool();
+  ~BufferPool();
+
+  /// Of the EventLoop in this thread, NULL if none.
+  static BufferPool* current();
+
+  /// Size of the block for @c size bytes,
+  /// rounded up to a size class, or @c size if too large to be pooled.
+  static size_t blockSize(size_t size);
+
+  /// Allocates blockSize(@c size) bytes, from a pool if any.
+  static char* allocateBlock(size_t size);
+  /// Gives back a block of @c blockSize bytes, to a pool if any.
+  static void deallocateBlock(char* block, size_t blockSize);
+
+  char* allocate(size_t size);
+  void deallocate(char* block, size_t blockSize);
+
+  /// Frees cached blocks until at most @c maxCachedBytes are left.
+  void trim(size_t maxCachedBytes);
+
+  /// Blocks beyond this are freed instead of cached.
+  void setMaxCachedBytes(size_t maxCachedBytes)
+  { maxCachedBytes_ = maxCachedBytes; }
+
+  /// Bytes in Buffers, allocated but not deallocated here.
+  /// Approximate if Buffers move between threads.
+  int64_t bytesInUse() const { return bytesInUse_; }
+  size_t cachedBytes() const { return cachedBytes_; }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  static int sizeClass(size_t size);
+
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  FreeBlock* freeLists_[kNumClasses];
+  size_t maxCachedBytes_;
+  size_t cachedBytes_;
+  int64_t bytesInUse_;
+  int64_t hits_;
+  int64_t misses_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_BUFFERPOOL_H
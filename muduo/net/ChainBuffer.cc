@@ -0,0 +1,156 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/ChainBuffer.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <string.h>
+#include <sys/uio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t ChainBuffer::kSliceSize;
+
+void ChainBuffer::append(const void* data, size_t len)
+{
+  const char* d = static_cast<const char*>(data);
+  readableBytes_ += len;
+  while (len > 0)
+  {
+    if (empty() || blocks_.back().writable == 0)
+    {
+      char* slice = new char[kSliceSize];
+      Block block = { std::shared_ptr<const void>(slice, std::default_delete<char[]>()),
+                      slice, 0, slice, kSliceSize, -1, 0, false };
+      blocks_.push_back(std::move(block));
+    }
+    Block& back = blocks_.back();
+    size_t n = std::min(len, back.writable);
+    ::memcpy(back.tail, d, n);
+    back.tail += n;
+    back.writable -= n;
+    back.len += n;
+    d += n;
+    len -= n;
+  }
+}
+
+void ChainBuffer::append(std::shared_ptr<const void> holder, const void* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  Block block = { std::move(holder), static_cast<const char*>(data), len, NULL, 0, -1, 0, false };
+  blocks_.push_back(std::move(block));
+  readableBytes_ += len;
+}
+
+void ChainBuffer::appendZeroCopy(std::shared_ptr<const void> holder, const void* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  Block block = { std::move(holder), static_cast<const char*>(data), len, NULL, 0, -1, 0, true };
+  blocks_.push_back(std::move(block));
+  readableBytes_ += len;
+}
+
+void ChainBuffer::appendFile(std::shared_ptr<const void> holder, int fd, off_t offset, size_t len)
+{
+  assert(fd >= 0);
+  if (len == 0)
+  {
+    return;
+  }
+  Block block = { std::move(holder), NULL, len, NULL, 0, fd, offset, false };
+  blocks_.push_back(std::move(block));
+  readableBytes_ += len;
+}
+
+int ChainBuffer::peekIovec(struct iovec* iov, int iovcnt) const
+{
+  int n = 0;
+  for (std::vector<Block>::const_iterator it = blocks_.begin() + head_;
+       it != blocks_.end() && it->fd < 0 && !it->zeroCopy && n < iovcnt;
+       ++it, ++n)
+  {
+    iov[n].iov_base = const_cast<char*>(it->data);
+    iov[n].iov_len = it->len;
+  }
+  return n;
+}
+
+bool ChainBuffer::peekFile(int* fd, off_t* offset, size_t* len) const
+{
+  if (empty() || blocks_[head_].fd < 0)
+  {
+    return false;
+  }
+  const Block& front = blocks_[head_];
+  *fd = front.fd;
+  *offset = front.offset;
+  *len = front.len;
+  return true;
+}
+
+bool ChainBuffer::peekZeroCopy(const char** data, size_t* len,
+                               std::shared_ptr<const void>* holder) const
+{
+  if (empty() || !blocks_[head_].zeroCopy)
+  {
+    return false;
+  }
+  const Block& front = blocks_[head_];
+  *data = front.data;
+  *len = front.len;
+  *holder = front.holder;
+  return true;
+}
+
+void ChainBuffer::retrieve(size_t len)
+{
+  assert(len <= readableBytes_);
+  readableBytes_ -= len;
+  while (len > 0)
+  {
+    Block& front = blocks_[head_];
+    if (len < front.len)
+    {
+      if (front.fd >= 0)
+      {
+        front.offset += static_cast<off_t>(len);
+      }
+      else
+      {
+        front.data += len;
+      }
+      front.len -= len;
+      break;
+    }
+    len -= front.len;
+    front = Block();  // releases its holder now
+    ++head_;
+  }
+  if (empty())
+  {
+    retrieveAll();
+  }
+  else if (head_ * 2 >= blocks_.size())
+  {
+    // moves no more blocks than were consumed since the last time
+    blocks_.erase(blocks_.begin(), blocks_.begin() + static_cast<ptrdiff_t>(head_));
+    head_ = 0;
+  }
+}
+
+void ChainBuffer::retrieveAll()
+{
+  blocks_.clear();
+  head_ = 0;
+  readableBytes_ = 0;
+}
@@ -0,0 +1,118 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_CHAINBUFFER_H
+#define MUDUO_NET_CHAINBUFFER_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+
+#include <memory>
+#include <vector>
+
+#include <sys/types.h>  // off_t
+
+struct iovec;
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// An output queue of blocks, to be written with writev(2).
+///
+/// Copied data goes to fixed-size slices, so queueing a large payload
+/// costs neither reallocation nor memmove of what's already queued.
+/// Caller-owned blocks are referenced, not copied.
+/// File blocks are meant for sendfile(2), zero-copy blocks for
+/// send(2) with MSG_ZEROCOPY, neither is ever in iovec.
+class ChainBuffer : public muduo::copyable
+{
+ public:
+  static const size_t kSliceSize = 64*1024;
+
+  ChainBuffer()
+    : head_(0),
+      readableBytes_(0)
+  { }
+
+  // implicit copy-ctor, move-ctor, dtor and assignment are fine
+
+  void swap(ChainBuffer& rhs)
+  {
+    blocks_.swap(rhs.blocks_);
+    std::swap(head_, rhs.head_);
+    std::swap(readableBytes_, rhs.readableBytes_);
+  }
+
+  size_t readableBytes() const
+  { return readableBytes_; }
+
+  bool empty() const
+  { return head_ == blocks_.size(); }
+
+  size_t numBlocks() const
+  { return blocks_.size() - head_; }
+
+  /// Copies data into slices.
+  void append(const void* /*restrict*/ data, size_t len);
+
+  void append(const StringPiece& str)
+  {
+    append(str.data(), str.size());
+  }
+
+  /// References [data, data+len) without copying,
+  /// it must stay valid as long as @c holder is alive.
+  void append(std::shared_ptr<const void> holder, const void* data, size_t len);
+
+  /// Same as append(holder, data, len), but to be sent with MSG_ZEROCOPY.
+  void appendZeroCopy(std::shared_ptr<const void> holder, const void* data, size_t len);
+
+  /// References [offset, offset+len) of file @c fd,
+  /// it must stay open as long as @c holder is alive.
+  void appendFile(std::shared_ptr<const void> holder, int fd, off_t offset, size_t len);
+
+  /// Fills at most @c iovcnt entries from the front,
+  /// stops at a file or zero-copy block.
+  /// @return number of entries filled
+  int peekIovec(struct iovec* iov, int iovcnt) const;
+
+  /// @return true if the front block is a file, and fills its range.
+  bool peekFile(int* fd, off_t* offset, size_t* len) const;
+
+  /// @return true if the front block is for zero-copy, and fills it.
+  bool peekZeroCopy(const char** data, size_t* len,
+                    std::shared_ptr<const void>* holder) const;
+
+  void retrieve(size_t len);
+  void retrieveAll();
+
+ private:
+  struct Block
+  {
+    std::shared_ptr<const void> holder;
+    const char* data;   // readable bytes, NULL for file blocks
+    size_t len;
+    char* tail;         // writable bytes, owned slices only
+    size_t writable;
+    int fd;             // file blocks only, -1 otherwise
+    off_t offset;
+    bool zeroCopy;
+  };
+
+  // nothing allocated until the first append,
+  // consumed blocks stay before head_ until compacted
+  std::vector<Block> blocks_;
+  size_t head_;
+  size_t readableBytes_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_CHAINBUFFER_H
@@ -28,6 +28,7 @@ Channel::Channel(EventLoop* loop, int fd__)
     revents_(0),
     index_(-1),
     logHup_(true),
+    edgeTriggered_(false),
     tied_(false),
     eventHandling_(false),
     addedToLoop_(false)
@@ -56,6 +57,23 @@ void Channel::update()
   loop_->updateChannel(this);
 }
 
+void Channel::setEdgeTriggered(bool on)
+{
+  assert(!addedToLoop_);
+  edgeTriggered_ = on && loop_->supportsEdgeTriggered();
+}
+
+void Channel::updateWriting()
+{
+  // An edge-triggered channel keeps POLLOUT registered as long as it has
+  // any interest, and handleEvent() filters it by isWriting(),
+  // so toggling writing costs no epoll_ctl(2).
+  if (!edgeTriggered_ || (events_ & ~kWriteEvent) == kNoneEvent)
+  {
+    update();
+  }
+}
+
 void Channel::remove()
 {
   assert(isNoneEvent());
@@ -106,7 +124,7 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
   {
     if (readCallback_) readCallback_(receiveTime);
   }
-  if (revents_ & POLLOUT)
+  if ((revents_ & POLLOUT) && (!edgeTriggered_ || isWriting()))
   {
     if (writeCallback_) writeCallback_();
   }
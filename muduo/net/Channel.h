@@ -61,12 +61,18 @@ class Channel : noncopyable
 
   void enableReading() { events_ |= kReadEvent; update(); }
   void disableReading() { events_ &= ~kReadEvent; update(); }
-  void enableWriting() { events_ |= kWriteEvent; update(); }
-  void disableWriting() { events_ &= ~kWriteEvent; update(); }
+  void enableWriting() { events_ |= kWriteEvent; updateWriting(); }
+  void disableWriting() { events_ &= ~kWriteEvent; updateWriting(); }
   void disableAll() { events_ = kNoneEvent; update(); }
   bool isWriting() const { return events_ & kWriteEvent; }
   bool isReading() const { return events_ & kReadEvent; }
 
+  /// Edge-triggered notification, honored only by pollers which support it,
+  /// see EventLoop::supportsEdgeTriggered().
+  /// Must be called before the channel is added to loop.
+  void setEdgeTriggered(bool on);
+  bool isEdgeTriggered() const { return edgeTriggered_; }
+
   // for Poller
   int index() { return index_; }
   void set_index(int idx) { index_ = idx; }
@@ -84,6 +90,7 @@ class Channel : noncopyable
   static string eventsToString(int fd, int ev);
 
   void update();
+  void updateWriting();
   void handleEventWithGuard(Timestamp receiveTime);
 
   static const int kNoneEvent;
@@ -96,6 +103,7 @@ class Channel : noncopyable
   int        revents_; // it's the received event types of epoll or poll
   int        index_; // used by Poller.
   bool       logHup_;
+  bool       edgeTriggered_;
 
   std::weak_ptr<void> tie_;
   bool tied_;
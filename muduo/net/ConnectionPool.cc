@@ -0,0 +1,309 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/ConnectionPool.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+
+#include <algorithm>
+
+#include <stdio.h>  // snprintf
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+string endpointKey(const string& host, uint16_t port)
+{
+  char buf[16];
+  snprintf(buf, sizeof buf, ":%u", port);
+  return host + buf;
+}
+
+// after the TcpClient has left its own callbacks
+void destroyClient(const std::shared_ptr<TcpClient>&)
+{
+}
+
+}  // namespace
+
+ConnectionPool::ConnectionPool(EventLoop* loop, const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    name_(nameArg),
+    minIdle_(kDefaultMinIdle),
+    maxIdle_(kDefaultMaxIdle),
+    maxConnections_(kDefaultMaxConnections),
+    leaseTimeout_(5.0),
+    connectionCallback_(defaultConnectionCallback),
+    messageCallback_(defaultMessageCallback),
+    stats_()
+{
+}
+
+ConnectionPool::~ConnectionPool()
+{
+  loop_->assertInLoopThread();
+  LOG_DEBUG << "ConnectionPool::~ConnectionPool [" << name_ << "] "
+            << endpoints_.size() << " endpoints";
+  for (const auto& it : endpoints_)
+  {
+    for (const Waiter& waiter : it.second->waiters)
+    {
+      loop_->cancel(waiter.timer);
+    }
+    for (const TcpClientPtr& client : it.second->clients)
+    {
+      // TcpClient closes it later, without us
+      TcpConnectionPtr conn = client->connection();
+      if (conn)
+      {
+        conn->setConnectionCallback(connectionCallback_);
+      }
+    }
+  }
+}
+
+void ConnectionPool::warmUp(const InetAddress& serverAddr)
+{
+  loop_->runInLoop(
+      std::bind(&ConnectionPool::warmUpInLoop, this, serverAddr.toIpPort(),
+                serverAddr, string(), serverAddr.toPort()));
+}
+
+void ConnectionPool::warmUp(const string& host, uint16_t port)
+{
+  loop_->runInLoop(
+      std::bind(&ConnectionPool::warmUpInLoop, this, endpointKey(host, port),
+                InetAddress(), host, port));
+}
+
+void ConnectionPool::lease(const InetAddress& serverAddr, LeaseCallback cb)
+{
+  loop_->runInLoop(
+      std::bind(&ConnectionPool::leaseInLoop, this, serverAddr.toIpPort(),
+                serverAddr, string(), serverAddr.toPort(), std::move(cb)));
+}
+
+void ConnectionPool::lease(const string& host, uint16_t port, LeaseCallback cb)
+{
+  loop_->runInLoop(
+      std::bind(&ConnectionPool::leaseInLoop, this, endpointKey(host, port),
+                InetAddress(), host, port, std::move(cb)));
+}
+
+void ConnectionPool::release(const TcpConnectionPtr& conn)
+{
+  loop_->runInLoop(std::bind(&ConnectionPool::releaseInLoop, this, conn));
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const
+{
+  loop_->assertInLoopThread();
+  Stats stats = stats_;
+  for (const auto& it : endpoints_)
+  {
+    stats.idle += static_cast<int>(it.second->idle.size());
+    stats.leased += it.second->leased;
+  }
+  return stats;
+}
+
+ConnectionPool::Endpoint* ConnectionPool::getEndpoint(const string& key,
+                                                      const InetAddress& serverAddr,
+                                                      const string& host,
+                                                      uint16_t port)
+{
+  std::unique_ptr<Endpoint>& endpoint = endpoints_[key];
+  if (!endpoint)
+  {
+    endpoint.reset(new Endpoint);
+    endpoint->serverAddr = serverAddr;
+    endpoint->host = host;
+    endpoint->port = port;
+    endpoint->callbacks.reset(new TcpConnection::Callbacks{
+        std::bind(&ConnectionPool::onConnection, this, key, _1),
+        messageCallback_,
+        writeCompleteCallback_,
+        HighWaterMarkCallback() });
+    endpoint->leased = 0;
+    endpoint->nextClientId = 1;
+    topUp(key, get_pointer(endpoint));
+  }
+  return get_pointer(endpoint);
+}
+
+void ConnectionPool::warmUpInLoop(const string& key, const InetAddress& serverAddr,
+                                  const string& host, uint16_t port)
+{
+  loop_->assertInLoopThread();
+  getEndpoint(key, serverAddr, host, port);
+}
+
+void ConnectionPool::leaseInLoop(const string& key, const InetAddress& serverAddr,
+                                 const string& host, uint16_t port,
+                                 const LeaseCallback& cb)
+{
+  loop_->assertInLoopThread();
+  Endpoint* endpoint = getEndpoint(key, serverAddr, host, port);
+  ++stats_.leases;
+  while (!endpoint->idle.empty())
+  {
+    TcpConnectionPtr conn = endpoint->idle.front();
+    endpoint->idle.pop_front();
+    if (conn->connected())
+    {
+      ++stats_.reused;
+      ++endpoint->leased;
+      leased_[conn] = key;
+      topUp(key, endpoint);
+      cb(conn);
+      return;
+    }
+  }
+
+  ++stats_.waited;
+  const Timestamp deadline(addTime(Timestamp::now(), leaseTimeout_));
+  TimerId timer = loop_->runAt(
+      deadline, std::bind(&ConnectionPool::expireWaiters, this, key));
+  endpoint->waiters.push_back(Waiter{ cb, deadline, timer });
+  const int connecting = static_cast<int>(endpoint->clients.size())
+      - static_cast<int>(endpoint->idle.size()) - endpoint->leased;
+  if (connecting < static_cast<int>(endpoint->waiters.size())
+      && static_cast<int>(endpoint->clients.size()) < maxConnections_)
+  {
+    addClient(key, endpoint);
+  }
+}
+
+void ConnectionPool::releaseInLoop(const TcpConnectionPtr& conn)
+{
+  loop_->assertInLoopThread();
+  std::map<TcpConnectionPtr, string>::iterator it = leased_.find(conn);
+  if (it == leased_.end())
+  {
+    LOG_ERROR << "ConnectionPool::release [" << name_ << "] - "
+              << conn->name() << " is not leased";
+    return;
+  }
+  const string key = it->second;
+  leased_.erase(it);
+  Endpoint* endpoint = get_pointer(endpoints_[key]);
+  --endpoint->leased;
+  if (conn->connected())
+  {
+    // drops whatever the leaseholder set
+    conn->setCallbacks(endpoint->callbacks);
+    addIdle(key, endpoint, conn);
+  }
+}
+
+void ConnectionPool::topUp(const string& key, Endpoint* endpoint)
+{
+  // idle and connecting ones, for the next leases
+  while (static_cast<int>(endpoint->clients.size()) - endpoint->leased < minIdle_
+         && static_cast<int>(endpoint->clients.size()) < maxConnections_)
+  {
+    addClient(key, endpoint);
+  }
+}
+
+void ConnectionPool::addClient(const string& key, Endpoint* endpoint)
+{
+  char buf[32];
+  snprintf(buf, sizeof buf, "#%d", endpoint->nextClientId++);
+  const string clientName = name_ + ":" + key + buf;
+  TcpClientPtr client(endpoint->host.empty()
+      ? new TcpClient(loop_, endpoint->serverAddr, clientName)
+      : new TcpClient(loop_, endpoint->host, endpoint->port, clientName));
+  client->enableRetry();
+  client->setCallbacks(endpoint->callbacks);
+  endpoint->clients.push_back(client);
+  ++stats_.connects;
+  client->connect();
+}
+
+void ConnectionPool::onConnection(const string& key, const TcpConnectionPtr& conn)
+{
+  loop_->assertInLoopThread();
+  Endpoint* endpoint = get_pointer(endpoints_[key]);
+  if (conn->connected())
+  {
+    connectionCallback_(conn);
+    addIdle(key, endpoint, conn);
+  }
+  else
+  {
+    // its TcpClient reconnects, unless retired
+    std::deque<TcpConnectionPtr>::iterator idle =
+        std::find(endpoint->idle.begin(), endpoint->idle.end(), conn);
+    if (idle != endpoint->idle.end())
+    {
+      endpoint->idle.erase(idle);
+    }
+    if (leased_.erase(conn))
+    {
+      --endpoint->leased;
+    }
+    connectionCallback_(conn);
+  }
+}
+
+void ConnectionPool::addIdle(const string& key, Endpoint* endpoint, const TcpConnectionPtr& conn)
+{
+  if (!endpoint->waiters.empty())
+  {
+    Waiter waiter = std::move(endpoint->waiters.front());
+    endpoint->waiters.pop_front();
+    loop_->cancel(waiter.timer);
+    ++endpoint->leased;
+    leased_[conn] = key;
+    topUp(key, endpoint);
+    waiter.cb(conn);
+  }
+  else if (static_cast<int>(endpoint->idle.size()) >= maxIdle_)
+  {
+    retire(endpoint, conn);
+  }
+  else
+  {
+    endpoint->idle.push_back(conn);
+  }
+}
+
+void ConnectionPool::retire(Endpoint* endpoint, const TcpConnectionPtr& conn)
+{
+  for (std::vector<TcpClientPtr>::iterator it = endpoint->clients.begin();
+       it != endpoint->clients.end(); ++it)
+  {
+    if ((*it)->connection() == conn)
+    {
+      ++stats_.retired;
+      TcpClientPtr client = *it;
+      endpoint->clients.erase(it);
+      // closes later, maybe after us
+      conn->setConnectionCallback(connectionCallback_);
+      client->disconnect();  // no more retries
+      loop_->queueInLoop(std::bind(destroyClient, client));
+      return;
+    }
+  }
+}
+
+void ConnectionPool::expireWaiters(const string& key)
+{
+  Endpoint* endpoint = get_pointer(endpoints_[key]);
+  const Timestamp now(Timestamp::now());
+  // deadlines are in order, of one timeout
+  while (!endpoint->waiters.empty() && !(now < endpoint->waiters.front().deadline))
+  {
+    LeaseCallback cb = std::move(endpoint->waiters.front().cb);
+    endpoint->waiters.pop_front();
+    ++stats_.timeouts;
+    LOG_WARN << "ConnectionPool::lease [" << name_ << "] - timeout of " << key;
+    cb(TcpConnectionPtr());
+  }
+}
@@ -0,0 +1,170 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_CONNECTIONPOOL_H
+#define MUDUO_NET_CONNECTIONPOOL_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Callbacks.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpConnection.h"
+#include "muduo/net/TimerId.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class TcpClient;
+
+///
+/// Client connections kept open per endpoint, leased and returned.
+///
+/// Each connection is a TcpClient with retry enabled, so a failed connect
+/// or a closed connection comes back by the backoff of Connector.
+/// A pool belongs to one loop, and so do its connections,
+/// use one pool per I/O loop to never hop threads on the request path.
+class ConnectionPool : noncopyable
+{
+ public:
+  /// Gets a connected one, or null if timed out.
+  typedef std::function<void (const TcpConnectionPtr& conn)> LeaseCallback;
+
+  static const int kDefaultMinIdle = 1;
+  static const int kDefaultMaxIdle = 8;
+  static const int kDefaultMaxConnections = 64;
+
+  struct Stats
+  {
+    int64_t leases;
+    int64_t reused;    // leased at once, from idle connections
+    int64_t waited;    // for a connect or a release
+    int64_t timeouts;  // waited too long
+    int64_t connects;  // TcpClients created
+    int64_t retired;   // closed, beyond maxIdle
+    int idle;
+    int leased;
+  };
+
+  ConnectionPool(EventLoop* loop, const string& nameArg);
+  ~ConnectionPool();  // force out-line dtor, for std::unique_ptr members.
+
+  EventLoop* getLoop() const { return loop_; }
+  const string& name() const { return name_; }
+
+  /// Idle or connecting ones kept per endpoint, from warmUp() or the first
+  /// lease, opened again as others are leased, up to maxConnections.
+  /// Must be called before use.
+  void setMinIdle(int n) { minIdle_ = n; }
+  /// Returned connections beyond it are closed.
+  /// Must be called before use.
+  void setMaxIdle(int n) { maxIdle_ = n; }
+  /// Idle, leased and connecting ones of an endpoint.
+  /// Must be called before use.
+  void setMaxConnections(int n) { maxConnections_ = n; }
+  /// Must be called before use.
+  void setLeaseTimeout(double seconds) { leaseTimeout_ = seconds; }
+
+  /// Of all connections, called before they join, and after they leave the pool.
+  /// Not thread safe.
+  void setConnectionCallback(ConnectionCallback cb)
+  { connectionCallback_ = std::move(cb); }
+  /// Of all connections, a leaseholder may set its own until release().
+  /// Endpoints opened so far keep the old one.
+  /// Not thread safe.
+  void setMessageCallback(MessageCallback cb)
+  { messageCallback_ = std::move(cb); }
+  /// Likewise.
+  /// Not thread safe.
+  void setWriteCompleteCallback(WriteCompleteCallback cb)
+  { writeCompleteCallback_ = std::move(cb); }
+
+  /// Opens minIdle connections now, ahead of the first lease.
+  /// Thread safe.
+  void warmUp(const InetAddress& serverAddr);
+  /// By EventLoop::resolver().
+  void warmUp(const string& host, uint16_t port);
+
+  ///
+  /// Leases a connection of the endpoint, exclusively until release().
+  /// The callback runs in the loop thread, within lease() if called in
+  /// the loop thread and an idle one is there.
+  /// Thread safe.
+  void lease(const InetAddress& serverAddr, LeaseCallback cb);
+  /// By EventLoop::resolver().
+  void lease(const string& host, uint16_t port, LeaseCallback cb);
+
+  ///
+  /// Returns a leased connection, keeps it for the next lease if connected.
+  /// Thread safe.
+  void release(const TcpConnectionPtr& conn);
+
+  /// Must be called in the loop thread.
+  Stats stats() const;
+
+ private:
+  typedef std::shared_ptr<TcpClient> TcpClientPtr;
+
+  struct Waiter
+  {
+    LeaseCallback cb;
+    Timestamp deadline;
+    TimerId timer;
+  };
+
+  struct Endpoint
+  {
+    InetAddress serverAddr;
+    string host;  // resolves if not empty
+    uint16_t port;
+    // of its clients and returned connections, built once
+    TcpConnection::CallbacksPtr callbacks;
+    std::vector<TcpClientPtr> clients;
+    std::deque<TcpConnectionPtr> idle;
+    std::deque<Waiter> waiters;
+    int leased;
+    int nextClientId;
+  };
+
+  Endpoint* getEndpoint(const string& key, const InetAddress& serverAddr,
+                        const string& host, uint16_t port);
+  void warmUpInLoop(const string& key, const InetAddress& serverAddr,
+                    const string& host, uint16_t port);
+  void leaseInLoop(const string& key, const InetAddress& serverAddr,
+                   const string& host, uint16_t port, const LeaseCallback& cb);
+  void releaseInLoop(const TcpConnectionPtr& conn);
+  void addClient(const string& key, Endpoint* endpoint);
+  void onConnection(const string& key, const TcpConnectionPtr& conn);
+  void addIdle(const string& key, Endpoint* endpoint, const TcpConnectionPtr& conn);
+  void retire(Endpoint* endpoint, const TcpConnectionPtr& conn);
+  void topUp(const string& key, Endpoint* endpoint);
+  void expireWaiters(const string& key);
+
+  EventLoop* loop_;
+  const string name_;
+  int minIdle_;
+  int maxIdle_;
+  int maxConnections_;
+  double leaseTimeout_;
+  ConnectionCallback connectionCallback_;
+  MessageCallback messageCallback_;
+  WriteCompleteCallback writeCompleteCallback_;
+  std::map<string, std::unique_ptr<Endpoint>> endpoints_;
+  std::map<TcpConnectionPtr, string> leased_;  // to endpoint keys
+  Stats stats_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_CONNECTIONPOOL_H
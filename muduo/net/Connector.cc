@@ -11,10 +11,12 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/net/Channel.h"
+#include "muduo/net/DnsResolver.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/SocketsOps.h"
 
 #include <errno.h>
+#include <stdio.h>  // snprintf
 
 using namespace muduo;
 using namespace muduo::net;
@@ -24,6 +26,7 @@ const int Connector::kMaxRetryDelayMs;
 Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
   : loop_(loop),
     serverAddr_(serverAddr),
+    port_(serverAddr.toPort()),
     connect_(false),
     state_(kDisconnected),
     retryDelayMs_(kInitRetryDelayMs)
@@ -31,6 +34,17 @@ Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
   LOG_DEBUG << "ctor[" << this << "]";
 }
 
+Connector::Connector(EventLoop* loop, const string& host, uint16_t port)
+  : loop_(loop),
+    host_(host),
+    port_(port),
+    connect_(false),
+    state_(kDisconnected),
+    retryDelayMs_(kInitRetryDelayMs)
+{
+  LOG_DEBUG << "ctor[" << this << "] " << host_;
+}
+
 Connector::~Connector()
 {
   LOG_DEBUG << "dtor[" << this << "]";
@@ -47,14 +61,45 @@ void Connector::startInLoop()
 {
   loop_->assertInLoopThread();
   assert(state_ == kDisconnected);
-  if (connect_)
+  if (!connect_)
   {
-    connect();
+    LOG_DEBUG << "do not connect";
+  }
+  else if (!host_.empty())
+  {
+    // again for each attempt, the address may have changed
+    setState(kResolving);
+    loop_->resolver()->resolve(host_, port_,
+        std::bind(&Connector::onResolved, shared_from_this(), _1, _2));
   }
   else
+  {
+    connect();
+  }
+}
+
+void Connector::onResolved(bool resolved, const InetAddress& addr)
+{
+  loop_->assertInLoopThread();
+  if (state_ != kResolving)
+  {
+    return;  // stopped
+  }
+  setState(kDisconnected);
+  if (!connect_)
   {
     LOG_DEBUG << "do not connect";
   }
+  else if (resolved)
+  {
+    serverAddr_ = addr;
+    connect();
+  }
+  else
+  {
+    LOG_WARN << "Connector::onResolved - cannot resolve " << host_;
+    retryLater();
+  }
 }
 
 void Connector::stop()
@@ -73,12 +118,17 @@ void Connector::stopInLoop()
     int sockfd = removeAndResetChannel();
     retry(sockfd);
   }
+  else if (state_ == kResolving)
+  {
+    setState(kDisconnected);
+  }
 }
 
 void Connector::connect()
 {
   int sockfd = sockets::createNonblockingOrDie(serverAddr_.family());
-  int ret = sockets::connect(sockfd, serverAddr_.getSockAddr());
+  int ret = sockets::connect(sockfd, serverAddr_.getSockAddr(),
+                             serverAddr_.getSockAddrLength());
   int savedErrno = (ret == 0) ? 0 : errno;
   switch (savedErrno)
   {
@@ -94,6 +144,7 @@ void Connector::connect()
     case EADDRNOTAVAIL:
     case ECONNREFUSED:
     case ENETUNREACH:
+    case ENOENT:  // Unix domain socket, the server isn't up yet
       retry(sockfd);
       break;
 
@@ -210,9 +261,14 @@ void Connector::retry(int sockfd)
 {
   sockets::close(sockfd);
   setState(kDisconnected);
+  retryLater();
+}
+
+void Connector::retryLater()
+{
   if (connect_)
   {
-    LOG_INFO << "Connector::retry - Retry connecting to " << serverAddr_.toIpPort()
+    LOG_INFO << "Connector::retry - Retry connecting to " << serverName()
              << " in " << retryDelayMs_ << " milliseconds. ";
     loop_->runAfter(retryDelayMs_/1000.0,
                     std::bind(&Connector::startInLoop, shared_from_this()));
@@ -224,3 +280,13 @@ void Connector::retry(int sockfd)
   }
 }
 
+string Connector::serverName() const
+{
+  if (host_.empty())
+  {
+    return serverAddr_.toIpPort();
+  }
+  char buf[16];
+  snprintf(buf, sizeof buf, ":%u", port_);
+  return host_ + buf;
+}
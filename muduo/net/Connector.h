@@ -32,6 +32,8 @@ class Connector : noncopyable,
   typedef std::function<void (int sockfd)> NewConnectionCallback;
 
   Connector(EventLoop* loop, const InetAddress& serverAddr);
+  /// Resolves @c host by EventLoop::resolver() before each attempt.
+  Connector(EventLoop* loop, const string& host, uint16_t port);
   ~Connector();
 
   void setNewConnectionCallback(const NewConnectionCallback& cb)
@@ -41,26 +43,33 @@ class Connector : noncopyable,
   void restart();  // must be called in loop thread
   void stop();  // can be called in any thread
 
+  /// The last resolved one, if constructed by hostname.
   const InetAddress& serverAddress() const { return serverAddr_; }
+  /// host:port, or ip:port
+  string serverName() const;
 
  private:
-  enum States { kDisconnected, kConnecting, kConnected };
+  enum States { kDisconnected, kResolving, kConnecting, kConnected };
   static const int kMaxRetryDelayMs = 30*1000;
   static const int kInitRetryDelayMs = 500;
 
   void setState(States s) { state_ = s; }
   void startInLoop();
   void stopInLoop();
+  void onResolved(bool resolved, const InetAddress& addr);
   void connect();
   void connecting(int sockfd);
   void handleWrite();
   void handleError();
   void retry(int sockfd);
+  void retryLater();
   int removeAndResetChannel();
   void resetChannel();
 
   EventLoop* loop_;
   InetAddress serverAddr_;
+  const string host_;
+  const uint16_t port_;
   bool connect_; // atomic
   States state_;  // FIXME: use atomic variable
   std::unique_ptr<Channel> channel_;
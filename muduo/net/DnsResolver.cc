@@ -0,0 +1,597 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/DnsResolver.h"
+
+#include "muduo/base/FileUtil.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/Endian.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/UdpSocket.h"
+
+#include <algorithm>
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+const size_t kHeaderSize = 12;
+const uint16_t kFlagResponse = 0x8000;
+const uint16_t kFlagTruncated = 0x0200;
+const uint16_t kFlagRecursionDesired = 0x0100;
+const uint16_t kRcodeMask = 0x000f;
+const uint16_t kRcodeNameError = 3;  // NXDOMAIN
+const uint16_t kTypeA = 1;
+const uint16_t kTypeCname = 5;
+const uint16_t kClassIn = 1;
+const size_t kMaxNameLength = 253;
+const size_t kMaxLabelLength = 63;
+const int kMaxCompressionPointers = 16;
+const int kMaxFileSize = 64*1024;
+
+uint16_t readUint16(const unsigned char* p)
+{
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t readUint32(const unsigned char* p)
+{
+  return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+       | static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+}
+
+void appendUint16(string* out, uint16_t x)
+{
+  out->push_back(static_cast<char>(x >> 8));
+  out->push_back(static_cast<char>(x & 0xff));
+}
+
+// lower case, without the trailing dot
+string canonicalName(const string& hostname)
+{
+  string name(hostname);
+  if (!name.empty() && name.back() == '.')
+  {
+    name.pop_back();
+  }
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  return name;
+}
+
+// @return false if not a valid domain name
+bool appendName(string* out, const string& name)
+{
+  if (name.empty() || name.size() > kMaxNameLength)
+  {
+    return false;
+  }
+  size_t start = 0;
+  while (start <= name.size())
+  {
+    size_t dot = name.find('.', start);
+    if (dot == string::npos)
+    {
+      dot = name.size();
+    }
+    const size_t length = dot - start;
+    if (length == 0 || length > kMaxLabelLength)
+    {
+      return false;
+    }
+    out->push_back(static_cast<char>(length));
+    out->append(name, start, length);
+    start = dot + 1;
+  }
+  out->push_back('\0');
+  return true;
+}
+
+// Reads a name at *offset, which may end by a compression pointer,
+// and advances *offset past it.
+bool readName(const unsigned char* msg, size_t len, size_t* offset, string* name)
+{
+  name->clear();
+  size_t pos = *offset;
+  bool jumped = false;
+  int pointers = 0;
+  while (pos < len)
+  {
+    const unsigned char length = msg[pos];
+    if ((length & 0xc0) == 0xc0)
+    {
+      if (pos + 1 >= len || ++pointers > kMaxCompressionPointers)
+      {
+        return false;
+      }
+      if (!jumped)
+      {
+        *offset = pos + 2;
+        jumped = true;
+      }
+      pos = static_cast<size_t>((length & 0x3f) << 8 | msg[pos + 1]);
+    }
+    else if (length & 0xc0)
+    {
+      return false;  // reserved label types
+    }
+    else if (length == 0)
+    {
+      if (!jumped)
+      {
+        *offset = pos + 1;
+      }
+      return true;
+    }
+    else
+    {
+      if (pos + 1 + length > len || name->size() + length >= kMaxNameLength + 2)
+      {
+        return false;
+      }
+      if (!name->empty())
+      {
+        name->push_back('.');
+      }
+      for (size_t i = pos + 1; i < pos + 1 + length; ++i)
+      {
+        name->push_back(static_cast<char>(::tolower(msg[i])));
+      }
+      pos += 1 + length;
+    }
+  }
+  return false;
+}
+
+std::vector<string> splitWords(const string& line)
+{
+  std::vector<string> words;
+  size_t i = 0;
+  while (i < line.size())
+  {
+    while (i < line.size() && isspace(static_cast<unsigned char>(line[i])))
+    {
+      ++i;
+    }
+    size_t start = i;
+    while (i < line.size() && !isspace(static_cast<unsigned char>(line[i])))
+    {
+      ++i;
+    }
+    if (i > start)
+    {
+      words.push_back(line.substr(start, i - start));
+    }
+  }
+  return words;
+}
+
+// lines of a small file, without comments, which start by one of @c comments
+std::vector<std::vector<string>> readConfigFile(StringArg filename, const char* comments)
+{
+  std::vector<std::vector<string>> lines;
+  string content;
+  int err = FileUtil::readFile(filename, kMaxFileSize, &content);
+  if (err != 0)
+  {
+    LOG_WARN << "DnsResolver cannot read " << filename.c_str() << ": " << strerror_tl(err);
+    return lines;
+  }
+  size_t start = 0;
+  while (start < content.size())
+  {
+    size_t end = content.find('\n', start);
+    if (end == string::npos)
+    {
+      end = content.size();
+    }
+    string line = content.substr(start, end - start);
+    size_t comment = line.find_first_of(comments);
+    if (comment != string::npos)
+    {
+      line.resize(comment);
+    }
+    std::vector<string> words = splitWords(line);
+    if (!words.empty())
+    {
+      lines.push_back(std::move(words));
+    }
+    start = end + 1;
+  }
+  return lines;
+}
+
+InetAddress defaultNameServer()
+{
+  std::vector<std::vector<string>> lines = readConfigFile("/etc/resolv.conf", "#;");
+  for (const std::vector<string>& words : lines)
+  {
+    struct in_addr ip;
+    if (words.size() >= 2 && words[0] == "nameserver"
+        && ::inet_pton(AF_INET, words[1].c_str(), &ip) == 1)
+    {
+      return InetAddress(words[1], 53);
+    }
+  }
+  return InetAddress("127.0.0.1", 53);
+}
+
+InetAddress makeAddress(uint32_t ip, uint16_t port)
+{
+  struct sockaddr_in addr;
+  memZero(&addr, sizeof addr);
+  addr.sin_family = AF_INET;
+  addr.sin_port = sockets::hostToNetwork16(port);
+  addr.sin_addr.s_addr = ip;
+  return InetAddress(addr);
+}
+
+// never calls back within DnsResolver::resolve()
+void deliver(EventLoop* loop, const DnsResolver::Callback& cb,
+             bool resolved, uint32_t ip, uint16_t port)
+{
+  loop->queueInLoop(std::bind(cb, resolved, makeAddress(ip, port)));
+}
+
+}  // namespace
+
+DnsResolver::DnsResolver(EventLoop* loop)
+  : DnsResolver(loop, defaultNameServer(), "/etc/hosts")
+{
+}
+
+DnsResolver::DnsResolver(EventLoop* loop, const InetAddress& nameServer, StringArg hostsFile)
+  : loop_(CHECK_NOTNULL(loop)),
+    nameServer_(nameServer),
+    timeoutMs_(kDefaultTimeoutMs),
+    retries_(kDefaultRetries),
+    random_(std::random_device()()),
+    stats_(),
+    self_(std::make_shared<DnsResolver*>(this))
+{
+  if (hostsFile.c_str()[0] != '\0')
+  {
+    loadHosts(hostsFile);
+  }
+}
+
+DnsResolver::~DnsResolver()
+{
+  if (!queries_.empty())
+  {
+    LOG_WARN << "DnsResolver destroyed with " << queries_.size() << " queries in flight";
+  }
+  for (const auto& query : queries_)
+  {
+    loop_->cancel(query.second.timer);
+    // rather than waiting forever, eg. a Connector
+    for (const Waiter& waiter : query.second.waiters)
+    {
+      deliver(loop_, waiter.cb, false, INADDR_ANY, waiter.port);
+    }
+  }
+}
+
+void DnsResolver::resolve(const string& hostname, uint16_t port, Callback cb)
+{
+  if (loop_->isInLoopThread())
+  {
+    resolveInLoop(hostname, port, cb);
+  }
+  else
+  {
+    loop_->queueInLoop(
+        std::bind(&DnsResolver::queuedResolve, loop_, std::weak_ptr<DnsResolver*>(self_),
+                  hostname, port, std::move(cb)));
+  }
+}
+
+void DnsResolver::queuedResolve(EventLoop* loop,
+                                const std::weak_ptr<DnsResolver*>& weakSelf,
+                                const string& hostname, uint16_t port,
+                                const Callback& cb)
+{
+  std::shared_ptr<DnsResolver*> self(weakSelf.lock());
+  if (self)
+  {
+    (*self)->resolveInLoop(hostname, port, cb);
+  }
+  else
+  {
+    // destroyed, eg. replaced by EventLoop::setResolver(), as if in flight
+    deliver(loop, cb, false, INADDR_ANY, port);
+  }
+}
+
+void DnsResolver::resolveInLoop(const string& hostname, uint16_t port, const Callback& cb)
+{
+  loop_->assertInLoopThread();
+  ++stats_.lookups;
+  struct in_addr numeric;
+  if (::inet_pton(AF_INET, hostname.c_str(), &numeric) == 1)
+  {
+    deliver(loop_, cb, true, numeric.s_addr, port);
+    return;
+  }
+
+  const string name = canonicalName(hostname);
+  std::map<string, uint32_t>::const_iterator host = hosts_.find(name);
+  if (host != hosts_.end())
+  {
+    ++stats_.hostsHits;
+    deliver(loop_, cb, true, host->second, port);
+    return;
+  }
+
+  std::map<string, Entry>::iterator cached = cache_.find(name);
+  if (cached != cache_.end())
+  {
+    if (Timestamp::now() < cached->second.expiration)
+    {
+      ++stats_.cacheHits;
+      deliver(loop_, cb, cached->second.resolved, cached->second.ip, port);
+      return;
+    }
+    cache_.erase(cached);
+  }
+
+  std::map<string, Query>::iterator inFlight = queries_.find(name);
+  if (inFlight != queries_.end())
+  {
+    ++stats_.coalesced;
+    inFlight->second.waiters.push_back(Waiter{ port, cb });
+    return;
+  }
+
+  string probe;
+  if (!appendName(&probe, name))
+  {
+    LOG_ERROR << "DnsResolver invalid hostname " << hostname;
+    deliver(loop_, cb, false, INADDR_ANY, port);
+    return;
+  }
+  Query& query = queries_[name];
+  query.id = 0;
+  query.attempts = 0;
+  query.waiters.push_back(Waiter{ port, cb });
+  sendQuery(name, &query);
+}
+
+void DnsResolver::sendQuery(const string& name, Query* query)
+{
+  if (!socket_)
+  {
+    socket_.reset(new UdpSocket(loop_));
+    socket_->setBatch(8);
+    socket_->setMaxDatagramSize(512);  // without EDNS
+    socket_->setMessageCallback(
+        std::bind(&DnsResolver::onMessage, this, _1, _2, _3));
+    socket_->startReading();
+    if (!socket_->connect(nameServer_))
+    {
+      // times out, and tries again by the next attempt
+      LOG_ERROR << "DnsResolver cannot reach " << nameServer_.toIpPort();
+      socket_.reset();
+    }
+  }
+
+  uint16_t id;
+  do
+  {
+    id = static_cast<uint16_t>(random_());
+  } while (ids_.count(id));
+  ids_[id] = name;
+  query->id = id;
+  ++query->attempts;
+  ++stats_.queries;
+
+  string packet;
+  appendUint16(&packet, id);
+  appendUint16(&packet, kFlagRecursionDesired);
+  appendUint16(&packet, 1);  // questions
+  appendUint16(&packet, 0);
+  appendUint16(&packet, 0);
+  appendUint16(&packet, 0);
+  appendName(&packet, name);
+  appendUint16(&packet, kTypeA);
+  appendUint16(&packet, kClassIn);
+  if (socket_)
+  {
+    socket_->send(packet.data(), packet.size());
+  }
+
+  LOG_DEBUG << "DnsResolver query " << name << " id " << id
+            << " attempt " << query->attempts;
+  query->timer = loop_->runAfter(timeoutMs_ / 1000.0,
+                                 std::bind(&DnsResolver::onTimeout, this, name));
+}
+
+void DnsResolver::onTimeout(const string& name)
+{
+  std::map<string, Query>::iterator it = queries_.find(name);
+  if (it == queries_.end())
+  {
+    return;
+  }
+  Query& query = it->second;
+  ids_.erase(query.id);  // late answers are ignored
+  if (query.attempts <= retries_)
+  {
+    sendQuery(name, &query);
+  }
+  else
+  {
+    ++stats_.timeouts;
+    LOG_WARN << "DnsResolver " << name << " timed out after "
+             << query.attempts << " attempts";
+    finish(name, false, INADDR_ANY, 0);
+  }
+}
+
+void DnsResolver::onMessage(UdpSocket*, const std::vector<UdpDatagram>& datagrams,
+                         Timestamp receiveTime)
+{
+  for (const UdpDatagram& datagram : datagrams)
+  {
+    onResponse(datagram.data, datagram.size, receiveTime);
+  }
+}
+
+void DnsResolver::onResponse(const char* data, size_t len, Timestamp)
+{
+  const unsigned char* msg = reinterpret_cast<const unsigned char*>(data);
+  if (len < kHeaderSize)
+  {
+    return;
+  }
+  std::map<uint16_t, string>::iterator id = ids_.find(readUint16(msg));
+  if (id == ids_.end())
+  {
+    LOG_DEBUG << "DnsResolver unexpected response " << readUint16(msg);
+    return;
+  }
+  const uint16_t flags = readUint16(msg + 2);
+  const uint16_t questions = readUint16(msg + 4);
+  const uint16_t answers = readUint16(msg + 6);
+  size_t offset = kHeaderSize;
+  string qname;
+  // not an answer to our question, keep waiting
+  if (!(flags & kFlagResponse) || questions != 1
+      || !readName(msg, len, &offset, &qname) || qname != id->second
+      || offset + 4 > len || readUint16(msg + offset) != kTypeA)
+  {
+    LOG_WARN << "DnsResolver mismatched response of " << id->second;
+    return;
+  }
+  offset += 4;
+  const string name = id->second;
+  ids_.erase(id);
+
+  if (flags & kFlagTruncated)
+  {
+    LOG_WARN << "DnsResolver truncated response of " << name;
+    finish(name, false, INADDR_ANY, 0);
+    return;
+  }
+  const uint16_t rcode = flags & kRcodeMask;
+  if (rcode == kRcodeNameError)
+  {
+    finish(name, false, INADDR_ANY, kNegativeTtlSeconds);
+    return;
+  }
+  else if (rcode != 0)
+  {
+    LOG_WARN << "DnsResolver " << name << " rcode " << rcode;
+    finish(name, false, INADDR_ANY, 0);
+    return;
+  }
+
+  // the first A record, through CNAMEs, lives as long as the shortest of them
+  uint32_t ttl = kMaxTtlSeconds;
+  for (uint16_t i = 0; i < answers; ++i)
+  {
+    string owner;
+    if (!readName(msg, len, &offset, &owner) || offset + 10 > len)
+    {
+      break;
+    }
+    const uint16_t type = readUint16(msg + offset);
+    const uint16_t klass = readUint16(msg + offset + 2);
+    const uint32_t recordTtl = readUint32(msg + offset + 4);
+    const uint16_t rdlength = readUint16(msg + offset + 8);
+    offset += 10;
+    if (offset + rdlength > len)
+    {
+      break;
+    }
+    if (klass == kClassIn && (type == kTypeA || type == kTypeCname))
+    {
+      ttl = std::min(ttl, recordTtl);
+    }
+    if (klass == kClassIn && type == kTypeA && rdlength == 4)
+    {
+      uint32_t ip;
+      memcpy(&ip, msg + offset, sizeof ip);
+      finish(name, true, ip, static_cast<int>(ttl));
+      return;
+    }
+    offset += rdlength;
+  }
+  // no address of this name
+  finish(name, false, INADDR_ANY, kNegativeTtlSeconds);
+}
+
+void DnsResolver::finish(const string& name, bool resolved, uint32_t ip, int ttlSeconds)
+{
+  std::map<string, Query>::iterator it = queries_.find(name);
+  if (it == queries_.end())
+  {
+    return;
+  }
+  std::vector<Waiter> waiters;
+  waiters.swap(it->second.waiters);
+  loop_->cancel(it->second.timer);
+  queries_.erase(it);
+
+  if (ttlSeconds > 0)
+  {
+    addToCache(name, resolved, ip, ttlSeconds);
+  }
+  LOG_DEBUG << "DnsResolver " << name << (resolved ? " resolved" : " failed")
+            << " for " << waiters.size() << " waiters";
+  for (const Waiter& waiter : waiters)
+  {
+    deliver(loop_, waiter.cb, resolved, ip, waiter.port);
+  }
+}
+
+void DnsResolver::addToCache(const string& name, bool resolved, uint32_t ip, int ttlSeconds)
+{
+  const Timestamp now(Timestamp::now());
+  if (cache_.size() >= kMaxCacheEntries)
+  {
+    for (std::map<string, Entry>::iterator it = cache_.begin(); it != cache_.end(); )
+    {
+      if (it->second.expiration < now)
+      {
+        it = cache_.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    if (cache_.size() >= kMaxCacheEntries)
+    {
+      cache_.clear();
+    }
+  }
+  Entry& entry = cache_[name];
+  entry.resolved = resolved;
+  entry.ip = ip;
+  entry.expiration = addTime(now, std::min(ttlSeconds, static_cast<int>(kMaxTtlSeconds)));
+}
+
+void DnsResolver::loadHosts(StringArg hostsFile)
+{
+  std::vector<std::vector<string>> lines = readConfigFile(hostsFile, "#");
+  for (const std::vector<string>& words : lines)
+  {
+    struct in_addr ip;
+    if (::inet_pton(AF_INET, words[0].c_str(), &ip) != 1)
+    {
+      continue;  // IPv6 addresses, which we don't resolve
+    }
+    for (size_t i = 1; i < words.size(); ++i)
+    {
+      // the first line of a name wins
+      hosts_.insert(std::make_pair(canonicalName(words[i]), ip.s_addr));
+    }
+  }
+  LOG_DEBUG << "DnsResolver " << hosts_.size() << " names in " << hostsFile.c_str();
+}
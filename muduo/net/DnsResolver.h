@@ -0,0 +1,141 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_DNSRESOLVER_H
+#define MUDUO_NET_DNSRESOLVER_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TimerId.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class UdpSocket;
+struct UdpDatagram;
+
+///
+/// Non-blocking DNS resolver of IPv4 addresses, in an EventLoop.
+///
+/// Looks up the hosts file, then the cache, then asks the name server
+/// by UDP in the loop. Concurrent lookups of one name share a query,
+/// answers are cached for their TTL, and NXDOMAIN for a few seconds.
+/// Usually reached by EventLoop::resolver().
+class DnsResolver : noncopyable
+{
+ public:
+  typedef std::function<void (bool resolved, const InetAddress& addr)> Callback;
+
+  static const int kDefaultTimeoutMs = 2000;
+  static const int kDefaultRetries = 2;
+  static const int kMaxTtlSeconds = 3600;
+  static const int kNegativeTtlSeconds = 5;
+  static const size_t kMaxCacheEntries = 10000;
+
+  struct Stats
+  {
+    int64_t lookups;    // resolve() calls
+    int64_t hostsHits;  // answered by the hosts file
+    int64_t cacheHits;
+    int64_t coalesced;  // joined an in-flight query
+    int64_t queries;    // sent to the name server, with retries
+    int64_t timeouts;   // gave up after all retries
+  };
+
+  /// The first IPv4 name server of /etc/resolv.conf, and /etc/hosts.
+  explicit DnsResolver(EventLoop* loop);
+  /// An empty @c hostsFile reads no hosts file.
+  DnsResolver(EventLoop* loop, const InetAddress& nameServer, StringArg hostsFile);
+  /// Lookups still in flight fail.
+  ~DnsResolver();  // force out-line dtor, for std::unique_ptr members.
+
+  /// Per query attempt, and retries after the first attempt.
+  /// Must be called in the loop thread.
+  void setTimeout(int timeoutMs, int retries)
+  {
+    timeoutMs_ = timeoutMs;
+    retries_ = retries;
+  }
+
+  const InetAddress& nameServer() const { return nameServer_; }
+
+  ///
+  /// Resolves @c hostname, numeric or a name, to an address with @c port.
+  /// The callback runs in the loop thread, never within resolve().
+  /// Thread safe, from other threads it fails if this is destroyed,
+  /// eg. replaced by EventLoop::setResolver(), before the loop gets to it.
+  void resolve(const string& hostname, uint16_t port, Callback cb);
+
+  /// Must be called in the loop thread.
+  void clearCache() { cache_.clear(); }
+  size_t cacheSize() const { return cache_.size(); }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Waiter
+  {
+    uint16_t port;
+    Callback cb;
+  };
+
+  struct Query
+  {
+    uint16_t id;
+    int attempts;
+    TimerId timer;
+    std::vector<Waiter> waiters;
+  };
+
+  struct Entry
+  {
+    bool resolved;
+    uint32_t ip;  // network byte order
+    Timestamp expiration;
+  };
+
+  void resolveInLoop(const string& hostname, uint16_t port, const Callback& cb);
+  static void queuedResolve(EventLoop* loop,
+                            const std::weak_ptr<DnsResolver*>& weakSelf,
+                            const string& hostname, uint16_t port,
+                            const Callback& cb);
+  void sendQuery(const string& name, Query* query);
+  void onTimeout(const string& name);
+  void onMessage(UdpSocket*, const std::vector<UdpDatagram>& datagrams, Timestamp);
+  void onResponse(const char* data, size_t len, Timestamp receiveTime);
+  void finish(const string& name, bool resolved, uint32_t ip, int ttlSeconds);
+  void addToCache(const string& name, bool resolved, uint32_t ip, int ttlSeconds);
+  void loadHosts(StringArg hostsFile);
+
+  EventLoop* loop_;
+  InetAddress nameServer_;
+  // created in the loop thread, by the first query
+  std::unique_ptr<UdpSocket> socket_;
+  int timeoutMs_;
+  int retries_;
+  std::map<string, uint32_t> hosts_;
+  std::map<string, Entry> cache_;
+  std::map<string, Query> queries_;  // in flight, by name
+  std::map<uint16_t, string> ids_;   // in flight, by query id
+  std::mt19937 random_;
+  Stats stats_;
+  // lookups queued by other threads hold it weakly, in case this is gone
+  std::shared_ptr<DnsResolver*> self_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_DNSRESOLVER_H
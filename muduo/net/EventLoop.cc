@@ -10,7 +10,10 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/net/BufferPool.h"
 #include "muduo/net/Channel.h"
+#include "muduo/net/DnsResolver.h"
+#include "muduo/net/IdleWheel.h"
 #include "muduo/net/Poller.h"
 #include "muduo/net/SocketsOps.h"
 #include "muduo/net/TimerQueue.h"
@@ -54,8 +57,28 @@ class IgnoreSigPipe
 #pragma GCC diagnostic error "-Wold-style-cast"
 
 IgnoreSigPipe initObj;
+
+int64_t microSecondsBetween(Timestamp start, Timestamp end)
+{
+  return end.microSecondsSinceEpoch() - start.microSecondsSinceEpoch();
+}
 }  // namespace
 
+struct EventLoop::PendingFunctor
+{
+  PendingFunctor()
+    : next(NULL)
+  { }
+
+  explicit PendingFunctor(Functor&& cb)
+    : next(NULL),
+      functor(std::move(cb))
+  { }
+
+  std::atomic<PendingFunctor*> next;
+  Functor functor;
+};
+
 EventLoop* EventLoop::getEventLoopOfCurrentThread()
 {
   return t_loopInThisThread;
@@ -68,11 +91,25 @@ EventLoop::EventLoop()
     callingPendingFunctors_(false),
     iteration_(0),
     threadId_(CurrentThread::tid()),
+    busyPollMicroSeconds_(0),
+    spinPolls_(0),
+    spinHits_(0),
+    blockingPolls_(0),
+    spinMicroSeconds_(0),
+    blockMicroSeconds_(0),
+    slowCallbackMicroSeconds_(0),
+    bufferPool_(new BufferPool),
     poller_(Poller::newDefaultPoller(this)),
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    pendingTail_(new PendingFunctor),
+    functorsQueued_(0),
+    functorsRun_(0),
+    wakeupPending_(false),
+    pendingHead_(pendingTail_),
+    numConnections_(0)
 {
   LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
   if (t_loopInThisThread)
@@ -94,10 +131,18 @@ EventLoop::~EventLoop()
 {
   LOG_DEBUG << "EventLoop " << this << " of thread " << threadId_
             << " destructs in thread " << CurrentThread::tid();
+  // it queues the failures of its lookups, while the queue is there
+  resolver_.reset();
   wakeupChannel_->disableAll();
   wakeupChannel_->remove();
   ::close(wakeupFd_);
   t_loopInThisThread = NULL;
+  while (pendingTail_)
+  {
+    PendingFunctor* next = pendingTail_->next.load(std::memory_order_acquire);
+    delete pendingTail_;
+    pendingTail_ = next;
+  }
 }
 
 void EventLoop::loop()
@@ -108,31 +153,172 @@ void EventLoop::loop()
   quit_ = false;  // FIXME: what if someone calls quit() before loop() ?
   LOG_TRACE << "EventLoop " << this << " start looping";
 
+  Timestamp iterationEnd;  // of the last one, with health stats only
   while (!quit_)
   {
     activeChannels_.clear();
-    pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+    poll();
     ++iteration_;
+    if (activeChannels_.empty())
+    {
+      // idle for kPollTimeMs, gives cached Buffer storage back
+      bufferPool_->trim(0);
+    }
     if (Logger::logLevel() <= Logger::TRACE)
     {
       printActiveChannels();
     }
+    if (health_ && iterationEnd.valid())
+    {
+      health_->pollWait.add(microSecondsBetween(iterationEnd, pollReturnTime_));
+    }
     // TODO sort channel by priority
     eventHandling_ = true;
-    for (Channel* channel : activeChannels_)
+    handleActiveChannels();
+    eventHandling_ = false;
+    if (health_)
     {
-      currentActiveChannel_ = channel;
-      currentActiveChannel_->handleEvent(pollReturnTime_);
+      const Timestamp callbacksEnd(Timestamp::now());
+      health_->channelCallbacks.add(microSecondsBetween(pollReturnTime_, callbacksEnd));
+      health_->functorBacklog.add(
+          static_cast<int64_t>(queueSize()));
+      doPendingFunctors();
+      iterationEnd = Timestamp::now();
+      if (health_)  // may be reset by a functor
+      {
+        health_->pendingFunctors.add(microSecondsBetween(callbacksEnd, iterationEnd));
+      }
+    }
+    else
+    {
+      doPendingFunctors();
+      iterationEnd = Timestamp::invalid();
     }
-    currentActiveChannel_ = NULL;
-    eventHandling_ = false;
-    doPendingFunctors();
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
   looping_ = false;
 }
 
+void EventLoop::handleActiveChannels()
+{
+  const bool watching = health_ && slowCallbackMicroSeconds_ > 0;
+  Timestamp start(pollReturnTime_);
+  for (Channel* channel : activeChannels_)
+  {
+    currentActiveChannel_ = channel;
+    currentActiveChannel_->handleEvent(pollReturnTime_);
+    if (watching)
+    {
+      const Timestamp end(Timestamp::now());
+      const int64_t used = microSecondsBetween(start, end);
+      if (used > slowCallbackMicroSeconds_)
+      {
+        ++health_->slowCallbacks;
+        LOG_WARN << "EventLoop::loop() - slow callback of {"
+                 << channel->reventsToString() << "} took " << used << " us";
+      }
+      start = end;
+    }
+  }
+  currentActiveChannel_ = NULL;
+}
+
+void EventLoop::poll()
+{
+  if (busyPollMicroSeconds_ <= 0)
+  {
+    blockingPoll(kPollTimeMs);
+    return;
+  }
+
+  const Timestamp start(Timestamp::now());
+  const Timestamp deadline(start.microSecondsSinceEpoch() + busyPollMicroSeconds_);
+  int64_t spins = 0;
+  do
+  {
+    pollReturnTime_ = poller_->poll(0, &activeChannels_);
+    ++spins;
+  } while (activeChannels_.empty() && !quit_ && pollReturnTime_ < deadline);
+  spinPolls_.fetch_add(spins, std::memory_order_relaxed);
+  spinMicroSeconds_.fetch_add(
+      pollReturnTime_.microSecondsSinceEpoch() - start.microSecondsSinceEpoch(),
+      std::memory_order_relaxed);
+
+  if (!activeChannels_.empty())
+  {
+    spinHits_.fetch_add(1, std::memory_order_relaxed);
+  }
+  else if (!quit_)
+  {
+    blockingPoll(kPollTimeMs);
+  }
+}
+
+void EventLoop::blockingPoll(int timeoutMs)
+{
+  const Timestamp start(Timestamp::now());
+  pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_);
+  blockingPolls_.fetch_add(1, std::memory_order_relaxed);
+  blockMicroSeconds_.fetch_add(
+      pollReturnTime_.microSecondsSinceEpoch() - start.microSecondsSinceEpoch(),
+      std::memory_order_relaxed);
+}
+
+EventLoop::PollStats EventLoop::pollStats() const
+{
+  PollStats stats;
+  stats.spinPolls = spinPolls_.load(std::memory_order_relaxed);
+  stats.spinHits = spinHits_.load(std::memory_order_relaxed);
+  stats.blockingPolls = blockingPolls_.load(std::memory_order_relaxed);
+  stats.spinMicroSeconds = spinMicroSeconds_.load(std::memory_order_relaxed);
+  stats.blockMicroSeconds = blockMicroSeconds_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void EventLoop::enableHealthStats(int slowCallbackMicroSeconds)
+{
+  if (!health_)
+  {
+    health_.reset(new HealthStats);
+    health_->slowCallbacks = 0;
+  }
+  slowCallbackMicroSeconds_ = slowCallbackMicroSeconds;
+}
+
+EventLoop::HealthStats EventLoop::healthStats() const
+{
+  if (health_)
+  {
+    return *health_;
+  }
+  HealthStats empty;
+  empty.slowCallbacks = 0;
+  return empty;
+}
+
+void EventLoop::resetHealthStats()
+{
+  assertInLoopThread();
+  if (health_)
+  {
+    health_->pollWait.reset();
+    health_->channelCallbacks.reset();
+    health_->pendingFunctors.reset();
+    health_->functorBacklog.reset();
+    health_->timerLateness.reset();
+    health_->slowCallbacks = 0;
+  }
+}
+
+void EventLoop::recordTimerLateness(Timestamp expiration, Timestamp now)
+{
+  if (health_)
+  {
+    health_->timerLateness.add(microSecondsBetween(expiration, now));
+  }
+}
+
 void EventLoop::quit()
 {
   quit_ = true;
@@ -159,21 +345,76 @@ void EventLoop::runInLoop(Functor cb)
 
 void EventLoop::queueInLoop(Functor cb)
 {
+  PendingFunctor* node = new PendingFunctor(std::move(cb));
+  pushPendingFunctors(node, node, 1);
+}
+
+void EventLoop::queueAllInLoop(std::vector<Functor> cbs)
+{
+  if (cbs.empty())
+  {
+    return;
+  }
+  // links them up privately, then publishes them at once
+  PendingFunctor* first = new PendingFunctor(std::move(cbs[0]));
+  PendingFunctor* last = first;
+  for (size_t i = 1; i < cbs.size(); ++i)
   {
-  MutexLockGuard lock(mutex_);
-  pendingFunctors_.push_back(std::move(cb));
+    PendingFunctor* node = new PendingFunctor(std::move(cbs[i]));
+    last->next.store(node, std::memory_order_relaxed);
+    last = node;
   }
+  pushPendingFunctors(first, last, cbs.size());
+}
+
+void EventLoop::pushPendingFunctors(PendingFunctor* first, PendingFunctor* last, size_t n)
+{
+  functorsQueued_.fetch_add(n, std::memory_order_relaxed);
+  PendingFunctor* prev = pendingHead_.exchange(last, std::memory_order_acq_rel);
+  // the queue is broken between prev and first until this line,
+  // doPendingFunctors() stops there, we wakeup() below to resume it.
+  prev->next.store(first, std::memory_order_release);
 
   if (!isInLoopThread() || callingPendingFunctors_)
   {
-    wakeup();
+    // only the first one since doPendingFunctors() writes the eventfd
+    if (!wakeupPending_.exchange(true, std::memory_order_acq_rel))
+    {
+      wakeup();
+    }
   }
 }
 
 size_t EventLoop::queueSize() const
 {
-  MutexLockGuard lock(mutex_);
-  return pendingFunctors_.size();
+  // run first, the functors it counts are counted by queued already
+  const uint64_t run = functorsRun_.load(std::memory_order_acquire);
+  return static_cast<size_t>(functorsQueued_.load(std::memory_order_relaxed) - run);
+}
+
+DnsResolver* EventLoop::resolver()
+{
+  assertInLoopThread();
+  if (!resolver_)
+  {
+    resolver_.reset(new DnsResolver(this));
+  }
+  return resolver_.get();
+}
+
+void EventLoop::setResolver(std::unique_ptr<DnsResolver> resolver)
+{
+  assertInLoopThread();
+  resolver_ = std::move(resolver);
+}
+
+IdleWheel* EventLoop::idleWheel()
+{
+  if (!idleWheel_)
+  {
+    idleWheel_.reset(new IdleWheel(this));
+  }
+  return idleWheel_.get();
 }
 
 TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
@@ -224,6 +465,11 @@ bool EventLoop::hasChannel(Channel* channel)
   return poller_->hasChannel(channel);
 }
 
+bool EventLoop::supportsEdgeTriggered() const
+{
+  return poller_->supportsEdgeTriggered();
+}
+
 void EventLoop::abortNotInLoopThread()
 {
   LOG_FATAL << "EventLoop::abortNotInLoopThread - EventLoop " << this
@@ -253,16 +499,28 @@ void EventLoop::handleRead()
 
 void EventLoop::doPendingFunctors()
 {
-  std::vector<Functor> functors;
   callingPendingFunctors_ = true;
+  // from now on, producers have to wakeup() again.
+  // exchange, not store, to see the links of those who didn't.
+  wakeupPending_.exchange(false, std::memory_order_acq_rel);
 
+  // those queued so far, functors queued by functors run in next iteration
+  PendingFunctor* last = pendingHead_.load(std::memory_order_acquire);
+  while (pendingTail_ != last)
   {
-  MutexLockGuard lock(mutex_);
-  functors.swap(pendingFunctors_);
-  }
-
-  for (const Functor& functor : functors)
-  {
+    PendingFunctor* next = pendingTail_->next.load(std::memory_order_acquire);
+    if (next == NULL)
+    {
+      // being linked, its producer will wakeup() us
+      break;
+    }
+    delete pendingTail_;
+    pendingTail_ = next;
+    Functor functor;
+    functor.swap(next->functor);
+    // not pending while it runs, for leastQueueSize()
+    functorsRun_.store(functorsRun_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
     functor();
   }
   callingPendingFunctors_ = false;
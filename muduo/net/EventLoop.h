@@ -19,6 +19,7 @@
 
 #include "muduo/base/Mutex.h"
 #include "muduo/base/CurrentThread.h"
+#include "muduo/base/Histogram.h"
 #include "muduo/base/Timestamp.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/TimerId.h"
@@ -28,8 +29,11 @@ namespace muduo
 namespace net
 {
 
+class BufferPool;
 class Channel;
 class Poller;
+class DnsResolver;
+class IdleWheel;
 class TimerQueue;
 
 ///
@@ -41,6 +45,28 @@ class EventLoop : noncopyable
  public:
   typedef std::function<void()> Functor;
 
+  /// Time spent in Poller::poll(), see setBusyPoll().
+  struct PollStats
+  {
+    int64_t spinPolls;          // zero-timeout polls
+    int64_t spinHits;           // spins which found events
+    int64_t blockingPolls;      // polls which may sleep
+    int64_t spinMicroSeconds;   // busy, but nothing to do
+    int64_t blockMicroSeconds;  // asleep
+  };
+
+  /// Where the time of an iteration goes, in microseconds unless noted,
+  /// see enableHealthStats().
+  struct HealthStats
+  {
+    Histogram pollWait;          // in Poller::poll(), incl. busy polling
+    Histogram channelCallbacks;  // handling all active channels of an iteration
+    Histogram pendingFunctors;   // in doPendingFunctors()
+    Histogram functorBacklog;    // queued functors, in number, per iteration
+    Histogram timerLateness;     // run time of timers past their expiration
+    int64_t slowCallbacks;       // channel callbacks over the threshold
+  };
+
   EventLoop();
   ~EventLoop();  // force out-line dtor, for std::unique_ptr members.
 
@@ -64,6 +90,37 @@ class EventLoop : noncopyable
 
   int64_t iteration() const { return iteration_; }
 
+  ///
+  /// Spins on zero-timeout polls for up to @c microSeconds before blocking,
+  /// trades a CPU for the wakeup latency of a sleeping thread.
+  /// 0 means always blocking, the default.
+  /// Must be called in the loop thread, or before loop().
+  ///
+  void setBusyPoll(int microSeconds)
+  { busyPollMicroSeconds_ = microSeconds; }
+  int busyPoll() const { return busyPollMicroSeconds_; }
+
+  /// Thread safe.
+  PollStats pollStats() const;
+
+  ///
+  /// Records HealthStats from now on, at the cost of two clock readings
+  /// per iteration, plus one per active channel if @c slowCallbackMicroSeconds,
+  /// and two per MessageCallback, for TcpConnection::Stats.
+  /// Logs a channel callback longer than @c slowCallbackMicroSeconds,
+  /// 0 for not watching them.
+  /// Must be called in the loop thread, or before loop().
+  ///
+  void enableHealthStats(int slowCallbackMicroSeconds = 0);
+  bool healthStatsEnabled() const { return health_ != NULL; }
+  /// A copy, empty if not enabled.
+  /// Must be called in the loop thread.
+  HealthStats healthStats() const;
+  /// Must be called in the loop thread.
+  void resetHealthStats();
+  /// Internal use only, by TimerQueue, if health stats are enabled.
+  void recordTimerLateness(Timestamp expiration, Timestamp now);
+
   /// Runs callback immediately in the loop thread.
   /// It wakes up the loop, and run the cb.
   /// If in the same loop thread, cb is run within the function.
@@ -73,8 +130,25 @@ class EventLoop : noncopyable
   /// Runs after finish pooling.
   /// Safe to call from other threads.
   void queueInLoop(Functor cb);
+  /// Queues callbacks in the loop thread, in order,
+  /// at the cost of one queueInLoop().
+  /// Safe to call from other threads.
+  void queueAllInLoop(std::vector<Functor> cbs);
 
   size_t queueSize() const;
+  /// Functors ever queued, it moves whenever one is queued.  Thread safe.
+  uint64_t functorsQueued() const
+  { return functorsQueued_.load(std::memory_order_relaxed); }
+
+  /// TcpConnections of this loop, for load balancing.  Thread safe.
+  int numConnections() const
+  { return numConnections_.load(std::memory_order_relaxed); }
+  /// Internal use only, by TcpConnection.
+  void countConnection(int delta)
+  { numConnections_.fetch_add(delta, std::memory_order_relaxed); }
+  /// Internal use only, by TcpConnection.
+  /// Created by the first connection with an idle timeout.
+  IdleWheel* idleWheel();
 
   // timers
 
@@ -104,6 +178,7 @@ class EventLoop : noncopyable
   void updateChannel(Channel* channel);
   void removeChannel(Channel* channel);
   bool hasChannel(Channel* channel);
+  bool supportsEdgeTriggered() const;
 
   // pid_t threadId() const { return threadId_; }
   void assertInLoopThread()
@@ -126,13 +201,32 @@ class EventLoop : noncopyable
   boost::any* getMutableContext()
   { return &context_; }
 
+  /// Caches Buffer storage of this loop, trimmed when the loop is idle.
+  BufferPool* bufferPool() const { return bufferPool_.get(); }
+
+  /// Resolves hostnames without blocking this loop,
+  /// created by the first call, with the name server of /etc/resolv.conf.
+  /// Must be called in the loop thread.
+  DnsResolver* resolver();
+  /// Replaces the resolver, eg. to use another name server,
+  /// lookups in flight of the old one fail.
+  /// Must be called in the loop thread.
+  void setResolver(std::unique_ptr<DnsResolver> resolver);
+
   static EventLoop* getEventLoopOfCurrentThread();
 
  private:
   void abortNotInLoopThread();
   void handleRead();  // waked up
+  void poll();
+  void blockingPoll(int timeoutMs);
   void doPendingFunctors();
 
+  void handleActiveChannels();
+
+  struct PendingFunctor;
+  void pushPendingFunctors(PendingFunctor* first, PendingFunctor* last, size_t n);
+
   void printActiveChannels() const; // DEBUG
 
   typedef std::vector<Channel*> ChannelList;
@@ -144,20 +238,43 @@ class EventLoop : noncopyable
   int64_t iteration_;
   const pid_t threadId_;
   Timestamp pollReturnTime_;
+  int busyPollMicroSeconds_;
+  std::atomic<int64_t> spinPolls_;
+  std::atomic<int64_t> spinHits_;
+  std::atomic<int64_t> blockingPolls_;
+  std::atomic<int64_t> spinMicroSeconds_;
+  std::atomic<int64_t> blockMicroSeconds_;
+  std::unique_ptr<HealthStats> health_;  // NULL if not enabled
+  int slowCallbackMicroSeconds_;
+  // constructed first, destroyed last, after Buffers of this loop
+  std::unique_ptr<BufferPool> bufferPool_;
   std::unique_ptr<Poller> poller_;
   std::unique_ptr<TimerQueue> timerQueue_;
   int wakeupFd_;
   // unlike in TimerQueue, which is an internal class,
   // we don't expose Channel to client.
   std::unique_ptr<Channel> wakeupChannel_;
+  // destroyed before the poller and timers, which it uses
+  std::unique_ptr<DnsResolver> resolver_;
+  std::unique_ptr<IdleWheel> idleWheel_;
   boost::any context_;
 
   // scratch variables
   ChannelList activeChannels_;
   Channel* currentActiveChannel_;
 
-  mutable MutexLock mutex_;
-  std::vector<Functor> pendingFunctors_ GUARDED_BY(mutex_);
+  // Intrusive lock-free MPSC queue of pending functors,
+  // other threads push at head, the loop pops from tail.
+  // pendingTail_ is a dummy, which is run already.
+  PendingFunctor* pendingTail_;
+  // ever queued and run, queueSize() is the difference
+  std::atomic<uint64_t> functorsQueued_;
+  std::atomic<uint64_t> functorsRun_;
+  // the loop is going to run doPendingFunctors(), no need to wakeup()
+  std::atomic<bool> wakeupPending_;
+  std::atomic<PendingFunctor*> pendingHead_;
+
+  std::atomic<int> numConnections_;
 };
 
 }  // namespace net
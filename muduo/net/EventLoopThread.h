@@ -30,6 +30,10 @@ class EventLoopThread : noncopyable
   EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback(),
                   const string& name = string());
   ~EventLoopThread();
+
+  /// Pins the thread to @c cpu, before the EventLoop is created.
+  /// Must be called before startLoop().
+  void setCpu(int cpu) { thread_.setCpu(cpu); }
   EventLoop* startLoop();
 
  private:
@@ -30,7 +30,8 @@ EventLoopThreadPool::~EventLoopThreadPool()
   // Don't delete loop, it's stack variable
 }
 
-void EventLoopThreadPool::start(const ThreadInitCallback& cb)
+void EventLoopThreadPool::start(const ThreadInitCallback& cb,
+                                const CpuAffinity& affinity)
 {
   assert(!started_);
   baseLoop_->assertInLoopThread();
@@ -42,6 +43,7 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
     char buf[name_.size() + 32];
     snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
     EventLoopThread* t = new EventLoopThread(cb, buf);
+    t->setCpu(affinity.cpuOf(i));
     threads_.push_back(std::unique_ptr<EventLoopThread>(t));
     loops_.push_back(t->startLoop());
   }
@@ -57,7 +59,11 @@ EventLoop* EventLoopThreadPool::getNextLoop()
   assert(started_);
   EventLoop* loop = baseLoop_;
 
-  if (!loops_.empty())
+  if (selector_ && !loops_.empty())
+  {
+    loop = selector_(loops_);
+  }
+  else if (!loops_.empty())
   {
     // round-robin
     loop = loops_[next_];
@@ -70,6 +76,69 @@ EventLoop* EventLoopThreadPool::getNextLoop()
   return loop;
 }
 
+EventLoop* EventLoopThreadPool::leastConnections(const std::vector<EventLoop*>& loops)
+{
+  assert(!loops.empty());
+  EventLoop* least = loops[0];
+  int leastConnections = least->numConnections();
+  for (size_t i = 1; i < loops.size(); ++i)
+  {
+    int n = loops[i]->numConnections();
+    if (n < leastConnections)
+    {
+      least = loops[i];
+      leastConnections = n;
+    }
+  }
+  return least;
+}
+
+EventLoop* EventLoopThreadPool::leastQueueSize(const std::vector<EventLoop*>& loops)
+{
+  assert(!loops.empty());
+  EventLoop* least = loops[0];
+  size_t leastQueueSize = least->queueSize();
+  int leastConnections = least->numConnections();
+  for (size_t i = 1; i < loops.size(); ++i)
+  {
+    size_t queueSize = loops[i]->queueSize();
+    int n = loops[i]->numConnections();
+    if (queueSize < leastQueueSize
+        || (queueSize == leastQueueSize && n < leastConnections))
+    {
+      least = loops[i];
+      leastQueueSize = queueSize;
+      leastConnections = n;
+    }
+  }
+  return least;
+}
+
+EventLoop* EventLoopThreadPool::powerOfTwoChoices(const std::vector<EventLoop*>& loops)
+{
+  assert(!loops.empty());
+  // xorshift, good enough for picking
+  static __thread uint32_t t_seed = 0;
+  if (t_seed == 0)
+  {
+    t_seed = static_cast<uint32_t>(CurrentThread::tid()) | 1;
+  }
+  t_seed ^= t_seed << 13;
+  t_seed ^= t_seed >> 17;
+  t_seed ^= t_seed << 5;
+  const size_t n = loops.size();
+  if (n == 1)
+  {
+    return loops[0];
+  }
+  const size_t first = t_seed % n;
+  // one of the other n-1 loops
+  const size_t second = (first + 1 + (t_seed >> 16) % (n - 1)) % n;
+  EventLoop* a = loops[first];
+  EventLoop* b = loops[second];
+  return a->numConnections() <= b->numConnections() ? a : b;
+}
+
 EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode)
 {
   baseLoop_->assertInLoopThread();
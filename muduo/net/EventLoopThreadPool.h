@@ -12,6 +12,7 @@
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include "muduo/base/noncopyable.h"
+#include "muduo/base/CpuAffinity.h"
 #include "muduo/base/Types.h"
 
 #include <functional>
@@ -31,14 +32,30 @@ class EventLoopThreadPool : noncopyable
 {
  public:
   typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  /// Picks one of the loops, called in base loop.
+  typedef std::function<EventLoop*(const std::vector<EventLoop*>&)> LoopSelector;
 
   EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg);
   ~EventLoopThreadPool();
   void setThreadNum(int numThreads) { numThreads_ = numThreads; }
-  void start(const ThreadInitCallback& cb = ThreadInitCallback());
+  /// Loop i runs on affinity.cpuOf(i), if pinned.  The base loop is not pinned.
+  void start(const ThreadInitCallback& cb = ThreadInitCallback(),
+             const CpuAffinity& affinity = CpuAffinity());
+
+  /// Replaces round-robin of getNextLoop(), eg. with one of below.
+  void setLoopSelector(const LoopSelector& selector)
+  { selector_ = selector; }
+
+  /// The loop with the fewest TcpConnections.
+  static EventLoop* leastConnections(const std::vector<EventLoop*>& loops);
+  /// The loop with the fewest pending functors, then the fewest connections.
+  static EventLoop* leastQueueSize(const std::vector<EventLoop*>& loops);
+  /// The one with fewer connections of two random loops,
+  /// close to leastConnections() without scanning every loop.
+  static EventLoop* powerOfTwoChoices(const std::vector<EventLoop*>& loops);
 
   // valid after calling start()
-  /// round-robin
+  /// round-robin, or by the selector
   EventLoop* getNextLoop();
 
   /// with the same hash code, it will always return the same EventLoop
@@ -61,6 +78,7 @@ class EventLoopThreadPool : noncopyable
   int next_;
   std::vector<std::unique_ptr<EventLoopThread>> threads_;
   std::vector<EventLoop*> loops_;
+  LoopSelector selector_;
 };
 
 }  // namespace net
@@ -0,0 +1,140 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/IdleWheel.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpConnection.h"
+
+#include <algorithm>
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int IdleWheel::kBuckets;
+const int64_t IdleWheel::kTickMicroSeconds;
+
+IdleWheel::IdleWheel(EventLoop* loop)
+  : loop_(loop),
+    ticking_(false),
+    current_(0),
+    size_(0)
+{
+  memZero(buckets_, sizeof buckets_);
+}
+
+int64_t IdleWheel::tickOf(int64_t microSeconds)
+{
+  // rounds up, never expires early
+  return (microSeconds + kTickMicroSeconds - 1) / kTickMicroSeconds;
+}
+
+void IdleWheel::add(TcpConnection* conn)
+{
+  loop_->assertInLoopThread();
+  assert(conn->idleBucket_ < 0);
+  assert(conn->idleTimeout_ > 0);
+  if (!ticking_)
+  {
+    current_ = Timestamp::now().microSecondsSinceEpoch() / kTickMicroSeconds;
+    timer_ = loop_->runEvery(
+        static_cast<double>(kTickMicroSeconds) / Timestamp::kMicroSecondsPerSecond,
+        std::bind(&IdleWheel::onTick, this));
+    ticking_ = true;
+  }
+  link(conn, tickOf(conn->lastActive_ + conn->idleTimeout_));
+  ++size_;
+}
+
+void IdleWheel::remove(TcpConnection* conn)
+{
+  loop_->assertInLoopThread();
+  assert(conn->idleBucket_ >= 0);
+  if (conn->idlePrev_)
+  {
+    conn->idlePrev_->idleNext_ = conn->idleNext_;
+  }
+  else
+  {
+    buckets_[conn->idleBucket_] = conn->idleNext_;
+  }
+  if (conn->idleNext_)
+  {
+    conn->idleNext_->idlePrev_ = conn->idlePrev_;
+  }
+  conn->idlePrev_ = NULL;
+  conn->idleNext_ = NULL;
+  conn->idleBucket_ = -1;
+  --size_;
+}
+
+void IdleWheel::link(TcpConnection* conn, int64_t tick)
+{
+  tick = std::min(std::max(tick, current_), current_ + kBuckets - 1);
+  const int bucket = static_cast<int>(tick % kBuckets);
+  conn->idleBucket_ = bucket;
+  conn->idlePrev_ = NULL;
+  conn->idleNext_ = buckets_[bucket];
+  if (conn->idleNext_)
+  {
+    conn->idleNext_->idlePrev_ = conn;
+  }
+  buckets_[bucket] = conn;
+}
+
+void IdleWheel::expire(int bucket, int64_t now)
+{
+  TcpConnection* conn = buckets_[bucket];
+  buckets_[bucket] = NULL;
+  while (conn)
+  {
+    TcpConnection* next = conn->idleNext_;
+    const int64_t deadline = conn->lastActive_ + conn->idleTimeout_;
+    if (deadline <= now)
+    {
+      conn->idlePrev_ = NULL;
+      conn->idleNext_ = NULL;
+      conn->idleBucket_ = -1;
+      --size_;
+      expired_.push_back(conn->shared_from_this());
+    }
+    else
+    {
+      // active since linked, later than this tick for sure
+      link(conn, tickOf(deadline));
+    }
+    conn = next;
+  }
+}
+
+void IdleWheel::onTick()
+{
+  const int64_t now = Timestamp::now().microSecondsSinceEpoch();
+  const int64_t nowTick = now / kTickMicroSeconds;
+  // one round at most, if this loop was stuck for long
+  current_ = std::max(current_, nowTick - kBuckets + 1);
+  while (current_ <= nowTick)
+  {
+    expire(static_cast<int>(current_ % kBuckets), now);
+    ++current_;
+  }
+
+  if (!expired_.empty())
+  {
+    LOG_INFO << "IdleWheel closes " << expired_.size() << " idle connections";
+    for (const TcpConnectionPtr& conn : expired_)
+    {
+      conn->forceCloseInLoop();
+    }
+    expired_.clear();
+  }
+  if (size_ == 0)
+  {
+    loop_->cancel(timer_);
+    ticking_ = false;
+  }
+}
@@ -0,0 +1,65 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_IDLEWHEEL_H
+#define MUDUO_NET_IDLEWHEEL_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/net/Callbacks.h"
+#include "muduo/net/TimerId.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class TcpConnection;
+
+///
+/// Connections of one loop with an idle timeout, in buckets of 100ms ticks.
+///
+/// A connection is linked intrusively into the bucket of its deadline,
+/// its reads and writes only stamp the last activity.  When the bucket
+/// comes, active ones move on to the bucket of their new deadline,
+/// idle ones are closed all at once.  Deadlines beyond the wheel wait
+/// in its last bucket.  One timer per loop, running while not empty.
+///
+/// Connections are never closed early, but may be late by two ticks.
+class IdleWheel : noncopyable
+{
+ public:
+  static const int kBuckets = 1024;
+  static const int64_t kTickMicroSeconds = 100*1000;
+
+  explicit IdleWheel(EventLoop* loop);
+
+  void add(TcpConnection* conn);
+  void remove(TcpConnection* conn);
+  size_t size() const { return size_; }
+
+ private:
+  void onTick();
+  static int64_t tickOf(int64_t microSeconds);
+  void link(TcpConnection* conn, int64_t tick);
+  void expire(int bucket, int64_t now);
+
+  EventLoop* loop_;
+  TimerId timer_;
+  bool ticking_;
+  int64_t current_;  // the next tick to process
+  size_t size_;
+  TcpConnection* buckets_[kBuckets];
+  std::vector<TcpConnectionPtr> expired_;  // scratch
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_IDLEWHEEL_H
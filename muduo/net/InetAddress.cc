@@ -14,6 +14,8 @@
 
 #include <netdb.h>
 #include <netinet/in.h>
+#include <stddef.h>
+#include <string.h>
 
 // INADDR_ANY use (type)value casting.
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -45,12 +47,38 @@ static const in_addr_t kInaddrLoopback = INADDR_LOOPBACK;
 using namespace muduo;
 using namespace muduo::net;
 
-static_assert(sizeof(InetAddress) == sizeof(struct sockaddr_in6),
-              "InetAddress is same size as sockaddr_in6");
+static_assert(sizeof(InetAddress) == sizeof(struct sockaddr_un) + 2,
+              "InetAddress is sockaddr_un aligned to 4 bytes");
+static_assert(sizeof(InetAddress) <= sizeof(struct sockaddr_storage),
+              "InetAddress fits in sockaddr_storage");
 static_assert(offsetof(sockaddr_in, sin_family) == 0, "sin_family offset 0");
 static_assert(offsetof(sockaddr_in6, sin6_family) == 0, "sin6_family offset 0");
 static_assert(offsetof(sockaddr_in, sin_port) == 2, "sin_port offset 2");
 static_assert(offsetof(sockaddr_in6, sin6_port) == 2, "sin6_port offset 2");
+static_assert(offsetof(sockaddr_un, sun_family) == 0, "sun_family offset 0");
+
+namespace
+{
+
+// "unix:path", "unix:@name" of the abstract namespace, "unix:" if unbound
+string unixPath(const struct sockaddr_un& addr)
+{
+  const char* path = addr.sun_path;
+  const size_t maxLen = sizeof addr.sun_path;
+  string result("unix:");
+  if (path[0] != '\0')
+  {
+    result.append(path, ::strnlen(path, maxLen));
+  }
+  else if (path[1] != '\0')
+  {
+    result += '@';
+    result.append(path + 1, ::strnlen(path + 1, maxLen - 1));
+  }
+  return result;
+}
+
+}  // namespace
 
 InetAddress::InetAddress(uint16_t port, bool loopbackOnly, bool ipv6)
 {
@@ -88,8 +116,66 @@ InetAddress::InetAddress(StringArg ip, uint16_t port, bool ipv6)
   }
 }
 
+InetAddress::InetAddress(const struct sockaddr_storage& addr)
+{
+  memcpy(&addrUn_, &addr, sizeof addrUn_);
+}
+
+InetAddress InetAddress::unixDomain(StringArg path)
+{
+  InetAddress addr;
+  memZero(&addr.addrUn_, sizeof addr.addrUn_);
+  addr.addrUn_.sun_family = AF_UNIX;
+  const char* name = path.c_str();
+  // leading '\0' for the abstract namespace
+  const bool abstract = name[0] == '@';
+  const size_t offset = abstract ? 1 : 0;
+  const size_t len = ::strlen(name + offset);
+  // leaves a trailing '\0'
+  const size_t maxLen = sizeof addr.addrUn_.sun_path - offset - 1;
+  if (len > maxLen)
+  {
+    // truncated, it would be another path
+    LOG_FATAL << "InetAddress::unixDomain path too long " << name;
+  }
+  memcpy(addr.addrUn_.sun_path + offset, name + offset, len);
+  return addr;
+}
+
+socklen_t InetAddress::getSockAddrLength() const
+{
+  size_t len = sizeof addr6_;
+  if (family() == AF_INET)
+  {
+    len = sizeof addr_;
+  }
+  else if (family() == AF_UNIX)
+  {
+    const char* path = addrUn_.sun_path;
+    const size_t maxLen = sizeof addrUn_.sun_path;
+    if (path[0] != '\0')
+    {
+      len = offsetof(struct sockaddr_un, sun_path) + ::strnlen(path, maxLen - 1) + 1;
+    }
+    else if (path[1] != '\0')
+    {
+      // the abstract name is not null-terminated, its length counts
+      len = offsetof(struct sockaddr_un, sun_path) + 1 + ::strnlen(path + 1, maxLen - 1);
+    }
+    else
+    {
+      len = sizeof(sa_family_t);
+    }
+  }
+  return static_cast<socklen_t>(len);
+}
+
 string InetAddress::toIpPort() const
 {
+  if (isUnixDomain())
+  {
+    return unixPath(addrUn_);
+  }
   char buf[64] = "";
   sockets::toIpPort(buf, sizeof buf, getSockAddr());
   return buf;
@@ -97,6 +183,10 @@ string InetAddress::toIpPort() const
 
 string InetAddress::toIp() const
 {
+  if (isUnixDomain())
+  {
+    return unixPath(addrUn_);
+  }
   char buf[64] = "";
   sockets::toIp(buf, sizeof buf, getSockAddr());
   return buf;
@@ -110,6 +200,10 @@ uint32_t InetAddress::ipNetEndian() const
 
 uint16_t InetAddress::toPort() const
 {
+  if (isUnixDomain())
+  {
+    return 0;
+  }
   return sockets::networkToHost16(portNetEndian());
 }
 
@@ -15,6 +15,8 @@
 #include "muduo/base/StringPiece.h"
 
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace muduo
 {
@@ -26,7 +28,7 @@ const struct sockaddr* sockaddr_cast(const struct sockaddr_in6* addr);
 }
 
 ///
-/// Wrapper of sockaddr_in.
+/// Wrapper of sockaddr_in, sockaddr_in6 and sockaddr_un.
 ///
 /// This is an POD interface class.
 class InetAddress : public muduo::copyable
@@ -50,7 +52,17 @@ class InetAddress : public muduo::copyable
     : addr6_(addr)
   { }
 
+  /// Of any family, eg. from getsockname(2).
+  explicit InetAddress(const struct sockaddr_storage& addr);
+
+  /// Unix domain socket at @c path, or in the abstract namespace if it starts with '@'.
+  /// Aborts if @c path doesn't fit in sun_path, rather than use another one.
+  static InetAddress unixDomain(StringArg path);
+
   sa_family_t family() const { return addr_.sin_family; }
+  bool isUnixDomain() const { return family() == AF_UNIX; }
+  /// "unix:path" or "unix:@name" if isUnixDomain().
+  /// An unbound peer of a Unix domain socket is "unix:".
   string toIp() const;
   string toIpPort() const;
   uint16_t toPort() const;
@@ -58,6 +70,8 @@ class InetAddress : public muduo::copyable
   // default copy/assignment are Okay
 
   const struct sockaddr* getSockAddr() const { return sockets::sockaddr_cast(&addr6_); }
+  /// For bind(2) and connect(2), exact for the abstract namespace.
+  socklen_t getSockAddrLength() const;
   void setSockAddrInet6(const struct sockaddr_in6& addr6) { addr6_ = addr6; }
 
   uint32_t ipNetEndian() const;
@@ -65,7 +79,7 @@ class InetAddress : public muduo::copyable
 
   // resolve hostname to IP address, not changing port or sin_family
   // return true on success.
-  // thread safe
+  // thread safe, but blocks, use DnsResolver in an EventLoop
   static bool resolve(StringArg hostname, InetAddress* result);
   // static std::vector<InetAddress> resolveAll(const char* hostname, uint16_t port = 0);
 
@@ -77,6 +91,7 @@ class InetAddress : public muduo::copyable
   {
     struct sockaddr_in addr_;
     struct sockaddr_in6 addr6_;
+    struct sockaddr_un addrUn_;
   };
 };
 
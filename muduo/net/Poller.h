@@ -50,6 +50,9 @@ class Poller : noncopyable
 
   virtual bool hasChannel(Channel* channel) const;
 
+  /// Whether Channel::setEdgeTriggered() is honored.
+  virtual bool supportsEdgeTriggered() const { return false; }
+
   static Poller* newDefaultPoller(EventLoop* loop);
 
   void assertInLoopThread() const
@@ -0,0 +1,109 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_SLICE_H
+#define MUDUO_NET_SLICE_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+
+#include <functional>
+#include <memory>
+
+#include <assert.h>
+#include <string.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Immutable, reference counted bytes.
+///
+/// Copies of a Slice share the bytes, which are released
+/// when the last copy is gone, possibly in another thread.
+class Slice : public muduo::copyable
+{
+ public:
+  typedef std::function<void(const void*)> ReleaseCallback;
+
+  Slice()
+    : data_(NULL),
+      len_(0)
+  { }
+
+  /// Takes over the string without copying.
+  explicit Slice(string&& str)
+  {
+    std::shared_ptr<string> s(new string(std::move(str)));
+    data_ = s->data();
+    len_ = s->size();
+    holder_ = std::move(s);
+  }
+
+  /// References [data, data+len), which is valid as long as @c holder is alive.
+  Slice(std::shared_ptr<const void> holder, const void* data, size_t len)
+    : holder_(std::move(holder)),
+      data_(static_cast<const char*>(data)),
+      len_(len)
+  { }
+
+  /// References [data, data+len), @c release is called with @c data
+  /// when the last copy is gone.
+  Slice(const void* data, size_t len, const ReleaseCallback& release)
+    : holder_(data, release),
+      data_(static_cast<const char*>(data)),
+      len_(len)
+  { }
+
+  static Slice copyOf(const void* data, size_t len)
+  {
+    char* copy = new char[len];
+    ::memcpy(copy, data, len);
+    return Slice(std::shared_ptr<const void>(copy, std::default_delete<char[]>()),
+                 copy, len);
+  }
+
+  static Slice copyOf(const StringPiece& str)
+  {
+    return copyOf(str.data(), str.size());
+  }
+
+  // default copy-ctor, move-ctor, dtor and assignment are fine
+
+  void swap(Slice& rhs)
+  {
+    holder_.swap(rhs.holder_);
+    std::swap(data_, rhs.data_);
+    std::swap(len_, rhs.len_);
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return len_; }
+  bool empty() const { return len_ == 0; }
+  StringPiece toStringPiece() const
+  { return StringPiece(data_, static_cast<int>(len_)); }
+
+  const std::shared_ptr<const void>& holder() const { return holder_; }
+
+  /// [offset, offset+len) of this, sharing the same bytes.
+  Slice slice(size_t offset, size_t len) const
+  {
+    assert(offset <= len_ && len <= len_ - offset);
+    return Slice(holder_, data_ + offset, len);
+  }
+
+ private:
+  std::shared_ptr<const void> holder_;
+  const char* data_;
+  size_t len_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_SLICE_H
@@ -12,6 +12,8 @@
 #include "muduo/net/InetAddress.h"
 #include "muduo/net/SocketsOps.h"
 
+#include <assert.h>
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <stdio.h>  // snprintf
@@ -59,7 +61,7 @@ bool Socket::getTcpInfoString(char* buf, int len) const
 
 void Socket::bindAddress(const InetAddress& addr)
 {
-  sockets::bindOrDie(sockfd_, addr.getSockAddr());
+  sockets::bindOrDie(sockfd_, addr.getSockAddr(), addr.getSockAddrLength());
 }
 
 void Socket::listen()
@@ -69,12 +71,12 @@ void Socket::listen()
 
 int Socket::accept(InetAddress* peeraddr)
 {
-  struct sockaddr_in6 addr;
+  struct sockaddr_storage addr;
   memZero(&addr, sizeof addr);
   int connfd = sockets::accept(sockfd_, &addr);
   if (connfd >= 0)
   {
-    peeraddr->setSockAddrInet6(addr);
+    *peeraddr = InetAddress(addr);
   }
   return connfd;
 }
@@ -118,6 +120,77 @@ void Socket::setReusePort(bool on)
 #endif
 }
 
+bool Socket::setReusePortCpuSteering(int numSockets)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  assert(numSockets > 0);
+  struct sock_filter code[] =
+  {
+    // A = raw_smp_processor_id()
+    { static_cast<uint16_t>(BPF_LD | BPF_W | BPF_ABS), 0, 0,
+      static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+    // A = A % numSockets
+    { static_cast<uint16_t>(BPF_ALU | BPF_MOD | BPF_K), 0, 0,
+      static_cast<uint32_t>(numSockets) },
+    // return A
+    { static_cast<uint16_t>(BPF_RET | BPF_A), 0, 0, 0 },
+  };
+  struct sock_fprog prog;
+  prog.len = static_cast<unsigned short>(sizeof code / sizeof code[0]);
+  prog.filter = code;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                         &prog, static_cast<socklen_t>(sizeof prog));
+  if (ret < 0)
+  {
+    LOG_SYSERR << "SO_ATTACH_REUSEPORT_CBPF failed.";
+  }
+  return ret == 0;
+#else
+  (void)numSockets;
+  LOG_ERROR << "SO_ATTACH_REUSEPORT_CBPF is not supported.";
+  return false;
+#endif
+}
+
+bool Socket::setZeroCopy(bool on)
+{
+#ifdef SO_ZEROCOPY
+  int optval = on ? 1 : 0;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY,
+                         &optval, static_cast<socklen_t>(sizeof optval));
+  if (ret < 0 && on)
+  {
+    LOG_SYSERR << "SO_ZEROCOPY failed.";
+  }
+  return ret == 0;
+#else
+  if (on)
+  {
+    LOG_ERROR << "SO_ZEROCOPY is not supported.";
+  }
+  return !on;
+#endif
+}
+
+bool Socket::setBusyPoll(int microSeconds)
+{
+#ifdef SO_BUSY_POLL
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL,
+                         &microSeconds, static_cast<socklen_t>(sizeof microSeconds));
+  if (ret < 0)
+  {
+    LOG_SYSERR << "SO_BUSY_POLL failed.";
+  }
+  return ret == 0;
+#else
+  if (microSeconds > 0)
+  {
+    LOG_ERROR << "SO_BUSY_POLL is not supported.";
+  }
+  return microSeconds == 0;
+#endif
+}
+
 void Socket::setKeepAlive(bool on)
 {
   int optval = on ? 1 : 0;
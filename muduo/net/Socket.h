@@ -74,6 +74,25 @@ class Socket : noncopyable
   ///
   void setReusePort(bool on);
 
+  ///
+  /// Attaches a classic BPF program to the SO_REUSEPORT group of this socket,
+  /// which picks the listening socket of index (CPU of the softirq % @c numSockets),
+  /// in the order they started listening.
+  /// @return true if success.
+  bool setReusePortCpuSteering(int numSockets);
+
+  ///
+  /// Enable/disable SO_ZEROCOPY, for send(2) with MSG_ZEROCOPY.
+  /// @return true if success.
+  bool setZeroCopy(bool on);
+
+  ///
+  /// Sets SO_BUSY_POLL, blocking reads and epoll_wait(2) busy poll the NIC queue
+  /// of this socket for up to @c microSeconds.  0 turns it off.
+  /// Raising it over net.core.busy_read needs CAP_NET_ADMIN.
+  /// @return true if success.
+  bool setBusyPoll(int microSeconds);
+
   ///
   /// Enable/disable SO_KEEPALIVE
   ///
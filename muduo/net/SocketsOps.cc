@@ -14,7 +14,9 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/errqueue.h>
 #include <stdio.h>  // snprintf
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/uio.h>  // readv
 #include <unistd.h>
@@ -59,6 +61,11 @@ struct sockaddr* sockets::sockaddr_cast(struct sockaddr_in6* addr)
   return static_cast<struct sockaddr*>(implicit_cast<void*>(addr));
 }
 
+struct sockaddr* sockets::sockaddr_cast(struct sockaddr_storage* addr)
+{
+  return static_cast<struct sockaddr*>(implicit_cast<void*>(addr));
+}
+
 const struct sockaddr* sockets::sockaddr_cast(const struct sockaddr_in* addr)
 {
   return static_cast<const struct sockaddr*>(implicit_cast<const void*>(addr));
@@ -77,7 +84,7 @@ const struct sockaddr_in6* sockets::sockaddr_in6_cast(const struct sockaddr* add
 int sockets::createNonblockingOrDie(sa_family_t family)
 {
 #if VALGRIND
-  int sockfd = ::socket(family, SOCK_STREAM, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM, family == AF_UNIX ? 0 : IPPROTO_TCP);
   if (sockfd < 0)
   {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -85,7 +92,8 @@ int sockets::createNonblockingOrDie(sa_family_t family)
 
   setNonBlockAndCloseOnExec(sockfd);
 #else
-  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        family == AF_UNIX ? 0 : IPPROTO_TCP);
   if (sockfd < 0)
   {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -94,9 +102,19 @@ int sockets::createNonblockingOrDie(sa_family_t family)
   return sockfd;
 }
 
-void sockets::bindOrDie(int sockfd, const struct sockaddr* addr)
+int sockets::createNonblockingUdpOrDie(sa_family_t family)
+{
+  int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (sockfd < 0)
+  {
+    LOG_SYSFATAL << "sockets::createNonblockingUdpOrDie";
+  }
+  return sockfd;
+}
+
+void sockets::bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
 {
-  int ret = ::bind(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
+  int ret = ::bind(sockfd, addr, addrlen);
   if (ret < 0)
   {
     LOG_SYSFATAL << "sockets::bindOrDie";
@@ -112,7 +130,7 @@ void sockets::listenOrDie(int sockfd)
   }
 }
 
-int sockets::accept(int sockfd, struct sockaddr_in6* addr)
+int sockets::accept(int sockfd, struct sockaddr_storage* addr)
 {
   socklen_t addrlen = static_cast<socklen_t>(sizeof *addr);
 #if VALGRIND || defined (NO_ACCEPT4)
@@ -125,7 +143,10 @@ int sockets::accept(int sockfd, struct sockaddr_in6* addr)
   if (connfd < 0)
   {
     int savedErrno = errno;
-    LOG_SYSERR << "Socket::accept";
+    if (savedErrno != EAGAIN)
+    {
+      LOG_SYSERR << "Socket::accept";
+    }
     switch (savedErrno)
     {
       case EAGAIN:
@@ -156,9 +177,9 @@ int sockets::accept(int sockfd, struct sockaddr_in6* addr)
   return connfd;
 }
 
-int sockets::connect(int sockfd, const struct sockaddr* addr)
+int sockets::connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
 {
-  return ::connect(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
+  return ::connect(sockfd, addr, addrlen);
 }
 
 ssize_t sockets::read(int sockfd, void *buf, size_t count)
@@ -176,6 +197,59 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
   return ::write(sockfd, buf, count);
 }
 
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt)
+{
+  return ::writev(sockfd, iov, iovcnt);
+}
+
+ssize_t sockets::sendfile(int sockfd, int fd, off_t* offset, size_t count)
+{
+  return ::sendfile(sockfd, fd, offset, count);
+}
+
+ssize_t sockets::sendZeroCopy(int sockfd, const void *buf, size_t count)
+{
+#ifdef MSG_ZEROCOPY
+  return ::send(sockfd, buf, count, MSG_ZEROCOPY);
+#else
+  return ::write(sockfd, buf, count);
+#endif
+}
+
+int sockets::readZeroCopyCompletion(int sockfd, uint32_t* lo, uint32_t* hi, bool* copied)
+{
+  char control[128];
+  struct msghdr msg;
+  memZero(&msg, sizeof msg);
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof control;
+  if (::recvmsg(sockfd, &msg, MSG_ERRQUEUE) < 0)
+  {
+    if (errno != EAGAIN)
+    {
+      LOG_SYSERR << "sockets::readZeroCopyCompletion";
+    }
+    return -1;
+  }
+  for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+  {
+    if ((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+        || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+    {
+      const struct sock_extended_err* serr =
+          static_cast<const struct sock_extended_err*>(implicit_cast<const void*>(CMSG_DATA(cm)));
+      if (serr->ee_errno == 0 && serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+      {
+        *lo = serr->ee_info;
+        *hi = serr->ee_data;
+        *copied = (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
 void sockets::close(int sockfd)
 {
   if (::close(sockfd) < 0)
@@ -257,9 +331,9 @@ int sockets::getSocketError(int sockfd)
   }
 }
 
-struct sockaddr_in6 sockets::getLocalAddr(int sockfd)
+struct sockaddr_storage sockets::getLocalAddr(int sockfd)
 {
-  struct sockaddr_in6 localaddr;
+  struct sockaddr_storage localaddr;
   memZero(&localaddr, sizeof localaddr);
   socklen_t addrlen = static_cast<socklen_t>(sizeof localaddr);
   if (::getsockname(sockfd, sockaddr_cast(&localaddr), &addrlen) < 0)
@@ -269,9 +343,9 @@ struct sockaddr_in6 sockets::getLocalAddr(int sockfd)
   return localaddr;
 }
 
-struct sockaddr_in6 sockets::getPeerAddr(int sockfd)
+struct sockaddr_storage sockets::getPeerAddr(int sockfd)
 {
-  struct sockaddr_in6 peeraddr;
+  struct sockaddr_storage peeraddr;
   memZero(&peeraddr, sizeof peeraddr);
   socklen_t addrlen = static_cast<socklen_t>(sizeof peeraddr);
   if (::getpeername(sockfd, sockaddr_cast(&peeraddr), &addrlen) < 0)
@@ -283,19 +357,21 @@ struct sockaddr_in6 sockets::getPeerAddr(int sockfd)
 
 bool sockets::isSelfConnect(int sockfd)
 {
-  struct sockaddr_in6 localaddr = getLocalAddr(sockfd);
-  struct sockaddr_in6 peeraddr = getPeerAddr(sockfd);
-  if (localaddr.sin6_family == AF_INET)
+  struct sockaddr_storage localaddr = getLocalAddr(sockfd);
+  struct sockaddr_storage peeraddr = getPeerAddr(sockfd);
+  if (localaddr.ss_family == AF_INET)
   {
     const struct sockaddr_in* laddr4 = reinterpret_cast<struct sockaddr_in*>(&localaddr);
     const struct sockaddr_in* raddr4 = reinterpret_cast<struct sockaddr_in*>(&peeraddr);
     return laddr4->sin_port == raddr4->sin_port
         && laddr4->sin_addr.s_addr == raddr4->sin_addr.s_addr;
   }
-  else if (localaddr.sin6_family == AF_INET6)
+  else if (localaddr.ss_family == AF_INET6)
   {
-    return localaddr.sin6_port == peeraddr.sin6_port
-        && memcmp(&localaddr.sin6_addr, &peeraddr.sin6_addr, sizeof localaddr.sin6_addr) == 0;
+    const struct sockaddr_in6* laddr6 = reinterpret_cast<struct sockaddr_in6*>(&localaddr);
+    const struct sockaddr_in6* raddr6 = reinterpret_cast<struct sockaddr_in6*>(&peeraddr);
+    return laddr6->sin6_port == raddr6->sin6_port
+        && memcmp(&laddr6->sin6_addr, &raddr6->sin6_addr, sizeof laddr6->sin6_addr) == 0;
   }
   else
   {
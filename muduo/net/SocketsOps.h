@@ -24,14 +24,24 @@ namespace sockets
 /// Creates a non-blocking socket file descriptor,
 /// abort if any error.
 int createNonblockingOrDie(sa_family_t family);
+/// Same for a UDP socket.
+int createNonblockingUdpOrDie(sa_family_t family);
 
-int  connect(int sockfd, const struct sockaddr* addr);
-void bindOrDie(int sockfd, const struct sockaddr* addr);
+int  connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+void bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 void listenOrDie(int sockfd);
-int  accept(int sockfd, struct sockaddr_in6* addr);
+int  accept(int sockfd, struct sockaddr_storage* addr);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+ssize_t writev(int sockfd, const struct iovec *iov, int iovcnt);
+ssize_t sendfile(int sockfd, int fd, off_t* offset, size_t count);
+/// send(2) with MSG_ZEROCOPY, needs SO_ZEROCOPY on @c sockfd.
+ssize_t sendZeroCopy(int sockfd, const void *buf, size_t count);
+/// Reads one message off the error queue of @c sockfd.
+/// @return 1 and fills [*lo, *hi] for a MSG_ZEROCOPY completion,
+/// 0 for other messages, -1 if the queue is empty or on error.
+int readZeroCopyCompletion(int sockfd, uint32_t* lo, uint32_t* hi, bool* copied);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
 
@@ -50,11 +60,12 @@ int getSocketError(int sockfd);
 const struct sockaddr* sockaddr_cast(const struct sockaddr_in* addr);
 const struct sockaddr* sockaddr_cast(const struct sockaddr_in6* addr);
 struct sockaddr* sockaddr_cast(struct sockaddr_in6* addr);
+struct sockaddr* sockaddr_cast(struct sockaddr_storage* addr);
 const struct sockaddr_in* sockaddr_in_cast(const struct sockaddr* addr);
 const struct sockaddr_in6* sockaddr_in6_cast(const struct sockaddr* addr);
 
-struct sockaddr_in6 getLocalAddr(int sockfd);
-struct sockaddr_in6 getPeerAddr(int sockfd);
+struct sockaddr_storage getLocalAddr(int sockfd);
+struct sockaddr_storage getPeerAddr(int sockfd);
 bool isSelfConnect(int sockfd);
 
 }  // namespace sockets
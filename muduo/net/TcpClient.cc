@@ -24,12 +24,6 @@ using namespace muduo::net;
 // {
 // }
 
-// TcpClient::TcpClient(EventLoop* loop, const string& host, uint16_t port)
-//   : loop_(CHECK_NOTNULL(loop)),
-//     serverAddr_(host, port)
-// {
-// }
-
 namespace muduo
 {
 namespace net
@@ -57,8 +51,10 @@ TcpClient::TcpClient(EventLoop* loop,
   : loop_(CHECK_NOTNULL(loop)),
     connector_(new Connector(loop, serverAddr)),
     name_(nameArg),
-    connectionCallback_(defaultConnectionCallback),
-    messageCallback_(defaultMessageCallback),
+    callbacks_(new TcpConnection::Callbacks{ defaultConnectionCallback,
+                                             defaultMessageCallback,
+                                             WriteCompleteCallback(),
+                                             HighWaterMarkCallback() }),
     retry_(false),
     connect_(true),
     nextConnId_(1)
@@ -70,6 +66,27 @@ TcpClient::TcpClient(EventLoop* loop,
            << "] - connector " << get_pointer(connector_);
 }
 
+TcpClient::TcpClient(EventLoop* loop,
+                     const string& host,
+                     uint16_t port,
+                     const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    connector_(new Connector(loop, host, port)),
+    name_(nameArg),
+    callbacks_(new TcpConnection::Callbacks{ defaultConnectionCallback,
+                                             defaultMessageCallback,
+                                             WriteCompleteCallback(),
+                                             HighWaterMarkCallback() }),
+    retry_(false),
+    connect_(true),
+    nextConnId_(1)
+{
+  connector_->setNewConnectionCallback(
+      std::bind(&TcpClient::newConnection, this, _1));
+  LOG_INFO << "TcpClient::TcpClient[" << name_
+           << "] - connector " << get_pointer(connector_) << " " << host;
+}
+
 TcpClient::~TcpClient()
 {
   LOG_INFO << "TcpClient::~TcpClient[" << name_
@@ -101,11 +118,35 @@ TcpClient::~TcpClient()
   }
 }
 
+void TcpClient::setConnectionCallback(const ConnectionCallback& cb)
+{
+  copyCallbacks()->connection = cb;
+}
+
+void TcpClient::setMessageCallback(const MessageCallback& cb)
+{
+  copyCallbacks()->message = cb;
+}
+
+void TcpClient::setWriteCompleteCallback(const WriteCompleteCallback& cb)
+{
+  copyCallbacks()->writeComplete = cb;
+}
+
+TcpConnection::Callbacks* TcpClient::copyCallbacks()
+{
+  // the current connection keeps the old ones
+  std::shared_ptr<TcpConnection::Callbacks> callbacks(
+      new TcpConnection::Callbacks(*callbacks_));
+  callbacks_ = callbacks;
+  return get_pointer(callbacks);
+}
+
 void TcpClient::connect()
 {
   // FIXME: check state
   LOG_INFO << "TcpClient::connect[" << name_ << "] - connecting to "
-           << connector_->serverAddress().toIpPort();
+           << connector_->serverName();
   connect_ = true;
   connector_->start();
 }
@@ -133,9 +174,9 @@ void TcpClient::newConnection(int sockfd)
 {
   loop_->assertInLoopThread();
   InetAddress peerAddr(sockets::getPeerAddr(sockfd));
+  const int connId = nextConnId_++;
   char buf[32];
-  snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
-  ++nextConnId_;
+  snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), connId);
   string connName = name_ + buf;
 
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
@@ -145,11 +186,10 @@ void TcpClient::newConnection(int sockfd)
                                           connName,
                                           sockfd,
                                           localAddr,
-                                          peerAddr));
+                                          peerAddr,
+                                          connId));
 
-  conn->setConnectionCallback(connectionCallback_);
-  conn->setMessageCallback(messageCallback_);
-  conn->setWriteCompleteCallback(writeCompleteCallback_);
+  conn->setCallbacks(callbacks_);
   conn->setCloseCallback(
       std::bind(&TcpClient::removeConnection, this, _1)); // FIXME: unsafe
   {
@@ -174,7 +214,7 @@ void TcpClient::removeConnection(const TcpConnectionPtr& conn)
   if (retry_ && connect_)
   {
     LOG_INFO << "TcpClient::connect[" << name_ << "] - Reconnecting to "
-             << connector_->serverAddress().toIpPort();
+             << connector_->serverName();
     connector_->restart();
   }
 }
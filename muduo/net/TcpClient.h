@@ -26,10 +26,15 @@ class TcpClient : noncopyable
 {
  public:
   // TcpClient(EventLoop* loop);
-  // TcpClient(EventLoop* loop, const string& host, uint16_t port);
   TcpClient(EventLoop* loop,
             const InetAddress& serverAddr,
             const string& nameArg);
+  /// Resolves @c host by EventLoop::resolver() without blocking,
+  /// before each connecting attempt.
+  TcpClient(EventLoop* loop,
+            const string& host,
+            uint16_t port,
+            const string& nameArg);
   ~TcpClient();  // force out-line dtor, for std::unique_ptr members.
 
   void connect();
@@ -51,31 +56,33 @@ class TcpClient : noncopyable
 
   /// Set connection callback.
   /// Not thread safe.
-  void setConnectionCallback(ConnectionCallback cb)
-  { connectionCallback_ = std::move(cb); }
+  void setConnectionCallback(const ConnectionCallback& cb);
 
   /// Set message callback.
   /// Not thread safe.
-  void setMessageCallback(MessageCallback cb)
-  { messageCallback_ = std::move(cb); }
+  void setMessageCallback(const MessageCallback& cb);
 
   /// Set write complete callback.
   /// Not thread safe.
-  void setWriteCompleteCallback(WriteCompleteCallback cb)
-  { writeCompleteCallback_ = std::move(cb); }
+  void setWriteCompleteCallback(const WriteCompleteCallback& cb);
+
+  /// Replaces all of the above, shared with whoever else holds @c callbacks.
+  /// Not thread safe.
+  void setCallbacks(const TcpConnection::CallbacksPtr& callbacks)
+  { callbacks_ = callbacks; }
 
  private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd);
   /// Not thread safe, but in loop
   void removeConnection(const TcpConnectionPtr& conn);
+  TcpConnection::Callbacks* copyCallbacks();
 
   EventLoop* loop_;
   ConnectorPtr connector_; // avoid revealing Connector
   const string name_;
-  ConnectionCallback connectionCallback_;
-  MessageCallback messageCallback_;
-  WriteCompleteCallback writeCompleteCallback_;
+  // shared with connections, copied if set again
+  TcpConnection::CallbacksPtr callbacks_;
   bool retry_;   // atomic
   bool connect_; // atomic
   // always in loop thread
@@ -6,20 +6,43 @@
 
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
 #include "muduo/net/TcpConnection.h"
 
 #include "muduo/base/Logging.h"
 #include "muduo/base/WeakCallback.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/IdleWheel.h"
 #include "muduo/net/Socket.h"
 #include "muduo/net/SocketsOps.h"
 
+#include <algorithm>
+
 #include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+const int kMaxIovec = 64;
+// smaller Slices are cheaper to copy than to be a block of outputChain_
+const size_t kMinReferencedSlice = 1024;
+
+const TcpConnection::CallbacksPtr& noCallbacks()
+{
+  static const TcpConnection::CallbacksPtr callbacks(new TcpConnection::Callbacks);
+  return callbacks;
+}
+}
+
 void muduo::net::defaultConnectionCallback(const TcpConnectionPtr& conn)
 {
   LOG_TRACE << conn->localAddress().toIpPort() << " -> "
@@ -39,8 +62,10 @@ TcpConnection::TcpConnection(EventLoop* loop,
                              const string& nameArg,
                              int sockfd,
                              const InetAddress& localAddr,
-                             const InetAddress& peerAddr)
+                             const InetAddress& peerAddr,
+                             int64_t id)
   : loop_(CHECK_NOTNULL(loop)),
+    id_(id),
     name_(nameArg),
     state_(kConnecting),
     reading_(true),
@@ -48,8 +73,74 @@ TcpConnection::TcpConnection(EventLoop* loop,
     channel_(new Channel(loop, sockfd)),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    callbacks_(noCallbacks()),
+    highWaterMark_(64*1024*1024),
+    flowHighWaterMark_(0),
+    flowLowWaterMark_(0),
+    flowSelf_(false),
+    flowPausing_(false),
+    readPauses_(0),
+    ioBudget_(kDefaultIoBudget),
+    bufferShrinkThreshold_(kDefaultBufferShrinkThreshold),
+    inputBuffer_(0),
+    outputBuffer_(0),
+    zeroCopyThreshold_(0),
+    zeroCopySeq_(0),
+    queuedSeq_(0),
+    stats_(),
+    idleTimeout_(0),
+    lastActive_(0),
+    idleBucket_(-1),
+    idlePrev_(NULL),
+    idleNext_(NULL)
 {
+  init();
+}
+
+TcpConnection::TcpConnection(EventLoop* loop,
+                             int64_t id,
+                             const std::shared_ptr<const string>& namePrefix,
+                             int sockfd,
+                             const InetAddress& localAddr,
+                             const InetAddress& peerAddr)
+  : loop_(CHECK_NOTNULL(loop)),
+    id_(id),
+    namePrefix_(namePrefix),
+    state_(kConnecting),
+    reading_(true),
+    socket_(new Socket(sockfd)),
+    channel_(new Channel(loop, sockfd)),
+    localAddr_(localAddr),
+    peerAddr_(peerAddr),
+    callbacks_(noCallbacks()),
+    highWaterMark_(64*1024*1024),
+    flowHighWaterMark_(0),
+    flowLowWaterMark_(0),
+    flowSelf_(false),
+    flowPausing_(false),
+    readPauses_(0),
+    ioBudget_(kDefaultIoBudget),
+    bufferShrinkThreshold_(kDefaultBufferShrinkThreshold),
+    inputBuffer_(0),
+    outputBuffer_(0),
+    zeroCopyThreshold_(0),
+    zeroCopySeq_(0),
+    queuedSeq_(0),
+    stats_(),
+    idleTimeout_(0),
+    lastActive_(0),
+    idleBucket_(-1),
+    idlePrev_(NULL),
+    idleNext_(NULL)
+{
+  init();
+}
+
+void TcpConnection::init()
+{
+  stats_.creationTime = Timestamp::now();
+  // counted from now on, so that loops picked in a burst see each other
+  loop_->countConnection(1);
   channel_->setReadCallback(
       std::bind(&TcpConnection::handleRead, this, _1));
   channel_->setWriteCallback(
@@ -58,17 +149,34 @@ TcpConnection::TcpConnection(EventLoop* loop,
       std::bind(&TcpConnection::handleClose, this));
   channel_->setErrorCallback(
       std::bind(&TcpConnection::handleError, this));
-  LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
-            << " fd=" << sockfd;
+  LOG_DEBUG << "TcpConnection::ctor[" <<  name() << "] at " << this
+            << " fd=" << channel_->fd();
   socket_->setKeepAlive(true);
 }
 
 TcpConnection::~TcpConnection()
 {
-  LOG_DEBUG << "TcpConnection::dtor[" <<  name_ << "] at " << this
+  LOG_DEBUG << "TcpConnection::dtor[" <<  name() << "] at " << this
             << " fd=" << channel_->fd()
             << " state=" << stateToString();
   assert(state_ == kDisconnected);
+  assert(idleBucket_ < 0);
+}
+
+const string& TcpConnection::name() const
+{
+  if (namePrefix_)
+  {
+    std::call_once(nameOnce_, &TcpConnection::buildName, this);
+  }
+  return name_;
+}
+
+void TcpConnection::buildName() const
+{
+  char buf[32];
+  snprintf(buf, sizeof buf, "%" PRId64, id_);
+  name_ = *namePrefix_ + buf;
 }
 
 bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
@@ -99,17 +207,26 @@ void TcpConnection::send(const StringPiece& message)
     }
     else
     {
-      void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
-      loop_->runInLoop(
-          std::bind(fp,
-                    this,     // FIXME
-                    message.as_string()));
-                    //std::forward<string>(message)));
+      queueSend(Slice::copyOf(message));
+    }
+  }
+}
+
+void TcpConnection::send(string&& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(message);
+    }
+    else
+    {
+      queueSend(Slice(std::move(message)));
     }
   }
 }
 
-// FIXME efficiency!!!
 void TcpConnection::send(Buffer* buf)
 {
   if (state_ == kConnected)
@@ -121,16 +238,160 @@ void TcpConnection::send(Buffer* buf)
     }
     else
     {
-      void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
-      loop_->runInLoop(
-          std::bind(fp,
-                    this,     // FIXME
-                    buf->retrieveAllAsString()));
-                    //std::forward<string>(message)));
+      Buffer message;
+      message.swap(*buf);
+      send(std::move(message));
     }
   }
 }
 
+void TcpConnection::send(Buffer&& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(message.peek(), message.readableBytes());
+      message.retrieveAll();
+    }
+    else
+    {
+      std::shared_ptr<Buffer> holder(new Buffer(std::move(message)));
+      queueSend(Slice(holder, holder->peek(), holder->readableBytes()));
+    }
+  }
+}
+
+void TcpConnection::send(const Slice& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(message);
+    }
+    else
+    {
+      queueSend(Slice(message));
+    }
+  }
+}
+
+void TcpConnection::queueSend(Slice&& message)
+{
+  MutexLockGuard lock(queuedMutex_);
+  // joins the open batch, unless anything was queued in the loop after it,
+  // eg. by sendFile() or runInLoop() of this thread, which goes first
+  if (queuedSends_ && loop_->functorsQueued() == queuedSeq_)
+  {
+    queuedSends_->push_back(std::move(message));
+    return;
+  }
+  queuedSends_ = std::make_shared<std::vector<Slice>>();
+  queuedSends_->push_back(std::move(message));
+  loop_->queueInLoop(
+      std::bind(&TcpConnection::sendQueuedInLoop, shared_from_this(), queuedSends_));
+  queuedSeq_ = loop_->functorsQueued();
+}
+
+void TcpConnection::sendQueuedInLoop(const std::shared_ptr<std::vector<Slice>>& batch)
+{
+  {
+    MutexLockGuard lock(queuedMutex_);
+    if (queuedSends_ == batch)
+    {
+      queuedSends_.reset();  // closed
+    }
+  }
+  sendInLoop(batch->data(), batch->size());
+}
+
+bool TcpConnection::setZeroCopy(size_t threshold)
+{
+  assert(threshold > 0);
+  if (socket_->setZeroCopy(true))
+  {
+    zeroCopyThreshold_ = threshold;
+    return true;
+  }
+  return false;
+}
+
+void TcpConnection::sendInLoop(const Slice& message)
+{
+  sendInLoop(&message, 1);
+}
+
+void TcpConnection::sendInLoop(const Slice* messages, size_t count)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  const size_t oldLen = outputBytes();
+  for (size_t i = 0; i < count; ++i)
+  {
+    const Slice& message = messages[i];
+    if (isZeroCopy() && message.size() >= zeroCopyThreshold_)
+    {
+      outputChain_.appendZeroCopy(message.holder(), message.data(), message.size());
+    }
+    else if (message.size() < kMinReferencedSlice && outputChain_.empty())
+    {
+      outputBuffer_.append(message.data(), message.size());
+    }
+    else if (message.size() < kMinReferencedSlice)
+    {
+      outputChain_.append(message.data(), message.size());
+    }
+    else
+    {
+      outputChain_.append(message.holder(), message.data(), message.size());
+    }
+  }
+
+  bool faultError = false;
+  // if no thing in output queue, try writing directly
+  if (!channel_->isWriting() && oldLen == 0)
+  {
+    ssize_t nwrote = writeOutput();
+    if (nwrote >= 0)
+    {
+      if (outputBytes() == 0 && callbacks_->writeComplete)
+      {
+        loop_->queueInLoop(std::bind(callbacks_->writeComplete, shared_from_this()));
+      }
+    }
+    else if (errno != EWOULDBLOCK)
+    {
+      LOG_SYSERR << "TcpConnection::sendInLoop";
+      if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
+      {
+        faultError = true;
+      }
+    }
+  }
+
+  const size_t newLen = outputBytes();
+  if (!faultError && newLen > 0)
+  {
+    if (newLen >= highWaterMark_
+        && oldLen < highWaterMark_
+        && callbacks_->highWaterMark)
+    {
+      loop_->queueInLoop(std::bind(callbacks_->highWaterMark, shared_from_this(), newLen));
+    }
+    if (!channel_->isWriting())
+    {
+      channel_->enableWriting();
+    }
+    stats_.maxOutputBytes = std::max(stats_.maxOutputBytes, outputBytes());
+    updateFlowControl();
+  }
+}
+
 void TcpConnection::sendInLoop(const StringPiece& message)
 {
   sendInLoop(message.data(), message.size());
@@ -148,15 +409,16 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     return;
   }
   // if no thing in output queue, try writing directly
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+  if (!channel_->isWriting() && outputBytes() == 0)
   {
     nwrote = sockets::write(channel_->fd(), data, len);
+    countWrite(nwrote);
     if (nwrote >= 0)
     {
       remaining = len - nwrote;
-      if (remaining == 0 && writeCompleteCallback_)
+      if (remaining == 0 && callbacks_->writeComplete)
       {
-        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        loop_->queueInLoop(std::bind(callbacks_->writeComplete, shared_from_this()));
       }
     }
     else // nwrote < 0
@@ -176,18 +438,109 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
   assert(remaining <= len);
   if (!faultError && remaining > 0)
   {
-    size_t oldLen = outputBuffer_.readableBytes();
+    size_t oldLen = outputBytes();
+    if (oldLen + remaining >= highWaterMark_
+        && oldLen < highWaterMark_
+        && callbacks_->highWaterMark)
+    {
+      loop_->queueInLoop(std::bind(callbacks_->highWaterMark, shared_from_this(), oldLen + remaining));
+    }
+    const char* rest = static_cast<const char*>(data)+nwrote;
+    if (!outputChain_.empty() || remaining >= ChainBuffer::kSliceSize)
+    {
+      // no reallocation of outputBuffer_ for large payloads
+      outputChain_.append(rest, remaining);
+    }
+    else
+    {
+      outputBuffer_.append(rest, remaining);
+    }
+    if (!channel_->isWriting())
+    {
+      channel_->enableWriting();
+    }
+    stats_.maxOutputBytes = std::max(stats_.maxOutputBytes, outputBytes());
+    updateFlowControl();
+  }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+  // closes fd when the last reference is gone
+  std::shared_ptr<const void> holder(static_cast<const void*>(NULL),
+                                     std::bind(&sockets::close, fd));
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendFileInLoop(holder, fd, offset, length);
+    }
+    else
+    {
+      loop_->runInLoop(
+          std::bind(&TcpConnection::sendFileInLoop,
+                    shared_from_this(), holder, fd, offset, length));
+    }
+  }
+}
+
+void TcpConnection::sendFileInLoop(const std::shared_ptr<const void>& holder,
+                                   int fd, off_t offset, size_t length)
+{
+  loop_->assertInLoopThread();
+  size_t remaining = length;
+  bool faultError = false;
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  // if no thing in output queue, try sending directly
+  if (!channel_->isWriting() && outputBytes() == 0)
+  {
+    ssize_t nwrote = sockets::sendfile(channel_->fd(), fd, &offset, length);
+    countWrite(nwrote);
+    if (nwrote > 0)
+    {
+      remaining = length - nwrote;
+      if (remaining == 0 && callbacks_->writeComplete)
+      {
+        loop_->queueInLoop(std::bind(callbacks_->writeComplete, shared_from_this()));
+      }
+    }
+    else if (nwrote == 0 && length > 0)
+    {
+      LOG_ERROR << "TcpConnection::sendFileInLoop - file " << fd
+                << " ends before offset " << offset << ", closing";
+      faultError = true;
+      forceCloseInLoop();
+    }
+    else if (nwrote < 0 && errno != EWOULDBLOCK)
+    {
+      // nor can it be skipped
+      LOG_SYSERR << "TcpConnection::sendFileInLoop - file " << fd << ", closing";
+      faultError = true;
+      forceCloseInLoop();
+    }
+  }
+
+  assert(remaining <= length);
+  if (!faultError && remaining > 0)
+  {
+    size_t oldLen = outputBytes();
     if (oldLen + remaining >= highWaterMark_
         && oldLen < highWaterMark_
-        && highWaterMarkCallback_)
+        && callbacks_->highWaterMark)
     {
-      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+      loop_->queueInLoop(std::bind(callbacks_->highWaterMark, shared_from_this(), oldLen + remaining));
     }
-    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+    outputChain_.appendFile(holder, fd, offset, remaining);
     if (!channel_->isWriting())
     {
       channel_->enableWriting();
     }
+    stats_.maxOutputBytes = std::max(stats_.maxOutputBytes, outputBytes());
+    updateFlowControl();
   }
 }
 
@@ -290,6 +643,87 @@ void TcpConnection::setTcpNoDelay(bool on)
   socket_->setTcpNoDelay(on);
 }
 
+void TcpConnection::setBusyPoll(int microSeconds)
+{
+  socket_->setBusyPoll(microSeconds);
+}
+
+void TcpConnection::setEdgeTriggered(size_t ioBudget)
+{
+  assert(state_ == kConnecting);
+  assert(ioBudget > 0);
+  channel_->setEdgeTriggered(true);
+  ioBudget_ = ioBudget;
+}
+
+void TcpConnection::setConnectionCallback(const ConnectionCallback& cb)
+{
+  ownCallbacks()->connection = cb;
+}
+
+void TcpConnection::setMessageCallback(const MessageCallback& cb)
+{
+  ownCallbacks()->message = cb;
+}
+
+void TcpConnection::setWriteCompleteCallback(const WriteCompleteCallback& cb)
+{
+  ownCallbacks()->writeComplete = cb;
+}
+
+void TcpConnection::setHighWaterMarkCallback(const HighWaterMarkCallback& cb,
+                                             size_t highWaterMark)
+{
+  ownCallbacks()->highWaterMark = cb;
+  highWaterMark_ = highWaterMark;
+}
+
+void TcpConnection::setIdleTimeout(double seconds)
+{
+  idleTimeout_ = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    // relinked by the new deadline
+    leaveIdleWheel();
+    if (idleTimeout_ > 0)
+    {
+      loop_->idleWheel()->add(this);
+    }
+  }
+}
+
+void TcpConnection::leaveIdleWheel()
+{
+  if (idleBucket_ >= 0)
+  {
+    loop_->idleWheel()->remove(this);
+  }
+}
+
+TcpConnection::Callbacks* TcpConnection::ownCallbacks()
+{
+  // copied every time, they are seldom set one by one
+  std::shared_ptr<Callbacks> own(new Callbacks(*callbacks_));
+  callbacks_ = own;
+  return get_pointer(own);
+}
+
+void TcpConnection::trimBuffer(Buffer* buf)
+{
+  if (!buf->releaseIfEmpty()
+      && bufferShrinkThreshold_ > 0
+      && buf->internalCapacity() > bufferShrinkThreshold_
+      && buf->readableBytes() < buf->internalCapacity() / 4)
+  {
+    buf->shrink(0);
+  }
+}
+
+bool TcpConnection::isEdgeTriggered() const
+{
+  return channel_->isEdgeTriggered();
+}
+
 void TcpConnection::startRead()
 {
   loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, this));
@@ -298,11 +732,8 @@ void TcpConnection::startRead()
 void TcpConnection::startReadInLoop()
 {
   loop_->assertInLoopThread();
-  if (!reading_ || !channel_->isReading())
-  {
-    channel_->enableReading();
-    reading_ = true;
-  }
+  reading_ = true;
+  updateReading();
 }
 
 void TcpConnection::stopRead()
@@ -313,10 +744,90 @@ void TcpConnection::stopRead()
 void TcpConnection::stopReadInLoop()
 {
   loop_->assertInLoopThread();
-  if (reading_ || channel_->isReading())
+  reading_ = false;
+  updateReading();
+}
+
+void TcpConnection::updateReading()
+{
+  // off if either the user or flow control wants it so
+  const bool on = reading_ && readPauses_ == 0;
+  if (on && !channel_->isReading())
+  {
+    channel_->enableReading();
+  }
+  else if (!on && channel_->isReading())
   {
     channel_->disableReading();
-    reading_ = false;
+  }
+}
+
+void TcpConnection::setFlowControl(size_t highWaterMark, size_t lowWaterMark,
+                                   const TcpConnectionPtr& source)
+{
+  loop_->assertInLoopThread();
+  assert(lowWaterMark < highWaterMark || highWaterMark == 0);
+  if (flowPausing_)
+  {
+    flowPausing_ = false;
+    pauseFlowSource(false);
+  }
+  flowHighWaterMark_ = highWaterMark;
+  flowLowWaterMark_ = lowWaterMark;
+  flowSelf_ = !source || source.get() == this;
+  flowSource_ = flowSelf_ ? std::weak_ptr<TcpConnection>() : source;
+  updateFlowControl();
+}
+
+void TcpConnection::updateFlowControl()
+{
+  if (flowHighWaterMark_ == 0 || state_ == kDisconnected)
+  {
+    return;
+  }
+  const size_t bytes = outputBytes();
+  if (!flowPausing_ && bytes >= flowHighWaterMark_)
+  {
+    LOG_DEBUG << name() << " pauses its source at " << bytes << " bytes";
+    flowPausing_ = true;
+    pauseFlowSource(true);
+  }
+  else if (flowPausing_ && bytes <= flowLowWaterMark_)
+  {
+    LOG_DEBUG << name() << " resumes its source at " << bytes << " bytes";
+    flowPausing_ = false;
+    pauseFlowSource(false);
+  }
+}
+
+void TcpConnection::pauseFlowSource(bool pause)
+{
+  TcpConnectionPtr source(flowSelf_ ? shared_from_this() : flowSource_.lock());
+  if (source)
+  {
+    // the source may live in another loop
+    source->getLoop()->runInLoop(
+        std::bind(pause ? &TcpConnection::pauseReadInLoop
+                        : &TcpConnection::resumeReadInLoop,
+                  source));
+  }
+}
+
+void TcpConnection::pauseReadInLoop()
+{
+  loop_->assertInLoopThread();
+  if (readPauses_++ == 0 && state_ != kDisconnected)
+  {
+    updateReading();
+  }
+}
+
+void TcpConnection::resumeReadInLoop()
+{
+  loop_->assertInLoopThread();
+  if (readPauses_ > 0 && --readPauses_ == 0 && state_ != kDisconnected)
+  {
+    updateReading();
   }
 }
 
@@ -327,8 +838,13 @@ void TcpConnection::connectEstablished()
   setState(kConnected);
   channel_->tie(shared_from_this());
   channel_->enableReading();
+  lastActive_ = Timestamp::now().microSecondsSinceEpoch();
+  if (idleTimeout_ > 0)
+  {
+    loop_->idleWheel()->add(this);
+  }
 
-  connectionCallback_(shared_from_this());
+  callbacks_->connection(shared_from_this());
 }
 
 void TcpConnection::connectDestroyed()
@@ -338,20 +854,33 @@ void TcpConnection::connectDestroyed()
   {
     setState(kDisconnected);
     channel_->disableAll();
+    leaveIdleWheel();
+    if (flowPausing_)
+    {
+      flowPausing_ = false;
+      pauseFlowSource(false);
+    }
 
-    connectionCallback_(shared_from_this());
+    callbacks_->connection(shared_from_this());
   }
   channel_->remove();
+  loop_->countConnection(-1);
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
   loop_->assertInLoopThread();
+  if (channel_->isEdgeTriggered())
+  {
+    handleReadEdgeTriggered(receiveTime);
+    return;
+  }
   int savedErrno = 0;
-  ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+  ssize_t n = readInput(&savedErrno);
   if (n > 0)
   {
-    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    handleMessage(receiveTime);
+    trimBuffer(&inputBuffer_);
   }
   else if (n == 0)
   {
@@ -365,23 +894,93 @@ void TcpConnection::handleRead(Timestamp receiveTime)
   }
 }
 
+void TcpConnection::handleReadEdgeTriggered(Timestamp receiveTime)
+{
+  // may be a continuation queued by ourselves
+  if (state_ == kDisconnected || !channel_->isReading())
+  {
+    return;
+  }
+  int savedErrno = 0;
+  size_t total = 0;
+  ssize_t n = 0;
+  while (total < ioBudget_
+         && (n = readInput(&savedErrno)) > 0)
+  {
+    total += n;
+  }
+
+  if (total > 0)
+  {
+    handleMessage(receiveTime);
+    trimBuffer(&inputBuffer_);
+  }
+  if (n > 0)
+  {
+    // out of budget, no more edge will come for the unread data.
+    loop_->queueInLoop(std::bind(&TcpConnection::handleReadEdgeTriggered,
+                                 shared_from_this(), receiveTime));
+  }
+  else if (n == 0)
+  {
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+      handleClose();
+    }
+  }
+  else if (savedErrno != EAGAIN)
+  {
+    errno = savedErrno;
+    LOG_SYSERR << "TcpConnection::handleReadEdgeTriggered";
+    handleError();
+  }
+}
+
 void TcpConnection::handleWrite()
 {
   loop_->assertInLoopThread();
   if (channel_->isWriting())
   {
-    ssize_t n = sockets::write(channel_->fd(),
-                               outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());
-    if (n > 0)
+    ssize_t n = writeOutput();
+    if (n >= 0)
     {
-      outputBuffer_.retrieve(n);
-      if (outputBuffer_.readableBytes() == 0)
+      if (channel_->isEdgeTriggered())
+      {
+        size_t total = n;
+        while (outputBytes() > 0)
+        {
+          if (total >= ioBudget_)
+          {
+            // out of budget, no more edge will come while it's writable.
+            loop_->queueInLoop(std::bind(&TcpConnection::handleWrite,
+                                         shared_from_this()));
+            break;
+          }
+          n = writeOutput();
+          if (n < 0)
+          {
+            // EAGAIN, the next edge comes when the socket drains.
+            if (errno != EWOULDBLOCK && state_ != kDisconnected)
+            {
+              LOG_SYSERR << "TcpConnection::handleWrite";
+            }
+            break;
+          }
+          total += n;
+        }
+      }
+      if (state_ == kDisconnected)
+      {
+        return;  // closed by a short or failed file
+      }
+      trimBuffer(&outputBuffer_);
+      updateFlowControl();
+      if (outputBytes() == 0)
       {
         channel_->disableWriting();
-        if (writeCompleteCallback_)
+        if (callbacks_->writeComplete)
         {
-          loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+          loop_->queueInLoop(std::bind(callbacks_->writeComplete, shared_from_this()));
         }
         if (state_ == kDisconnecting)
         {
@@ -389,7 +988,8 @@ void TcpConnection::handleWrite()
         }
       }
     }
-    else
+    else if (state_ != kDisconnected
+             && (!channel_->isEdgeTriggered() || errno != EWOULDBLOCK))
     {
       LOG_SYSERR << "TcpConnection::handleWrite";
       // if (state_ == kDisconnecting)
@@ -405,6 +1005,134 @@ void TcpConnection::handleWrite()
   }
 }
 
+ssize_t TcpConnection::readInput(int* savedErrno)
+{
+  ssize_t n = inputBuffer_.readFd(channel_->fd(), savedErrno);
+  ++stats_.readCalls;
+  if (n > 0)
+  {
+    stats_.bytesReceived += n;
+    lastActive_ = loop_->pollReturnTime().microSecondsSinceEpoch();
+  }
+  return n;
+}
+
+void TcpConnection::handleMessage(Timestamp receiveTime)
+{
+  stats_.lastReceiveTime = receiveTime;
+  ++stats_.messageCallbacks;
+  // held, in case it sets another MessageCallback
+  CallbacksPtr callbacks(callbacks_);
+  if (!loop_->healthStatsEnabled())
+  {
+    callbacks->message(shared_from_this(), &inputBuffer_, receiveTime);
+    return;
+  }
+  const Timestamp start(Timestamp::now());
+  callbacks->message(shared_from_this(), &inputBuffer_, receiveTime);
+  const int64_t used = Timestamp::now().microSecondsSinceEpoch()
+                       - start.microSecondsSinceEpoch();
+  stats_.callbackMicroSeconds += used;
+  stats_.maxCallbackMicroSeconds = std::max(stats_.maxCallbackMicroSeconds, used);
+}
+
+void TcpConnection::countWrite(ssize_t n)
+{
+  ++stats_.writeCalls;
+  if (n > 0)
+  {
+    stats_.bytesSent += n;
+    lastActive_ = loop_->pollReturnTime().microSecondsSinceEpoch();
+  }
+}
+
+ssize_t TcpConnection::writeOutput()
+{
+  const size_t buffered = outputBuffer_.readableBytes();
+  int fileFd = -1;
+  off_t offset = 0;
+  size_t fileLen = 0;
+  if (buffered == 0 && outputChain_.peekFile(&fileFd, &offset, &fileLen))
+  {
+    ssize_t n = sockets::sendfile(channel_->fd(), fileFd, &offset, fileLen);
+    countWrite(n);
+    if (n > 0)
+    {
+      outputChain_.retrieve(n);
+    }
+    else if (n == 0 || (errno != EWOULDBLOCK && errno != EINTR))
+    {
+      // skipping it would corrupt the stream, the peer can't tell,
+      // retrying a persistent error would spin the loop
+      if (n == 0)
+      {
+        LOG_ERROR << "TcpConnection::writeOutput - file " << fileFd
+                  << " ends before offset " << offset << ", closing";
+      }
+      else
+      {
+        LOG_SYSERR << "TcpConnection::writeOutput - file " << fileFd << ", closing";
+      }
+      outputBuffer_.retrieveAll();
+      outputChain_.retrieveAll();
+      forceCloseInLoop();
+      errno = EIO;
+      n = -1;
+    }
+    return n;
+  }
+
+  const char* data = NULL;
+  size_t len = 0;
+  std::shared_ptr<const void> holder;
+  if (buffered == 0 && outputChain_.peekZeroCopy(&data, &len, &holder))
+  {
+    ssize_t n = sockets::sendZeroCopy(channel_->fd(), data, len);
+    countWrite(n);
+    if (n > 0)
+    {
+      // pinned until the kernel completes it
+      if (!zeroCopyPending_)
+      {
+        zeroCopyPending_.reset(new std::deque<ZeroCopyPending>);
+      }
+      ZeroCopyPending pending = { zeroCopySeq_++, false, std::move(holder) };
+      zeroCopyPending_->push_back(std::move(pending));
+    }
+    else if (n < 0 && errno == ENOBUFS)
+    {
+      // over the optmem limit, copy this time
+      n = sockets::write(channel_->fd(), data, len);
+      countWrite(n);
+    }
+    if (n > 0)
+    {
+      outputChain_.retrieve(n);
+    }
+    return n;
+  }
+
+  // outputBuffer_ then outputChain_, in one writev(2)
+  struct iovec vec[kMaxIovec];
+  int iovcnt = 0;
+  if (buffered > 0)
+  {
+    vec[0].iov_base = const_cast<char*>(outputBuffer_.peek());
+    vec[0].iov_len = buffered;
+    iovcnt = 1;
+  }
+  iovcnt += outputChain_.peekIovec(vec + iovcnt, kMaxIovec - iovcnt);
+  ssize_t n = sockets::writev(channel_->fd(), vec, iovcnt);
+  countWrite(n);
+  if (n > 0)
+  {
+    size_t fromBuffer = std::min(implicit_cast<size_t>(n), buffered);
+    outputBuffer_.retrieve(fromBuffer);
+    outputChain_.retrieve(n - fromBuffer);
+  }
+  return n;
+}
+
 void TcpConnection::handleClose()
 {
   loop_->assertInLoopThread();
@@ -413,17 +1141,69 @@ void TcpConnection::handleClose()
   // we don't close fd, leave it to dtor, so we can find leaks easily.
   setState(kDisconnected);
   channel_->disableAll();
+  leaveIdleWheel();
+  if (flowPausing_)
+  {
+    // nothing more to send, let the source go
+    flowPausing_ = false;
+    pauseFlowSource(false);
+  }
 
   TcpConnectionPtr guardThis(shared_from_this());
-  connectionCallback_(guardThis);
+  callbacks_->connection(guardThis);
   // must be the last line
   closeCallback_(guardThis);
 }
 
 void TcpConnection::handleError()
 {
+  if (isZeroCopy())
+  {
+    // POLLERR also stands for completions on the error queue
+    handleZeroCopyCompletions();
+  }
   int err = sockets::getSocketError(channel_->fd());
-  LOG_ERROR << "TcpConnection::handleError [" << name_
-            << "] - SO_ERROR = " << err << " " << strerror_tl(err);
+  if (err != 0 || !isZeroCopy())
+  {
+    LOG_ERROR << "TcpConnection::handleError [" << name()
+              << "] - SO_ERROR = " << err << " " << strerror_tl(err);
+  }
+}
+
+void TcpConnection::handleZeroCopyCompletions()
+{
+  loop_->assertInLoopThread();
+  uint32_t lo = 0;
+  uint32_t hi = 0;
+  bool copied = false;
+  int ret = 0;
+  while ((ret = sockets::readZeroCopyCompletion(channel_->fd(), &lo, &hi, &copied)) >= 0)
+  {
+    if (ret == 0)
+    {
+      continue;
+    }
+    LOG_TRACE << "TcpConnection::handleZeroCopyCompletions [" << name()
+              << "] - [" << lo << ", " << hi << "]"
+              << (copied ? " copied" : "");
+    if (!zeroCopyPending_)
+    {
+      continue;
+    }
+    for (std::deque<ZeroCopyPending>::iterator it = zeroCopyPending_->begin();
+         it != zeroCopyPending_->end(); ++it)
+    {
+      // wraps around
+      if (it->seq - lo <= hi - lo)
+      {
+        it->done = true;
+      }
+    }
+  }
+  // releases slices in order
+  while (zeroCopyPending_ && !zeroCopyPending_->empty() && zeroCopyPending_->front().done)
+  {
+    zeroCopyPending_->pop_front();
+  }
 }
 
@@ -11,14 +11,21 @@
 #ifndef MUDUO_NET_TCPCONNECTION_H
 #define MUDUO_NET_TCPCONNECTION_H
 
+#include "muduo/base/Mutex.h"
 #include "muduo/base/noncopyable.h"
 #include "muduo/base/StringPiece.h"
+#include "muduo/base/Timestamp.h"
 #include "muduo/base/Types.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/Buffer.h"
+#include "muduo/net/ChainBuffer.h"
 #include "muduo/net/InetAddress.h"
+#include "muduo/net/Slice.h"
 
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <boost/any.hpp>
 
@@ -42,6 +49,36 @@ class TcpConnection : noncopyable,
                       public std::enable_shared_from_this<TcpConnection>
 {
  public:
+  static const size_t kDefaultIoBudget = 256*1024;
+  static const size_t kDefaultZeroCopyThreshold = 64*1024;
+  static const size_t kDefaultBufferShrinkThreshold = 64*1024;
+
+  /// Counters of one connection, plain values kept by its loop.
+  struct Stats
+  {
+    Timestamp creationTime;
+    Timestamp lastReceiveTime;
+    int64_t bytesReceived;
+    int64_t bytesSent;
+    int64_t readCalls;   // readv(2), including EAGAIN
+    int64_t writeCalls;  // write(2), writev(2), sendfile(2) and sendmsg(2)
+    int64_t messageCallbacks;
+    int64_t callbackMicroSeconds;  // spent in MessageCallback, timed only
+                                   // if EventLoop::enableHealthStats()
+    int64_t maxCallbackMicroSeconds;
+    size_t maxOutputBytes;  // the deepest output queue so far
+  };
+
+  /// User callbacks, one copy shared by all connections of a TcpServer.
+  struct Callbacks
+  {
+    ConnectionCallback connection;
+    MessageCallback message;
+    WriteCompleteCallback writeComplete;
+    HighWaterMarkCallback highWaterMark;
+  };
+  typedef std::shared_ptr<const Callbacks> CallbacksPtr;
+
   /// Constructs a TcpConnection with a connected sockfd
   ///
   /// User should not create this object.
@@ -49,11 +86,22 @@ class TcpConnection : noncopyable,
                 const string& name,
                 int sockfd,
                 const InetAddress& localAddr,
+                const InetAddress& peerAddr,
+                int64_t id = 0);
+  /// Named *namePrefix + id, built on first call to name().
+  TcpConnection(EventLoop* loop,
+                int64_t id,
+                const std::shared_ptr<const string>& namePrefix,
+                int sockfd,
+                const InetAddress& localAddr,
                 const InetAddress& peerAddr);
   ~TcpConnection();
 
   EventLoop* getLoop() const { return loop_; }
-  const string& name() const { return name_; }
+  /// Sequence number given by the owning TcpServer or TcpClient.
+  int64_t id() const { return id_; }
+  /// Thread safe.
+  const string& name() const;
   const InetAddress& localAddress() const { return localAddr_; }
   const InetAddress& peerAddress() const { return peerAddr_; }
   bool connected() const { return state_ == kConnected; }
@@ -61,22 +109,61 @@ class TcpConnection : noncopyable,
   // return true if success.
   bool getTcpInfo(struct tcp_info*) const;
   string getTcpInfoString() const;
+  /// Must be called in loop thread, see TcpServer::connections().
+  const Stats& stats() const { return stats_; }
 
-  // void send(string&& message); // C++11
+  // Off the loop thread, messages are queued without copying when possible,
+  // those sent before the loop picks them up go in one task and one writev(2).
   void send(const void* message, int len);
   void send(const StringPiece& message);
-  // void send(Buffer&& message); // C++11
+  void send(const char* message)
+  { send(StringPiece(message)); }
+  /// Takes over @c message, not copied in other threads.
+  void send(string&& message);
   void send(Buffer* message);  // this one will swap data
+  /// Takes over the readable bytes of @c message, not copied in other threads.
+  void send(Buffer&& message);
+  /// Sends without copying, @c message is referenced until sent,
+  /// or until the kernel is done with it for zero-copy.
+  void send(const Slice& message);
+  /// Sends [offset, offset+length) of file @c fd with sendfile(2),
+  /// after everything sent before.
+  /// Takes the ownership of @c fd, which is closed when all sent,
+  /// or when the connection is gone.
+  void sendFile(int fd, off_t offset, size_t length);
   void shutdown(); // NOT thread safe, no simultaneous calling
   // void shutdownAndForceCloseAfter(double seconds); // NOT thread safe, no simultaneous calling
   void forceClose();
   void forceCloseWithDelay(double seconds);
   void setTcpNoDelay(bool on);
-  // reading or not
+  /// SO_BUSY_POLL, see Socket::setBusyPoll().
+  void setBusyPoll(int microSeconds);
+  // reading or not, as wanted by the user, flow control pauses it apart
   void startRead();
   void stopRead();
   bool isReading() const { return reading_; }; // NOT thread safe, may race with start/stopReadInLoop
 
+  /// Edge-triggered I/O, reads and writes drain the socket until EAGAIN,
+  /// but move at most @c ioBudget bytes per event to stay fair to others.
+  /// Stays level-triggered if the poller doesn't support it, eg. poll(2).
+  /// Must be called before connectEstablished().
+  void setEdgeTriggered(size_t ioBudget = kDefaultIoBudget);
+  bool isEdgeTriggered() const;
+
+  /// Sends Slices of @c threshold bytes or more with MSG_ZEROCOPY,
+  /// the kernel reads them in place, and reports completions on
+  /// the socket error queue.  Pays off for large payloads only.
+  /// Call it in loop thread, eg. in ConnectionCallback.
+  /// @return false if SO_ZEROCOPY is not supported.
+  bool setZeroCopy(size_t threshold = kDefaultZeroCopyThreshold);
+  bool isZeroCopy() const { return zeroCopyThreshold_ > 0; }
+
+  /// Buffers are given back to the BufferPool of the loop once drained,
+  /// and shrunk if larger than @c threshold but mostly empty.
+  /// 0 for never shrinking.
+  void setBufferShrinkThreshold(size_t threshold)
+  { bufferShrinkThreshold_ = threshold; }
+
   void setContext(const boost::any& context)
   { context_ = context; }
 
@@ -86,17 +173,35 @@ class TcpConnection : noncopyable,
   boost::any* getMutableContext()
   { return &context_; }
 
-  void setConnectionCallback(const ConnectionCallback& cb)
-  { connectionCallback_ = cb; }
+  /// Shares @c callbacks with other connections,
+  /// a setXxxCallback() below gives this one its own copy.
+  void setCallbacks(const CallbacksPtr& callbacks)
+  { callbacks_ = callbacks; }
 
-  void setMessageCallback(const MessageCallback& cb)
-  { messageCallback_ = cb; }
+  void setConnectionCallback(const ConnectionCallback& cb);
+  void setMessageCallback(const MessageCallback& cb);
+  void setWriteCompleteCallback(const WriteCompleteCallback& cb);
+  void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark);
 
-  void setWriteCompleteCallback(const WriteCompleteCallback& cb)
-  { writeCompleteCallback_ = cb; }
+  ///
+  /// Flow control by the output of this connection, pauses reading of
+  /// @c source once outputBytes() reaches @c highWaterMark,
+  /// and resumes it once drained to @c lowWaterMark.
+  /// @c source is this connection if null, for request-response,
+  /// or the peer of a relay, which sends here what it reads.
+  /// A source paused by several connections resumes after all of them.
+  /// 0 highWaterMark for off.  Call it in loop thread, eg. in ConnectionCallback.
+  void setFlowControl(size_t highWaterMark, size_t lowWaterMark,
+                      const TcpConnectionPtr& source = TcpConnectionPtr());
+  /// Reading of this connection is paused by flow control.
+  bool isReadPaused() const { return readPauses_ > 0; }
 
-  void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
-  { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
+  /// Closes this connection once neither read nor written for @c seconds,
+  /// by a wheel of its loop, no timer of its own.  0 for off.
+  /// Call it in loop thread, eg. in ConnectionCallback, or before established.
+  void setIdleTimeout(double seconds);
+  double idleTimeout() const
+  { return static_cast<double>(idleTimeout_) / Timestamp::kMicroSecondsPerSecond; }
 
   /// Advanced interface
   Buffer* inputBuffer()
@@ -105,6 +210,10 @@ class TcpConnection : noncopyable,
   Buffer* outputBuffer()
   { return &outputBuffer_; }
 
+  /// Bytes waiting to be written, including those queued beyond outputBuffer().
+  size_t outputBytes() const
+  { return outputBuffer_.readableBytes() + outputChain_.readableBytes(); }
+
   /// Internal use only.
   void setCloseCallback(const CloseCallback& cb)
   { closeCallback_ = cb; }
@@ -117,12 +226,23 @@ class TcpConnection : noncopyable,
  private:
   enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
   void handleRead(Timestamp receiveTime);
+  void handleReadEdgeTriggered(Timestamp receiveTime);
   void handleWrite();
   void handleClose();
   void handleError();
-  // void sendInLoop(string&& message);
+  void handleZeroCopyCompletions();
+  void handleMessage(Timestamp receiveTime);
+  ssize_t readInput(int* savedErrno);
+  void countWrite(ssize_t n);
+  ssize_t writeOutput();
   void sendInLoop(const StringPiece& message);
   void sendInLoop(const void* message, size_t len);
+  void sendInLoop(const Slice& message);
+  void sendInLoop(const Slice* messages, size_t count);
+  void queueSend(Slice&& message);
+  void sendQueuedInLoop(const std::shared_ptr<std::vector<Slice>>& batch);
+  void sendFileInLoop(const std::shared_ptr<const void>& holder,
+                      int fd, off_t offset, size_t length);
   void shutdownInLoop();
   // void shutdownAndForceCloseInLoop(double seconds);
   void forceCloseInLoop();
@@ -130,9 +250,22 @@ class TcpConnection : noncopyable,
   const char* stateToString() const;
   void startReadInLoop();
   void stopReadInLoop();
+  void pauseReadInLoop();
+  void resumeReadInLoop();
+  void updateReading();
+  void updateFlowControl();
+  void pauseFlowSource(bool pause);
+  void trimBuffer(Buffer* buf);
+  void leaveIdleWheel();
+  Callbacks* ownCallbacks();
+  void init();
+  void buildName() const;
 
   EventLoop* loop_;
-  const string name_;
+  const int64_t id_;
+  const std::shared_ptr<const string> namePrefix_;  // NULL if named already
+  mutable std::once_flag nameOnce_;
+  mutable string name_;
   StateE state_;  // FIXME: use atomic variable
   bool reading_;
   // we don't expose those classes to client.
@@ -140,17 +273,49 @@ class TcpConnection : noncopyable,
   std::unique_ptr<Channel> channel_;
   const InetAddress localAddr_;
   const InetAddress peerAddr_;
-  ConnectionCallback connectionCallback_;
-  MessageCallback messageCallback_;
-  WriteCompleteCallback writeCompleteCallback_;
-  HighWaterMarkCallback highWaterMarkCallback_;
+  CallbacksPtr callbacks_;
   CloseCallback closeCallback_;
   size_t highWaterMark_;
+  size_t flowHighWaterMark_;  // 0 for off
+  size_t flowLowWaterMark_;
+  bool flowSelf_;
+  bool flowPausing_;  // the source is paused by us
+  std::weak_ptr<TcpConnection> flowSource_;
+  int readPauses_;  // by flow control of this or other connections
+  size_t ioBudget_;  // edge-triggered only
+  size_t bufferShrinkThreshold_;
+  // no storage until needed, and none again once drained
   Buffer inputBuffer_;
-  Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
+  Buffer outputBuffer_;
+  // large payloads, and everything after them, are queued here,
+  // to be written after outputBuffer_.
+  ChainBuffer outputChain_;
+
+  struct ZeroCopyPending
+  {
+    uint32_t seq;
+    bool done;
+    std::shared_ptr<const void> holder;
+  };
+  size_t zeroCopyThreshold_;  // 0 for off
+  uint32_t zeroCopySeq_;      // of the next MSG_ZEROCOPY send
+  // sent with MSG_ZEROCOPY, but not completed by the kernel yet,
+  // created by the first such send
+  std::unique_ptr<std::deque<ZeroCopyPending>> zeroCopyPending_;
+  // sent by other threads, in batches of one sendQueuedInLoop() each,
+  // the last one is open until anything else is queued in the loop
+  MutexLock queuedMutex_;
+  std::shared_ptr<std::vector<Slice>> queuedSends_ GUARDED_BY(queuedMutex_);
+  uint64_t queuedSeq_ GUARDED_BY(queuedMutex_);  // EventLoop::functorsQueued() after it
   boost::any context_;
-  // FIXME: creationTime_, lastReceiveTime_
-  //        bytesReceived_, bytesSent_
+  Stats stats_;
+
+  friend class IdleWheel;
+  int64_t idleTimeout_;  // in microseconds, 0 for off
+  int64_t lastActive_;   // of reads and writes, in microseconds since epoch
+  int idleBucket_;       // -1 if not in the IdleWheel
+  TcpConnection* idlePrev_;
+  TcpConnection* idleNext_;
 };
 
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
@@ -8,29 +8,57 @@
 
 #include "muduo/net/TcpServer.h"
 
+#include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Acceptor.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/SocketsOps.h"
 
-#include <stdio.h>  // snprintf
+#include <algorithm>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+
+void listenAndCountDown(Acceptor* acceptor, CountDownLatch* latch)
+{
+  acceptor->listen();
+  latch->countDown();
+}
+
+void resetAndCountDown(std::unique_ptr<Acceptor>* acceptor, CountDownLatch* latch)
+{
+  acceptor->reset();
+  latch->countDown();
+}
+
+}  // namespace
+
 TcpServer::TcpServer(EventLoop* loop,
                      const InetAddress& listenAddr,
                      const string& nameArg,
                      Option option)
   : loop_(CHECK_NOTNULL(loop)),
+    listenAddr_(listenAddr),
     ipPort_(listenAddr.toIpPort()),
     name_(nameArg),
-    acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
+    option_(option),
+    connNamePrefix_(std::make_shared<const string>(name_ + "-" + ipPort_ + "#")),
+    acceptor_(new Acceptor(loop, listenAddr, option != kNoReusePort)),
     threadPool_(new EventLoopThreadPool(loop, name_)),
-    connectionCallback_(defaultConnectionCallback),
-    messageCallback_(defaultMessageCallback),
-    nextConnId_(1)
+    callbacks_(new TcpConnection::Callbacks{ defaultConnectionCallback,
+                                             defaultMessageCallback,
+                                             WriteCompleteCallback(),
+                                             HighWaterMarkCallback() }),
+    ioBudget_(0),
+    idleTimeout_(0.0),
+    acceptBatch_(Acceptor::kDefaultAcceptBatch),
+    cpuSteering_(false),
+    busyPollMicroSeconds_(0),
+    socketBusyPoll_(false)
 {
   acceptor_->setNewConnectionCallback(
       std::bind(&TcpServer::newConnection, this, _1, _2));
@@ -41,10 +69,29 @@ TcpServer::~TcpServer()
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
 
-  for (auto& item : connections_)
+  for (auto& acceptor : loopAcceptors_)
+  {
+    // Acceptor must be destructed in its loop
+    CountDownLatch latch(1);
+    acceptor->getLoop()->runInLoop(
+        std::bind(resetAndCountDown, &acceptor, &latch));
+    latch.wait();
+  }
+
+  ConnectionList connections;
+  {
+    MutexLockGuard lock(mutex_);
+    for (auto& item : connections_)
+    {
+      if (item)
+      {
+        connections.push_back(item);
+        item.reset();
+      }
+    }
+  }
+  for (const TcpConnectionPtr& conn : connections)
   {
-    TcpConnectionPtr conn(item.second);
-    item.second.reset();
     conn->getLoop()->runInLoop(
       std::bind(&TcpConnection::connectDestroyed, conn));
   }
@@ -56,63 +103,213 @@ void TcpServer::setThreadNum(int numThreads)
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setLoadBalance(LoadBalance policy)
+{
+  switch (policy)
+  {
+    case kRoundRobin:
+      threadPool_->setLoopSelector(EventLoopThreadPool::LoopSelector());
+      break;
+    case kLeastConnections:
+      threadPool_->setLoopSelector(&EventLoopThreadPool::leastConnections);
+      break;
+    case kLeastQueueSize:
+      threadPool_->setLoopSelector(&EventLoopThreadPool::leastQueueSize);
+      break;
+    case kPowerOfTwoChoices:
+      threadPool_->setLoopSelector(&EventLoopThreadPool::powerOfTwoChoices);
+      break;
+  }
+}
+
+void TcpServer::setAcceptBatch(int batch)
+{
+  assert(batch > 0);
+  acceptBatch_ = batch;
+  acceptor_->setAcceptBatch(batch);
+}
+
+TcpServer::AcceptStats TcpServer::acceptStats() const
+{
+  AcceptStats stats = { 0, 0, 0, 0 };
+  std::vector<const Acceptor*> acceptors(1, get_pointer(acceptor_));
+  for (const auto& acceptor : loopAcceptors_)
+  {
+    acceptors.push_back(get_pointer(acceptor));
+  }
+  for (const Acceptor* acceptor : acceptors)
+  {
+    stats.accepted += acceptor->numAccepted();
+    stats.shed += acceptor->numShed();
+    stats.batches += acceptor->numBatches();
+    stats.maxBatch = std::max(stats.maxBatch, acceptor->maxBatch());
+  }
+  return stats;
+}
+
+std::vector<TcpConnectionPtr> TcpServer::connections() const
+{
+  std::vector<TcpConnectionPtr> result;
+  MutexLockGuard lock(mutex_);
+  result.reserve(connections_.size() - freeSlots_.size());
+  for (const TcpConnectionPtr& conn : connections_)
+  {
+    if (conn)
+    {
+      result.push_back(conn);
+    }
+  }
+  return result;
+}
+
+void TcpServer::setConnectionCallback(const ConnectionCallback& cb)
+{
+  copyCallbacks()->connection = cb;
+}
+
+void TcpServer::setMessageCallback(const MessageCallback& cb)
+{
+  copyCallbacks()->message = cb;
+}
+
+void TcpServer::setWriteCompleteCallback(const WriteCompleteCallback& cb)
+{
+  copyCallbacks()->writeComplete = cb;
+}
+
+TcpConnection::Callbacks* TcpServer::copyCallbacks()
+{
+  // connections made so far keep the old ones
+  std::shared_ptr<TcpConnection::Callbacks> callbacks(
+      new TcpConnection::Callbacks(*callbacks_));
+  callbacks_ = callbacks;
+  return get_pointer(callbacks);
+}
+
 void TcpServer::start()
 {
   if (started_.getAndSet(1) == 0)
   {
-    threadPool_->start(threadInitCallback_);
+    threadPool_->start(threadInitCallback_, affinity_);
+    if (busyPollMicroSeconds_ > 0)
+    {
+      for (EventLoop* ioLoop : threadPool_->getAllLoops())
+      {
+        ioLoop->runInLoop(
+            std::bind(&EventLoop::setBusyPoll, ioLoop, busyPollMicroSeconds_));
+      }
+    }
 
     assert(!acceptor_->listenning());
-    loop_->runInLoop(
-        std::bind(&Acceptor::listen, get_pointer(acceptor_)));
+    if (option_ == kReusePortPerLoop && threadPool_->getAllLoops()[0] != loop_
+        && !listenAddr_.isUnixDomain())
+    {
+      // acceptor_ stays bound, but never listens
+      startPerLoopAcceptors();
+    }
+    else
+    {
+      loop_->runInLoop(
+          std::bind(&Acceptor::listen, get_pointer(acceptor_)));
+    }
+  }
+}
+
+void TcpServer::startPerLoopAcceptors()
+{
+  std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+  for (EventLoop* ioLoop : loops)
+  {
+    std::unique_ptr<Acceptor> acceptor(new Acceptor(ioLoop, listenAddr_, true));
+    acceptor->setNewConnectionCallback(
+        std::bind(&TcpServer::createConnection, this, _1, _2, ioLoop));
+    acceptor->setAcceptBatch(acceptBatch_);
+    loopAcceptors_.push_back(std::move(acceptor));
+  }
+  if (cpuSteering_)
+  {
+    loopAcceptors_[0]->setCpuSteering(static_cast<int>(loops.size()));
+  }
+  // one by one, so that the index of a socket in the group is the index of its loop
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    CountDownLatch latch(1);
+    loops[i]->runInLoop(
+        std::bind(listenAndCountDown, get_pointer(loopAcceptors_[i]), &latch));
+    latch.wait();
   }
 }
 
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
   loop_->assertInLoopThread();
-  EventLoop* ioLoop = threadPool_->getNextLoop();
-  char buf[64];
-  snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
-  ++nextConnId_;
-  string connName = name_ + buf;
+  createConnection(sockfd, peerAddr, threadPool_->getNextLoop());
+}
+
+void TcpServer::createConnection(int sockfd, const InetAddress& peerAddr, EventLoop* ioLoop)
+{
+  const int64_t connId = nextConnId_.incrementAndGet();
 
   LOG_INFO << "TcpServer::newConnection [" << name_
-           << "] - new connection [" << connName
-           << "] from " << peerAddr.toIpPort();
+           << "] - new connection #" << connId
+           << " from " << peerAddr.toIpPort();
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
   // FIXME use make_shared if necessary
   TcpConnectionPtr conn(new TcpConnection(ioLoop,
-                                          connName,
+                                          connId,
+                                          connNamePrefix_,
                                           sockfd,
                                           localAddr,
                                           peerAddr));
-  connections_[connName] = conn;
-  conn->setConnectionCallback(connectionCallback_);
-  conn->setMessageCallback(messageCallback_);
-  conn->setWriteCompleteCallback(writeCompleteCallback_);
+  size_t slot = 0;
+  {
+    MutexLockGuard lock(mutex_);
+    if (freeSlots_.empty())
+    {
+      slot = connections_.size();
+      connections_.push_back(conn);
+    }
+    else
+    {
+      slot = freeSlots_.back();
+      freeSlots_.pop_back();
+      assert(!connections_[slot]);
+      connections_[slot] = conn;
+    }
+  }
+  conn->setCallbacks(callbacks_);
+  if (ioBudget_ > 0)
+  {
+    conn->setEdgeTriggered(ioBudget_);
+  }
+  if (idleTimeout_ > 0)
+  {
+    conn->setIdleTimeout(idleTimeout_);
+  }
+  if (socketBusyPoll_ && busyPollMicroSeconds_ > 0)
+  {
+    conn->setBusyPoll(busyPollMicroSeconds_);
+  }
   conn->setCloseCallback(
-      std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
+      std::bind(&TcpServer::removeConnection, this, _1, slot)); // FIXME: unsafe
+  // in place if accepted by ioLoop
   ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
 }
 
-void TcpServer::removeConnection(const TcpConnectionPtr& conn)
+void TcpServer::removeConnection(const TcpConnectionPtr& conn, size_t slot)
 {
   // FIXME: unsafe
-  loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
-}
-
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
-{
-  loop_->assertInLoopThread();
-  LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_
-           << "] - connection " << conn->name();
-  size_t n = connections_.erase(conn->name());
-  (void)n;
-  assert(n == 1);
-  EventLoop* ioLoop = conn->getLoop();
-  ioLoop->queueInLoop(
-      std::bind(&TcpConnection::connectDestroyed, conn));
+  LOG_INFO << "TcpServer::removeConnection [" << name_
+           << "] - connection #" << conn->id();
+  MutexLockGuard lock(mutex_);
+  // taken by ~TcpServer() already
+  if (connections_[slot] == conn)
+  {
+    connections_[slot].reset();
+    freeSlots_.push_back(slot);
+    EventLoop* ioLoop = conn->getLoop();
+    ioLoop->queueInLoop(
+        std::bind(&TcpConnection::connectDestroyed, conn));
+  }
 }
-
@@ -12,10 +12,12 @@
 #define MUDUO_NET_TCPSERVER_H
 
 #include "muduo/base/Atomic.h"
+#include "muduo/base/CpuAffinity.h"
+#include "muduo/base/Mutex.h"
 #include "muduo/base/Types.h"
 #include "muduo/net/TcpConnection.h"
 
-#include <map>
+#include <vector>
 
 namespace muduo
 {
@@ -34,10 +36,29 @@ class TcpServer : noncopyable
 {
  public:
   typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  /// How setThreadNum() loops are picked for new connections.
+  enum LoadBalance
+  {
+    kRoundRobin,
+    kLeastConnections,
+    kLeastQueueSize,     // fewest pending functors
+    kPowerOfTwoChoices,  // fewer connections of two random loops
+  };
+  struct AcceptStats
+  {
+    int64_t accepted;
+    int64_t shed;      // closed right away, eg. out of file descriptors
+    int64_t batches;   // readable events of listening sockets
+    int64_t maxBatch;  // the most connections accepted in one event
+  };
   enum Option
   {
     kNoReusePort,
     kReusePort,
+    /// Every I/O loop listens on its own SO_REUSEPORT socket
+    /// and accepts locally, the kernel spreads new connections.
+    /// Same as kReusePort if setThreadNum(0), or for a Unix domain socket.
+    kReusePortPerLoop,
   };
 
   //TcpServer(EventLoop* loop, const InetAddress& listenAddr);
@@ -60,14 +81,63 @@ class TcpServer : noncopyable
   ///   this is the default value.
   /// - 1 means all I/O in another thread.
   /// - N means a thread pool with N threads, new connections
-  ///   are assigned on a round-robin basis.
+  ///   are assigned on a round-robin basis, see setLoadBalance().
   void setThreadNum(int numThreads);
   void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
+  /// Pins I/O threads, see EventLoopThreadPool::start().
+  /// Must be called before @c start
+  void setCpuAffinity(const CpuAffinity& affinity)
+  { affinity_ = affinity; }
+  /// Not for kReusePortPerLoop, where the kernel picks.
+  /// Must be called before @c start
+  void setLoadBalance(LoadBalance policy);
   /// valid after calling start()
   std::shared_ptr<EventLoopThreadPool> threadPool()
   { return threadPool_; }
 
+  /// Edge-triggered I/O for new connections,
+  /// see TcpConnection::setEdgeTriggered().
+  /// @param ioBudget 0 means level-triggered, the default.
+  /// Not thread safe.
+  void setEdgeTriggered(size_t ioBudget = TcpConnection::kDefaultIoBudget)
+  { ioBudget_ = ioBudget; }
+
+  /// Closes connections neither read nor written for @c seconds,
+  /// see TcpConnection::setIdleTimeout().  0 for off, the default.
+  /// Not thread safe, applies to new connections.
+  void setIdleTimeout(double seconds)
+  { idleTimeout_ = seconds; }
+
+  /// Accepts at most @c batch connections per readable event.
+  /// Must be called before @c start
+  void setAcceptBatch(int batch);
+
+  /// Of all listening sockets.  Thread safe after @c start.
+  AcceptStats acceptStats() const;
+
+  /// A snapshot of live connections, eg. to walk their stats()
+  /// in their own loops.  Thread safe.
+  std::vector<TcpConnectionPtr> connections() const;
+
+  /// With kReusePortPerLoop, the connection goes to I/O loop of index
+  /// (CPU which received it % number of loops), by a classic BPF program.
+  /// Pays off if I/O loop i runs on CPU i, and NIC queues are bound to CPUs.
+  /// Must be called before @c start
+  void setCpuSteering(bool on)
+  { cpuSteering_ = on; }
+
+  /// I/O loops spin for up to @c microSeconds before blocking,
+  /// see EventLoop::setBusyPoll().
+  /// Also sets SO_BUSY_POLL of new connections if @c socketBusyPoll,
+  /// which only helps if the NIC driver supports it.
+  /// Must be called before @c start
+  void setBusyPoll(int microSeconds, bool socketBusyPoll = false)
+  {
+    busyPollMicroSeconds_ = microSeconds;
+    socketBusyPoll_ = socketBusyPoll;
+  }
+
   /// Starts the server if it's not listenning.
   ///
   /// It's harmless to call it multiple times.
@@ -76,42 +146,57 @@ class TcpServer : noncopyable
 
   /// Set connection callback.
   /// Not thread safe.
-  void setConnectionCallback(const ConnectionCallback& cb)
-  { connectionCallback_ = cb; }
+  void setConnectionCallback(const ConnectionCallback& cb);
 
   /// Set message callback.
   /// Not thread safe.
-  void setMessageCallback(const MessageCallback& cb)
-  { messageCallback_ = cb; }
+  void setMessageCallback(const MessageCallback& cb);
 
   /// Set write complete callback.
   /// Not thread safe.
-  void setWriteCompleteCallback(const WriteCompleteCallback& cb)
-  { writeCompleteCallback_ = cb; }
+  void setWriteCompleteCallback(const WriteCompleteCallback& cb);
 
  private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress& peerAddr);
   /// Thread safe.
-  void removeConnection(const TcpConnectionPtr& conn);
-  /// Not thread safe, but in loop
-  void removeConnectionInLoop(const TcpConnectionPtr& conn);
+  void createConnection(int sockfd, const InetAddress& peerAddr, EventLoop* ioLoop);
+  /// Thread safe.
+  void removeConnection(const TcpConnectionPtr& conn, size_t slot);
+  void startPerLoopAcceptors();
+  TcpConnection::Callbacks* copyCallbacks();
 
-  typedef std::map<string, TcpConnectionPtr> ConnectionMap;
+  // slots of closed connections are reused, no lookup by name.
+  typedef std::vector<TcpConnectionPtr> ConnectionList;
 
   EventLoop* loop_;  // the acceptor loop
+  const InetAddress listenAddr_;
   const string ipPort_;
   const string name_;
+  const Option option_;
+  // shared with connections, named lazily as "name-ip:port#id"
+  const std::shared_ptr<const string> connNamePrefix_;
   std::unique_ptr<Acceptor> acceptor_; // avoid revealing Acceptor
+  // one per I/O loop, for kReusePortPerLoop
+  std::vector<std::unique_ptr<Acceptor>> loopAcceptors_;
   std::shared_ptr<EventLoopThreadPool> threadPool_;
-  ConnectionCallback connectionCallback_;
-  MessageCallback messageCallback_;
-  WriteCompleteCallback writeCompleteCallback_;
+  // shared with connections, copied if set again
+  TcpConnection::CallbacksPtr callbacks_;
   ThreadInitCallback threadInitCallback_;
+  CpuAffinity affinity_;
+  size_t ioBudget_;
+  double idleTimeout_;
+  int acceptBatch_;
+  bool cpuSteering_;
+  int busyPollMicroSeconds_;
+  bool socketBusyPoll_;
   AtomicInt32 started_;
-  // always in loop thread
-  int nextConnId_;
-  ConnectionMap connections_;
+  AtomicInt64 nextConnId_;
+  // locked by createConnection() in accepting loops, and by
+  // removeConnection() in every I/O loop, in every mode
+  mutable MutexLock mutex_;
+  ConnectionList connections_ GUARDED_BY(mutex_);
+  std::vector<size_t> freeSlots_ GUARDED_BY(mutex_);
 };
 
 }  // namespace net
@@ -8,10 +8,23 @@
 
 #include "muduo/net/Timer.h"
 
+#include <assert.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
 AtomicInt64 Timer::s_numCreated_;
+AtomicInt64 Timer::s_sequence_;
+
+void Timer::reset(TimerCallback cb, Timestamp when, double interval)
+{
+  assert(bucket_ < 0);
+  callback_ = std::move(cb);
+  expiration_ = when;
+  interval_ = interval;
+  repeat_ = interval > 0.0;
+  sequence_ = s_sequence_.incrementAndGet();
+}
 
 void Timer::restart(Timestamp now)
 {
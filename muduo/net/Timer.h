@@ -31,8 +31,16 @@ class Timer : noncopyable
       expiration_(when),
       interval_(interval),
       repeat_(interval > 0.0),
-      sequence_(s_numCreated_.incrementAndGet())
-  { }
+      sequence_(s_sequence_.incrementAndGet()),
+      prev_(NULL),
+      next_(NULL),
+      bucket_(-1)
+  {
+    s_numCreated_.increment();
+  }
+
+  /// Reuses this object for another timer, with a new sequence.
+  void reset(TimerCallback cb, Timestamp when, double interval);
 
   void run() const
   {
@@ -48,13 +56,21 @@ class Timer : noncopyable
   static int64_t numCreated() { return s_numCreated_.get(); }
 
  private:
-  const TimerCallback callback_;
+  friend class TimingWheel;
+
+  TimerCallback callback_;
   Timestamp expiration_;
-  const double interval_;
-  const bool repeat_;
-  const int64_t sequence_;
+  double interval_;
+  bool repeat_;
+  int64_t sequence_;
+
+  // intrusive list of TimingWheel
+  Timer* prev_;
+  Timer* next_;
+  int bucket_;  // -1 if not in a TimingWheel
 
   static AtomicInt64 s_numCreated_;
+  static AtomicInt64 s_sequence_;  // of timers, reused ones too
 };
 
 }  // namespace net
@@ -16,7 +16,9 @@
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/Timer.h"
 #include "muduo/net/TimerId.h"
+#include "muduo/net/TimingWheel.h"
 
+#include <stdlib.h>
 #include <sys/timerfd.h>
 #include <unistd.h>
 
@@ -95,6 +97,10 @@ TimerQueue::TimerQueue(EventLoop* loop)
     timers_(),
     callingExpiredTimers_(false)
 {
+  if (::getenv("MUDUO_USE_TIMING_WHEEL"))
+  {
+    wheel_.reset(new TimingWheel(Timestamp::now()));
+  }
   timerfdChannel_.setReadCallback(
       std::bind(&TimerQueue::handleRead, this));
   // we are always reading the timerfd, we disarm it with timerfd_settime.
@@ -111,13 +117,31 @@ TimerQueue::~TimerQueue()
   {
     delete timer.second;
   }
+  if (wheel_)
+  {
+    wheel_->takeAll(&freeTimers_);
+    for (Timer* timer : freeTimers_)
+    {
+      delete timer;
+    }
+  }
 }
 
 TimerId TimerQueue::addTimer(TimerCallback cb,
                              Timestamp when,
                              double interval)
 {
-  Timer* timer = new Timer(std::move(cb), when, interval);
+  Timer* timer = NULL;
+  if (wheel_ && loop_->isInLoopThread() && !freeTimers_.empty())
+  {
+    timer = freeTimers_.back();
+    freeTimers_.pop_back();
+    timer->reset(std::move(cb), when, interval);
+  }
+  else
+  {
+    timer = new Timer(std::move(cb), when, interval);
+  }
   loop_->runInLoop(
       std::bind(&TimerQueue::addTimerInLoop, this, timer));
   return TimerId(timer, timer->sequence());
@@ -132,6 +156,11 @@ void TimerQueue::cancel(TimerId timerId)
 void TimerQueue::addTimerInLoop(Timer* timer)
 {
   loop_->assertInLoopThread();
+  if (wheel_)
+  {
+    addTimerToWheel(timer);
+    return;
+  }
   bool earliestChanged = insert(timer);
 
   if (earliestChanged)
@@ -143,6 +172,11 @@ void TimerQueue::addTimerInLoop(Timer* timer)
 void TimerQueue::cancelInLoop(TimerId timerId)
 {
   loop_->assertInLoopThread();
+  if (wheel_)
+  {
+    cancelInWheel(timerId);
+    return;
+  }
   assert(timers_.size() == activeTimers_.size());
   ActiveTimer timer(timerId.timer_, timerId.sequence_);
   ActiveTimerSet::iterator it = activeTimers_.find(timer);
@@ -165,6 +199,11 @@ void TimerQueue::handleRead()
   loop_->assertInLoopThread();
   Timestamp now(Timestamp::now());
   readTimerfd(timerfd_, now);
+  if (wheel_)
+  {
+    handleWheel(now);
+    return;
+  }
 
   std::vector<Entry> expired = getExpired(now);
 
@@ -173,6 +212,7 @@ void TimerQueue::handleRead()
   // safe to callback outside critical section
   for (const Entry& it : expired)
   {
+    loop_->recordTimerLateness(it.first, now);
     it.second->run();
   }
   callingExpiredTimers_ = false;
@@ -258,3 +298,79 @@ bool TimerQueue::insert(Timer* timer)
   return earliestChanged;
 }
 
+
+void TimerQueue::addTimerToWheel(Timer* timer)
+{
+  wheel_->add(timer);
+  Timestamp wakeup = wheel_->nextWakeup();
+  if (!wheelWakeup_.valid() || wakeup < wheelWakeup_)
+  {
+    resetWheelTimerfd();
+  }
+}
+
+void TimerQueue::cancelInWheel(TimerId timerId)
+{
+  Timer* timer = timerId.timer_;
+  // Timer objects are recycled, so timer is valid, but may be another one.
+  if (timer == NULL || timer->sequence() != timerId.sequence_)
+  {
+    return;
+  }
+  if (wheel_->contains(timer))
+  {
+    wheel_->remove(timer);
+    recycle(timer);
+  }
+  else if (callingExpiredTimers_)
+  {
+    cancelingTimers_.insert(ActiveTimer(timer, timerId.sequence_));
+  }
+}
+
+void TimerQueue::handleWheel(Timestamp now)
+{
+  expiredTimers_.clear();
+  wheel_->advance(now, &expiredTimers_);
+
+  callingExpiredTimers_ = true;
+  cancelingTimers_.clear();
+  for (Timer* timer : expiredTimers_)
+  {
+    loop_->recordTimerLateness(timer->expiration(), now);
+    timer->run();
+  }
+  callingExpiredTimers_ = false;
+
+  for (Timer* timer : expiredTimers_)
+  {
+    if (timer->repeat()
+        && cancelingTimers_.find(ActiveTimer(timer, timer->sequence())) == cancelingTimers_.end())
+    {
+      timer->restart(now);
+      wheel_->add(timer);
+    }
+    else
+    {
+      recycle(timer);
+    }
+  }
+  wheelWakeup_ = Timestamp::invalid();  // timerfd fired
+  resetWheelTimerfd();
+}
+
+void TimerQueue::resetWheelTimerfd()
+{
+  wheelWakeup_ = wheel_->nextWakeup();
+  if (wheelWakeup_.valid())
+  {
+    resetTimerfd(timerfd_, wheelWakeup_);
+  }
+}
+
+void TimerQueue::recycle(Timer* timer)
+{
+  // releases the callback now, and invalidates TimerIds of it
+  timer->reset(TimerCallback(), Timestamp::invalid(), 0.0);
+  freeTimers_.push_back(timer);
+}
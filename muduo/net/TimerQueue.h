@@ -11,6 +11,7 @@
 #ifndef MUDUO_NET_TIMERQUEUE_H
 #define MUDUO_NET_TIMERQUEUE_H
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -27,11 +28,17 @@ namespace net
 class EventLoop;
 class Timer;
 class TimerId;
+class TimingWheel;
 
 ///
 /// A best efforts timer queue.
 /// No guarantee that the callback will be on time.
 ///
+///
+/// Timers of an EventLoop, sorted in a std::set by default,
+/// or in a TimingWheel if MUDUO_USE_TIMING_WHEEL is set,
+/// which is O(1) to add and cancel, at 1ms resolution.
+/// In the latter, Timer objects are recycled, not freed.
 class TimerQueue : noncopyable
 {
  public:
@@ -69,6 +76,13 @@ class TimerQueue : noncopyable
 
   bool insert(Timer* timer);
 
+  // TimingWheel mode
+  void addTimerToWheel(Timer* timer);
+  void cancelInWheel(TimerId timerId);
+  void handleWheel(Timestamp now);
+  void resetWheelTimerfd();
+  void recycle(Timer* timer);
+
   EventLoop* loop_;
   const int timerfd_;
   Channel timerfdChannel_;
@@ -79,6 +93,12 @@ class TimerQueue : noncopyable
   ActiveTimerSet activeTimers_;
   bool callingExpiredTimers_; /* atomic */
   ActiveTimerSet cancelingTimers_;
+
+  std::unique_ptr<TimingWheel> wheel_;  // NULL if sorted by std::set
+  Timestamp wheelWakeup_;  // when timerfd is set to
+  std::vector<Timer*> expiredTimers_;
+  // TimerId may refer to any of them, they're never freed before dtor.
+  std::vector<Timer*> freeTimers_;
 };
 
 }  // namespace net
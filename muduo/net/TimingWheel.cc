@@ -0,0 +1,263 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include "muduo/net/TimingWheel.h"
+
+#include "muduo/base/Types.h"
+#include "muduo/net/Timer.h"
+
+#include <algorithm>
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int64_t TimingWheel::kTickMicroSeconds;
+
+namespace
+{
+
+// distance from bit @c start to the next set bit, going around, -1 if none.
+int nextSetBit(uint64_t word, int start)
+{
+  if (word == 0)
+  {
+    return -1;
+  }
+  uint64_t rotated = start == 0 ? word : (word >> start) | (word << (64 - start));
+  return __builtin_ctzll(rotated);
+}
+
+}  // namespace
+
+TimingWheel::TimingWheel(Timestamp now)
+  : baseMicroSeconds_(now.microSecondsSinceEpoch()),
+    current_(0),
+    size_(0)
+{
+  memZero(buckets_, sizeof buckets_);
+  memZero(occupied_, sizeof occupied_);
+}
+
+bool TimingWheel::contains(const Timer* timer) const
+{
+  return timer->bucket_ >= 0;
+}
+
+int64_t TimingWheel::tickOf(Timestamp when) const
+{
+  int64_t us = when.microSecondsSinceEpoch() - baseMicroSeconds_;
+  // rounds up, never expires early
+  return us <= 0 ? 0 : (us + kTickMicroSeconds - 1) / kTickMicroSeconds;
+}
+
+void TimingWheel::add(Timer* timer)
+{
+  assert(!contains(timer));
+  int64_t tick = std::max(tickOf(timer->expiration()), current_);
+  int64_t delta = tick - current_;
+  if (delta < kLevel0Slots)
+  {
+    link(timer, bucketIndex(0, static_cast<int>(tick % kLevel0Slots)));
+    return;
+  }
+
+  if (delta >= (1LL << shift(kLevels)))
+  {
+    // parked, re-added with the real expiration when cascaded
+    delta = (1LL << shift(kLevels)) - 1;
+    tick = current_ + delta;
+  }
+  int level = 1;
+  while (delta >= (1LL << shift(level+1)))
+  {
+    ++level;
+  }
+  int slot = static_cast<int>((tick >> shift(level)) % kLevelSlots);
+  link(timer, bucketIndex(level, slot));
+}
+
+void TimingWheel::link(Timer* timer, int bucket)
+{
+  Bucket& b = buckets_[bucket];
+  timer->prev_ = b.tail;
+  timer->next_ = NULL;
+  if (b.tail)
+  {
+    b.tail->next_ = timer;
+  }
+  else
+  {
+    b.head = timer;
+  }
+  b.tail = timer;
+  timer->bucket_ = bucket;
+  occupied_[bucket / 64] |= 1ULL << (bucket % 64);
+  ++size_;
+}
+
+void TimingWheel::remove(Timer* timer)
+{
+  assert(contains(timer));
+  Bucket& b = buckets_[timer->bucket_];
+  if (timer->prev_)
+  {
+    timer->prev_->next_ = timer->next_;
+  }
+  else
+  {
+    b.head = timer->next_;
+  }
+  if (timer->next_)
+  {
+    timer->next_->prev_ = timer->prev_;
+  }
+  else
+  {
+    b.tail = timer->prev_;
+  }
+  if (b.head == NULL)
+  {
+    occupied_[timer->bucket_ / 64] &= ~(1ULL << (timer->bucket_ % 64));
+  }
+  timer->prev_ = NULL;
+  timer->next_ = NULL;
+  timer->bucket_ = -1;
+  --size_;
+}
+
+Timer* TimingWheel::takeBucket(int bucket)
+{
+  Bucket& b = buckets_[bucket];
+  Timer* head = b.head;
+  for (Timer* timer = head; timer; timer = timer->next_)
+  {
+    timer->bucket_ = -1;
+    --size_;
+  }
+  b.head = NULL;
+  b.tail = NULL;
+  occupied_[bucket / 64] &= ~(1ULL << (bucket % 64));
+  return head;
+}
+
+void TimingWheel::cascade()
+{
+  for (int level = 1; level < kLevels; ++level)
+  {
+    int slot = static_cast<int>((current_ >> shift(level)) % kLevelSlots);
+    Timer* timer = takeBucket(bucketIndex(level, slot));
+    while (timer)
+    {
+      Timer* next = timer->next_;
+      add(timer);
+      timer = next;
+    }
+    if (slot != 0)
+    {
+      break;
+    }
+  }
+}
+
+int TimingWheel::level0Distance(int slot) const
+{
+  int word = slot / 64;
+  uint64_t bits = occupied_[word] & (~0ULL << (slot % 64));
+  // the starting word is checked twice, for bits below slot at last
+  for (int i = 0; i <= kLevel0Slots / 64; ++i)
+  {
+    if (bits)
+    {
+      int found = word * 64 + __builtin_ctzll(bits);
+      return (found - slot + kLevel0Slots) % kLevel0Slots;
+    }
+    word = (word + 1) % (kLevel0Slots / 64);
+    bits = occupied_[word];
+  }
+  return -1;
+}
+
+void TimingWheel::advance(Timestamp now, std::vector<Timer*>* expired)
+{
+  const int64_t target =
+      (now.microSecondsSinceEpoch() - baseMicroSeconds_) / kTickMicroSeconds;
+  while (current_ <= target)
+  {
+    int slot = static_cast<int>(current_ % kLevel0Slots);
+    if (slot == 0)
+    {
+      cascade();
+    }
+    for (Timer* timer = takeBucket(bucketIndex(0, slot)); timer; )
+    {
+      Timer* next = timer->next_;
+      timer->prev_ = NULL;
+      timer->next_ = NULL;
+      expired->push_back(timer);
+      timer = next;
+    }
+    ++current_;
+
+    // skips empty slots, but not the next cascade
+    slot = static_cast<int>(current_ % kLevel0Slots);
+    if (slot != 0)
+    {
+      int distance = level0Distance(slot);
+      int64_t next = (distance >= 0 && slot + distance < kLevel0Slots)
+                     ? current_ + distance
+                     : current_ - slot + kLevel0Slots;
+      current_ = std::min(next, target + 1);
+    }
+  }
+}
+
+Timestamp TimingWheel::nextWakeup() const
+{
+  if (size_ == 0)
+  {
+    return Timestamp::invalid();
+  }
+  int64_t next = INT64_MAX;
+  int distance = level0Distance(static_cast<int>(current_ % kLevel0Slots));
+  if (distance >= 0)
+  {
+    next = current_ + distance;
+  }
+  for (int level = 1; level < kLevels; ++level)
+  {
+    uint64_t word = occupied_[bucketIndex(level, 0) / 64];
+    if (word == 0)
+    {
+      continue;
+    }
+    // slots of this level are cascaded at multiples of unit
+    const int64_t unit = 1LL << shift(level);
+    const int64_t boundary = (current_ + unit - 1) & ~(unit - 1);
+    int slot = static_cast<int>((boundary >> shift(level)) % kLevelSlots);
+    next = std::min(next, boundary + nextSetBit(word, slot) * unit);
+  }
+  assert(next != INT64_MAX);
+  return Timestamp(baseMicroSeconds_ + next * kTickMicroSeconds);
+}
+
+void TimingWheel::takeAll(std::vector<Timer*>* timers)
+{
+  for (int bucket = 0; bucket < kBuckets; ++bucket)
+  {
+    for (Timer* timer = takeBucket(bucket); timer; )
+    {
+      Timer* next = timer->next_;
+      timer->prev_ = NULL;
+      timer->next_ = NULL;
+      timers->push_back(timer);
+      timer = next;
+    }
+  }
+  assert(size_ == 0);
+}
@@ -0,0 +1,91 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMINGWHEEL_H
+#define MUDUO_NET_TIMINGWHEEL_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Timestamp.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Timer;
+
+///
+/// Hierarchical timing wheel of 1ms ticks, for TimerQueue.
+///
+/// Level 0 has 256 slots of one tick each, level 1 to 4 have 64 slots,
+/// each slot of level n spans the whole level n-1.  Timers are linked into
+/// slots intrusively, add() and remove() are O(1), advance() cascades
+/// timers of a higher level slot down when the lower level wraps around.
+/// Timers beyond 2^32 ticks (49 days) are parked in level 4 and re-added.
+///
+/// Timers never expire early, but may be late by one tick.
+/// It doesn't own the timers.
+class TimingWheel : noncopyable
+{
+ public:
+  static const int64_t kTickMicroSeconds = 1000;
+
+  explicit TimingWheel(Timestamp now);
+
+  void add(Timer* timer);
+  void remove(Timer* timer);
+  bool contains(const Timer* timer) const;
+  size_t size() const { return size_; }
+
+  /// Moves timers expired by @c now to @c expired.
+  void advance(Timestamp now, std::vector<Timer*>* expired);
+
+  /// When advance() has something to do next,
+  /// expiring timers or cascading, invalid if empty.
+  Timestamp nextWakeup() const;
+
+  /// Moves all timers to @c timers.
+  void takeAll(std::vector<Timer*>* timers);
+
+ private:
+  static const int kLevels = 5;
+  static const int kLevel0Slots = 256;
+  static const int kLevelSlots = 64;
+  static const int kBuckets = kLevel0Slots + (kLevels-1) * kLevelSlots;
+
+  struct Bucket
+  {
+    Timer* head;
+    Timer* tail;
+  };
+
+  static int shift(int level)
+  { return level == 0 ? 0 : 8 + 6 * (level-1); }
+
+  static int bucketIndex(int level, int slot)
+  { return level == 0 ? slot : kLevel0Slots + (level-1) * kLevelSlots + slot; }
+
+  int64_t tickOf(Timestamp when) const;
+  void link(Timer* timer, int bucket);
+  Timer* takeBucket(int bucket);
+  void cascade();
+  // distance to the next non-empty level 0 slot, -1 if none.
+  int level0Distance(int slot) const;
+
+  const int64_t baseMicroSeconds_;
+  int64_t current_;  // the next tick to process
+  size_t size_;
+  Bucket buckets_[kBuckets];
+  uint64_t occupied_[kBuckets / 64];  // bitmap of non-empty buckets
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_TIMINGWHEEL_H
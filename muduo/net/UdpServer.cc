@@ -0,0 +1,131 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/UdpServer.h"
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void resetAndCountDown(std::unique_ptr<UdpSocket>* socket, CountDownLatch* latch)
+{
+  socket->reset();
+  latch->countDown();
+}
+
+void copyStats(const UdpSocket* socket, UdpSocket::Stats* stats, CountDownLatch* latch)
+{
+  *stats = socket->stats();
+  latch->countDown();
+}
+
+}  // namespace
+
+UdpServer::UdpServer(EventLoop* loop,
+                     const InetAddress& listenAddr,
+                     const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    listenAddr_(listenAddr),
+    name_(nameArg),
+    threadPool_(new EventLoopThreadPool(loop, name_)),
+    batch_(UdpSocket::kDefaultBatch),
+    maxDatagramSize_(UdpSocket::kDefaultMaxDatagramSize),
+    gso_(false),
+    gro_(false)
+{
+}
+
+UdpServer::~UdpServer()
+{
+  loop_->assertInLoopThread();
+  LOG_TRACE << "UdpServer::~UdpServer [" << name_ << "] destructing";
+
+  for (auto& socket : sockets_)
+  {
+    // UdpSocket must be destructed in its loop
+    CountDownLatch latch(1);
+    socket->getLoop()->runInLoop(
+        std::bind(resetAndCountDown, &socket, &latch));
+    latch.wait();
+  }
+}
+
+void UdpServer::setThreadNum(int numThreads)
+{
+  assert(0 <= numThreads);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void UdpServer::start()
+{
+  if (started_.getAndSet(1) == 0)
+  {
+    threadPool_->start(threadInitCallback_);
+
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    const bool reusePort = loops.size() > 1;
+    for (EventLoop* ioLoop : loops)
+    {
+      std::unique_ptr<UdpSocket> socket(new UdpSocket(ioLoop, listenAddr_.family()));
+      if (!socket->bind(listenAddr_, reusePort))
+      {
+        LOG_FATAL << "UdpServer::start [" << name_ << "] - bind " << listenAddr_.toIpPort();
+      }
+      socket->setBatch(batch_);
+      socket->setMaxDatagramSize(maxDatagramSize_);
+      if (gso_)
+      {
+        socket->setSegmentOffload(true);
+      }
+      if (gro_)
+      {
+        socket->setReceiveOffload(true);
+      }
+      socket->setMessageCallback(messageCallback_);
+      ioLoop->runInLoop(
+          std::bind(&UdpSocket::startReading, get_pointer(socket)));
+      sockets_.push_back(std::move(socket));
+    }
+  }
+}
+
+UdpSocket::Stats UdpServer::stats() const
+{
+  // copied by the loop of each socket, which is the only writer
+  std::vector<UdpSocket::Stats> all(sockets_.size());
+  CountDownLatch latch(static_cast<int>(sockets_.size()));
+  for (size_t i = 0; i < sockets_.size(); ++i)
+  {
+    EventLoop* ioLoop = sockets_[i]->getLoop();
+    if (ioLoop->isInLoopThread())
+    {
+      copyStats(get_pointer(sockets_[i]), &all[i], &latch);
+    }
+    else
+    {
+      ioLoop->runInLoop(
+          std::bind(copyStats, get_pointer(sockets_[i]), &all[i], &latch));
+    }
+  }
+  latch.wait();
+
+  UdpSocket::Stats sum;
+  memZero(&sum, sizeof sum);
+  for (const UdpSocket::Stats& stats : all)
+  {
+    sum.received += stats.received;
+    sum.receiveCalls += stats.receiveCalls;
+    sum.truncated += stats.truncated;
+    sum.sent += stats.sent;
+    sum.sendCalls += stats.sendCalls;
+    sum.dropped += stats.dropped;
+  }
+  return sum;
+}
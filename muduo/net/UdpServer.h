@@ -0,0 +1,99 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSERVER_H
+#define MUDUO_NET_UDPSERVER_H
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/UdpSocket.h"
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoopThreadPool;
+
+///
+/// UDP server, one socket per I/O loop.
+///
+/// With threads, the sockets share the address by SO_REUSEPORT,
+/// and the kernel spreads datagrams by flow.
+/// Reply by UdpSocket::sendTo() on the socket of the message callback.
+class UdpServer : noncopyable
+{
+ public:
+  typedef std::function<void(EventLoop*)> ThreadInitCallback;
+
+  UdpServer(EventLoop* loop,
+            const InetAddress& listenAddr,
+            const string& nameArg);
+  /// Must be called in the loop thread, while the I/O loops still run.
+  /// Each socket is destroyed in its own loop, and this waits for it,
+  /// forever if one of them has quit.
+  ~UdpServer();  // force out-line dtor, for std::unique_ptr members.
+
+  const string& name() const { return name_; }
+  EventLoop* getLoop() const { return loop_; }
+
+  /// Must be called before @c start
+  /// @param numThreads
+  /// - 0 means one socket in loop's thread, the default.
+  /// - N means N sockets, each in its own thread.
+  void setThreadNum(int numThreads);
+  void setThreadInitCallback(const ThreadInitCallback& cb)
+  { threadInitCallback_ = cb; }
+
+  /// See UdpSocket::setBatch().
+  /// Must be called before @c start
+  void setBatch(int batch)
+  { batch_ = batch; }
+  /// See UdpSocket::setMaxDatagramSize().
+  /// Must be called before @c start
+  void setMaxDatagramSize(size_t size)
+  { maxDatagramSize_ = size; }
+  /// See UdpSocket::setSegmentOffload() and UdpSocket::setReceiveOffload().
+  /// Must be called before @c start
+  void setOffload(bool gso, bool gro)
+  {
+    gso_ = gso;
+    gro_ = gro;
+  }
+
+  /// Not thread safe.
+  void setMessageCallback(const UdpMessageCallback& cb)
+  { messageCallback_ = cb; }
+
+  /// Starts the server if it's not started.
+  ///
+  /// It's harmless to call it multiple times.
+  /// Thread safe.
+  void start();
+
+  /// Sums of all sockets, each copied in its own loop.
+  /// Blocks until every I/O loop has, so they must still run.
+  UdpSocket::Stats stats() const;
+
+ private:
+  EventLoop* loop_;
+  const InetAddress listenAddr_;
+  const string name_;
+  std::shared_ptr<EventLoopThreadPool> threadPool_;
+  // one per I/O loop, destroyed in their loops
+  std::vector<std::unique_ptr<UdpSocket>> sockets_;
+  UdpMessageCallback messageCallback_;
+  ThreadInitCallback threadInitCallback_;
+  int batch_;
+  size_t maxDatagramSize_;
+  bool gso_;
+  bool gro_;
+  AtomicInt32 started_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPSERVER_H
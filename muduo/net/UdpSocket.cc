@@ -0,0 +1,431 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/UdpSocket.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Channel.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/Socket.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int UdpSocket::kDefaultBatch;
+const size_t UdpSocket::kDefaultMaxDatagramSize;
+const size_t UdpSocket::kMaxGsoBytes;
+const int UdpSocket::kMaxGsoSegments;
+
+namespace
+{
+
+// a GRO datagram may be as large as an IP packet
+const size_t kGroSlotSize = 65535;
+// UDP_GRO and UDP_SEGMENT carry the segment size
+const size_t kControlSpace = CMSG_SPACE(sizeof(int));
+
+const int kEthernetMtu = 1500;
+
+// of an IP packet of mtu bytes
+size_t udpPayload(sa_family_t family, int mtu)
+{
+  const int headers = (family == AF_INET6 ? 40 : 20) + 8;
+  return mtu > headers ? static_cast<size_t>(mtu - headers) : 0;
+}
+
+bool sameAddress(const InetAddress& lhs, const InetAddress& rhs)
+{
+  return lhs.family() == rhs.family() &&
+      ::memcmp(lhs.getSockAddr(), rhs.getSockAddr(), lhs.getSockAddrLength()) == 0;
+}
+
+}  // namespace
+
+UdpSocket::UdpSocket(EventLoop* loop, sa_family_t family)
+  : loop_(CHECK_NOTNULL(loop)),
+    socket_(new Socket(sockets::createNonblockingUdpOrDie(family))),
+    channel_(new Channel(loop, socket_->fd())),
+    batch_(kDefaultBatch),
+    maxDatagramSize_(kDefaultMaxDatagramSize),
+    slotSize_(0),
+    gso_(false),
+    gro_(false),
+    gsoMaxSegment_(udpPayload(family, kEthernetMtu)),
+    flushQueued_(false),
+    self_(std::make_shared<UdpSocket*>(this))
+{
+  memZero(&stats_, sizeof stats_);
+  channel_->setReadCallback(
+      std::bind(&UdpSocket::handleRead, this, _1));
+}
+
+UdpSocket::~UdpSocket()
+{
+  flush();
+  channel_->disableAll();
+  channel_->remove();
+}
+
+int UdpSocket::fd() const
+{
+  return socket_->fd();
+}
+
+bool UdpSocket::bind(const InetAddress& localAddr, bool reusePort)
+{
+  if (reusePort)
+  {
+    socket_->setReusePort(true);
+  }
+  int ret = ::bind(socket_->fd(), localAddr.getSockAddr(), localAddr.getSockAddrLength());
+  if (ret < 0)
+  {
+    LOG_SYSERR << "UdpSocket::bind " << localAddr.toIpPort();
+  }
+  return ret == 0;
+}
+
+bool UdpSocket::connect(const InetAddress& peerAddr)
+{
+  int ret = ::connect(socket_->fd(), peerAddr.getSockAddr(), peerAddr.getSockAddrLength());
+  if (ret < 0)
+  {
+    LOG_SYSERR << "UdpSocket::connect " << peerAddr.toIpPort();
+    return false;
+  }
+  // known once connected, eg. 64KiB of loopback
+  const bool v6 = peerAddr.family() == AF_INET6;
+  int mtu = 0;
+  socklen_t len = static_cast<socklen_t>(sizeof mtu);
+  if (::getsockopt(socket_->fd(), v6 ? IPPROTO_IPV6 : IPPROTO_IP, v6 ? IPV6_MTU : IP_MTU,
+                   &mtu, &len) == 0)
+  {
+    gsoMaxSegment_ = udpPayload(peerAddr.family(), mtu);
+  }
+  return true;
+}
+
+void UdpSocket::setBatch(int batch)
+{
+  assert(batch > 0);
+  assert(!channel_->isReading());
+  flush();
+  batch_ = batch;
+}
+
+void UdpSocket::setMaxDatagramSize(size_t size)
+{
+  assert(!channel_->isReading());
+  maxDatagramSize_ = size;
+}
+
+bool UdpSocket::setSegmentOffload(bool on)
+{
+#ifdef UDP_SEGMENT
+  if (on)
+  {
+    // probes the kernel, sending still sets the segment size per message
+    int segment = 0;
+    socklen_t len = static_cast<socklen_t>(sizeof segment);
+    if (::getsockopt(socket_->fd(), SOL_UDP, UDP_SEGMENT, &segment, &len) < 0)
+    {
+      LOG_SYSERR << "UDP_SEGMENT is not supported.";
+      return false;
+    }
+  }
+  flush();
+  gso_ = on;
+  return true;
+#else
+  if (on)
+  {
+    LOG_ERROR << "UDP_SEGMENT is not supported.";
+  }
+  return !on;
+#endif
+}
+
+bool UdpSocket::setReceiveOffload(bool on)
+{
+  assert(!channel_->isReading());
+#ifdef UDP_GRO
+  int optval = on ? 1 : 0;
+  int ret = ::setsockopt(socket_->fd(), SOL_UDP, UDP_GRO,
+                         &optval, static_cast<socklen_t>(sizeof optval));
+  if (ret < 0)
+  {
+    LOG_SYSERR << "UDP_GRO failed.";
+    return false;
+  }
+  gro_ = on;
+  return true;
+#else
+  if (on)
+  {
+    LOG_ERROR << "UDP_GRO is not supported.";
+  }
+  return !on;
+#endif
+}
+
+void UdpSocket::startReading()
+{
+  loop_->assertInLoopThread();
+  if (!channel_->isReading())
+  {
+    allocateReceiveSlab();
+    channel_->enableReading();
+  }
+}
+
+void UdpSocket::stopReading()
+{
+  loop_->assertInLoopThread();
+  if (channel_->isReading())
+  {
+    channel_->disableReading();
+  }
+}
+
+void UdpSocket::allocateReceiveSlab()
+{
+  slotSize_ = gro_ ? std::max(kGroSlotSize, maxDatagramSize_) : maxDatagramSize_;
+  const size_t batch = static_cast<size_t>(batch_);
+  receiveSlab_.resize(batch * slotSize_);
+  receiveHeaders_.resize(batch);
+  receiveIovecs_.resize(batch);
+  receiveAddrs_.resize(batch);
+  receiveControl_.resize(gro_ ? batch * kControlSpace : 0);
+  datagrams_.reserve(batch);
+  for (size_t i = 0; i < batch; ++i)
+  {
+    receiveIovecs_[i].iov_base = &receiveSlab_[i * slotSize_];
+    receiveIovecs_[i].iov_len = slotSize_;
+    struct msghdr& hdr = receiveHeaders_[i].msg_hdr;
+    memZero(&hdr, sizeof hdr);
+    hdr.msg_name = &receiveAddrs_[i];
+    hdr.msg_iov = &receiveIovecs_[i];
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = gro_ ? &receiveControl_[i * kControlSpace] : NULL;
+  }
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime)
+{
+  loop_->assertInLoopThread();
+  for (struct mmsghdr& msg : receiveHeaders_)
+  {
+    // both are value-result
+    msg.msg_hdr.msg_namelen = static_cast<socklen_t>(sizeof(struct sockaddr_in6));
+    msg.msg_hdr.msg_controllen = gro_ ? kControlSpace : 0;
+  }
+  int n = ::recvmmsg(socket_->fd(), receiveHeaders_.data(),
+                     static_cast<unsigned>(batch_), MSG_DONTWAIT, NULL);
+  if (n < 0)
+  {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+      LOG_SYSERR << "UdpSocket::handleRead";
+    }
+    return;
+  }
+  ++stats_.receiveCalls;
+
+  datagrams_.clear();
+  for (int i = 0; i < n; ++i)
+  {
+    const struct mmsghdr& msg = receiveHeaders_[i];
+    if (msg.msg_hdr.msg_flags & MSG_TRUNC)
+    {
+      ++stats_.truncated;
+    }
+    const char* data = &receiveSlab_[i * slotSize_];
+    const size_t len = std::min(static_cast<size_t>(msg.msg_len), slotSize_);
+    size_t segment = len;
+#ifdef UDP_GRO
+    if (gro_)
+    {
+      struct msghdr* hdr = const_cast<struct msghdr*>(&msg.msg_hdr);
+      for (struct cmsghdr* cm = CMSG_FIRSTHDR(hdr); cm != NULL; cm = CMSG_NXTHDR(hdr, cm))
+      {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+        {
+          int gso = 0;
+          ::memcpy(&gso, CMSG_DATA(cm), sizeof gso);
+          if (gso > 0)
+          {
+            segment = static_cast<size_t>(gso);
+          }
+        }
+      }
+    }
+#endif
+    const InetAddress peer(receiveAddrs_[i]);
+    size_t offset = 0;
+    do
+    {
+      const size_t size = std::min(segment, len - offset);
+      UdpDatagram datagram = { data + offset, size, peer };
+      datagrams_.push_back(datagram);
+      offset += size;
+    } while (offset < len);
+  }
+  stats_.received += static_cast<int64_t>(datagrams_.size());
+
+  if (messageCallback_)
+  {
+    messageCallback_(this, datagrams_, receiveTime);
+  }
+}
+
+void UdpSocket::sendTo(const void* data, size_t len, const InetAddress& peerAddr)
+{
+  append(data, len, &peerAddr);
+}
+
+void UdpSocket::send(const void* data, size_t len)
+{
+  append(data, len, NULL);
+}
+
+void UdpSocket::append(const void* data, size_t len, const InetAddress* peerAddr)
+{
+  loop_->assertInLoopThread();
+  Pending* last = pending_.empty() ? NULL : &pending_.back();
+  if (gso_ && last && len > 0
+      && last->segmentSize <= gsoMaxSegment_  // or EINVAL for the whole run
+      && last->hasPeer == (peerAddr != NULL)
+      && (peerAddr == NULL || sameAddress(last->peer, *peerAddr))
+      && last->segments < kMaxGsoSegments
+      && len <= last->segmentSize
+      && last->length == last->segmentSize * static_cast<size_t>(last->segments)  // no short tail yet
+      && last->length + len <= kMaxGsoBytes)
+  {
+    // coalesced, the kernel splits it every segmentSize bytes
+    last->length += len;
+    ++last->segments;
+  }
+  else
+  {
+    if (pending_.size() >= static_cast<size_t>(batch_))
+    {
+      flush();
+    }
+    Pending pending;
+    pending.offset = sendBuffer_.size();
+    pending.length = len;
+    pending.segmentSize = len;
+    pending.segments = 1;
+    pending.hasPeer = peerAddr != NULL;
+    if (peerAddr)
+    {
+      pending.peer = *peerAddr;
+    }
+    pending_.push_back(pending);
+  }
+  const char* p = static_cast<const char*>(data);
+  sendBuffer_.insert(sendBuffer_.end(), p, p + len);
+
+  if (!flushQueued_)
+  {
+    flushQueued_ = true;
+    loop_->queueInLoop(std::bind(&UdpSocket::queuedFlush, std::weak_ptr<UdpSocket*>(self_)));
+  }
+}
+
+void UdpSocket::queuedFlush(const std::weak_ptr<UdpSocket*>& weakSelf)
+{
+  std::shared_ptr<UdpSocket*> self(weakSelf.lock());
+  if (self)
+  {
+    (*self)->flushQueued_ = false;
+    (*self)->flush();
+  }
+}
+
+void UdpSocket::flush()
+{
+  if (pending_.empty())
+  {
+    return;
+  }
+  loop_->assertInLoopThread();
+
+  const size_t n = pending_.size();
+  sendHeaders_.resize(n);
+  sendIovecs_.resize(n);
+  sendControl_.resize(n * kControlSpace);
+  for (size_t i = 0; i < n; ++i)
+  {
+    Pending& pending = pending_[i];
+    sendIovecs_[i].iov_base = sendBuffer_.data() + pending.offset;
+    sendIovecs_[i].iov_len = pending.length;
+    struct msghdr& hdr = sendHeaders_[i].msg_hdr;
+    memZero(&hdr, sizeof hdr);
+    hdr.msg_iov = &sendIovecs_[i];
+    hdr.msg_iovlen = 1;
+    if (pending.hasPeer)
+    {
+      hdr.msg_name = const_cast<struct sockaddr*>(pending.peer.getSockAddr());
+      hdr.msg_namelen = pending.peer.getSockAddrLength();
+    }
+#ifdef UDP_SEGMENT
+    if (pending.segments > 1)
+    {
+      hdr.msg_control = &sendControl_[i * kControlSpace];
+      hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+      struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr);
+      cm->cmsg_level = SOL_UDP;
+      cm->cmsg_type = UDP_SEGMENT;
+      cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      uint16_t segmentSize = static_cast<uint16_t>(pending.segmentSize);
+      ::memcpy(CMSG_DATA(cm), &segmentSize, sizeof segmentSize);
+    }
+#endif
+  }
+
+  size_t sent = 0;
+  while (sent < n)
+  {
+    int ret = ::sendmmsg(socket_->fd(), &sendHeaders_[sent],
+                         static_cast<unsigned>(n - sent), MSG_DONTWAIT);
+    ++stats_.sendCalls;
+    if (ret > 0)
+    {
+      for (size_t i = sent; i < sent + static_cast<size_t>(ret); ++i)
+      {
+        stats_.sent += pending_[i].segments;
+      }
+      sent += static_cast<size_t>(ret);
+    }
+    else if (errno == EINTR)
+    {
+      continue;
+    }
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+      // socket buffer is full, drops the rest like a congested network
+      for (; sent < n; ++sent)
+      {
+        stats_.dropped += pending_[sent].segments;
+      }
+    }
+    else
+    {
+      // eg. ECONNREFUSED from a previous datagram, skips the first one
+      LOG_SYSERR << "UdpSocket::flush";
+      stats_.dropped += pending_[sent].segments;
+      ++sent;
+    }
+  }
+  pending_.clear();
+  sendBuffer_.clear();
+}
@@ -0,0 +1,175 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSOCKET_H
+#define MUDUO_NET_UDPSOCKET_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/InetAddress.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Channel;
+class EventLoop;
+class Socket;
+class UdpSocket;
+
+///
+/// A received datagram, points into the receive slab of UdpSocket,
+/// valid until the message callback returns.
+///
+struct UdpDatagram
+{
+  const char* data;
+  size_t size;
+  InetAddress peer;
+};
+
+typedef std::function<void (UdpSocket*,
+                            const std::vector<UdpDatagram>&,
+                            Timestamp)> UdpMessageCallback;
+
+///
+/// Non-blocking UDP socket in an EventLoop.
+///
+/// Receives up to batch() datagrams per recvmmsg(2) into a preallocated slab,
+/// sends datagrams queued in one loop iteration by sendmmsg(2).
+/// All member functions must be called in the loop thread,
+/// except the constructor.
+class UdpSocket : noncopyable
+{
+ public:
+  static const int kDefaultBatch = 64;
+  static const size_t kDefaultMaxDatagramSize = 2048;
+  // IP_MAXPACKET of a UDP/IPv4 payload
+  static const size_t kMaxGsoBytes = 65507;
+  // UDP_MAX_SEGMENTS of the kernel
+  static const int kMaxGsoSegments = 64;
+
+  struct Stats
+  {
+    int64_t received;      // datagrams
+    int64_t receiveCalls;  // recvmmsg(2)
+    int64_t truncated;     // larger than maxDatagramSize()
+    int64_t sent;          // datagrams
+    int64_t sendCalls;     // sendmmsg(2)
+    int64_t dropped;       // socket buffer full, or errors
+  };
+
+  explicit UdpSocket(EventLoop* loop, sa_family_t family = AF_INET);
+  ~UdpSocket();  // force out-line dtor, for std::unique_ptr members.
+
+  EventLoop* getLoop() const { return loop_; }
+  int fd() const;
+
+  /// With SO_REUSEPORT, sockets of one address share datagrams by flow.
+  /// @return false if failed.
+  bool bind(const InetAddress& localAddr, bool reusePort = false);
+  /// Receives from, and sends by default to @c peerAddr only.
+  bool connect(const InetAddress& peerAddr);
+
+  /// Datagrams per recvmmsg(2) and sendmmsg(2).
+  /// Must be called before startReading().
+  void setBatch(int batch);
+  int batch() const { return batch_; }
+  /// Larger ones are truncated and counted.
+  /// Must be called before startReading().
+  void setMaxDatagramSize(size_t size);
+  size_t maxDatagramSize() const { return maxDatagramSize_; }
+
+  ///
+  /// Generic Segmentation Offload, datagrams of equal size to the same peer
+  /// leave as one UDP_SEGMENT send, split by the kernel or the NIC.
+  /// Only those which fit in the path MTU, of the connected peer,
+  /// or of Ethernet if not connected, larger ones are sent alone.
+  /// @return false if not supported.
+  bool setSegmentOffload(bool on);
+  ///
+  /// Generic Receive Offload, the kernel coalesces datagrams of a flow,
+  /// which are split again before the message callback.
+  /// Each slot of the receive slab grows to 64KiB.
+  /// Must be called before startReading().
+  /// @return false if not supported.
+  bool setReceiveOffload(bool on);
+
+  void setMessageCallback(const UdpMessageCallback& cb)
+  { messageCallback_ = cb; }
+
+  void startReading();
+  void stopReading();
+
+  ///
+  /// Queues a datagram, sent at the end of this loop iteration,
+  /// or when batch() datagrams are queued, or by flush().
+  /// Dropped and counted if the socket buffer is full, as UDP does.
+  void sendTo(const void* data, size_t len, const InetAddress& peerAddr);
+  /// To the connected peer.
+  void send(const void* data, size_t len);
+  /// Sends queued datagrams now.
+  void flush();
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Pending
+  {
+    size_t offset;       // in sendBuffer_
+    size_t length;
+    size_t segmentSize;  // of each datagram
+    int segments;        // > 1 if coalesced for GSO
+    bool hasPeer;
+    InetAddress peer;
+  };
+
+  void handleRead(Timestamp receiveTime);
+  static void queuedFlush(const std::weak_ptr<UdpSocket*>& weakSelf);
+  void append(const void* data, size_t len, const InetAddress* peerAddr);
+  void allocateReceiveSlab();
+
+  EventLoop* loop_;
+  std::unique_ptr<Socket> socket_;
+  std::unique_ptr<Channel> channel_;
+  UdpMessageCallback messageCallback_;
+  int batch_;
+  size_t maxDatagramSize_;
+  size_t slotSize_;
+  bool gso_;
+  bool gro_;
+  size_t gsoMaxSegment_;  // UDP payload of the path MTU
+  bool flushQueued_;
+  Stats stats_;
+  // queued flushes hold it weakly, in case this is gone
+  std::shared_ptr<UdpSocket*> self_;
+
+  // receive slab, batch_ slots of slotSize_
+  std::vector<char> receiveSlab_;
+  std::vector<struct mmsghdr> receiveHeaders_;
+  std::vector<struct iovec> receiveIovecs_;
+  std::vector<struct sockaddr_in6> receiveAddrs_;
+  std::vector<char> receiveControl_;
+  std::vector<UdpDatagram> datagrams_;
+
+  std::vector<char> sendBuffer_;
+  std::vector<Pending> pending_;
+  std::vector<struct mmsghdr> sendHeaders_;
+  std::vector<struct iovec> sendIovecs_;
+  std::vector<char> sendControl_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPSOCKET_H
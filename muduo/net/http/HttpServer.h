@@ -49,6 +49,12 @@ class HttpServer : noncopyable
     server_.setThreadNum(numThreads);
   }
 
+  /// see TcpServer::setCpuSteering()
+  void setCpuSteering(bool on)
+  {
+    server_.setCpuSteering(on);
+  }
+
   void start();
 
  private:
@@ -7,6 +7,8 @@
 #include <iostream>
 #include <map>
 
+#include <string.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -62,16 +64,25 @@ void onRequest(const HttpRequest& req, HttpResponse* resp)
 int main(int argc, char* argv[])
 {
   int numThreads = 0;
+  TcpServer::Option option = TcpServer::kNoReusePort;
+  bool steering = false;
   if (argc > 1)
   {
     benchmark = true;
     Logger::setLogLevel(Logger::WARN);
     numThreads = atoi(argv[1]);
   }
+  if (argc > 2)
+  {
+    // "perloop" accepts in every I/O thread, "steer" also steers by CPU
+    option = TcpServer::kReusePortPerLoop;
+    steering = strcmp(argv[2], "steer") == 0;
+  }
   EventLoop loop;
-  HttpServer server(&loop, InetAddress(8000), "dummy");
+  HttpServer server(&loop, InetAddress(8000), "dummy", option);
   server.setHttpCallback(onRequest);
   server.setThreadNum(numThreads);
+  server.setCpuSteering(steering);
   server.start();
   loop.loop();
 }
@@ -0,0 +1,255 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/net/inspect/ConnectionInspector.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpServer.h"
+#include "muduo/net/inspect/LoopFanOut.h"
+
+#include <algorithm>
+#include <map>
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+namespace muduo
+{
+namespace inspect
+{
+int stringPrintf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+}
+}
+
+using namespace muduo;
+using namespace muduo::net;
+using namespace muduo::inspect;
+
+namespace
+{
+
+typedef ConnectionInspector::Entry Entry;
+
+const int kDefaultTop = 10;
+
+// of one loop, entries are named by server beforehand
+struct LoopConnections
+{
+  std::vector<TcpConnectionPtr> conns;
+  std::vector<Entry> entries;
+};
+
+void collectInLoop(const std::shared_ptr<std::vector<LoopConnections>>& loops, size_t i)
+{
+  LoopConnections* loopConns = &(*loops)[i];
+  for (size_t j = 0; j < loopConns->conns.size(); ++j)
+  {
+    const TcpConnectionPtr& conn = loopConns->conns[j];
+    Entry& entry = loopConns->entries[j];
+    entry.name = conn->name();
+    entry.peer = conn->peerAddress().toIpPort();
+    entry.stats = conn->stats();
+    entry.inputBytes = conn->inputBuffer()->readableBytes();
+    entry.outputBytes = conn->outputBytes();
+    entry.readPaused = conn->isReadPaused();
+  }
+  // the last references are dropped in their own loop
+  loopConns->conns.clear();
+}
+
+bool moreBytes(const Entry& lhs, const Entry& rhs)
+{
+  return lhs.stats.bytesReceived + lhs.stats.bytesSent
+      > rhs.stats.bytesReceived + rhs.stats.bytesSent;
+}
+
+bool deeperQueue(const Entry& lhs, const Entry& rhs)
+{
+  if (lhs.outputBytes != rhs.outputBytes)
+  {
+    return lhs.outputBytes > rhs.outputBytes;
+  }
+  return lhs.stats.maxOutputBytes > rhs.stats.maxOutputBytes;
+}
+
+bool longerCallback(const Entry& lhs, const Entry& rhs)
+{
+  return lhs.stats.callbackMicroSeconds > rhs.stats.callbackMicroSeconds;
+}
+
+}  // namespace
+
+void ConnectionInspector::registerCommands(Inspector* ins)
+{
+  ins->add("net", "overview",
+           std::bind(&ConnectionInspector::overview, this, _1, _2),
+           "print connections and traffic of servers");
+  ins->add("net", "top",
+           std::bind(&ConnectionInspector::top, this, _1, _2),
+           "top N connections, /net/top/[bytes|queue|callback]/N");
+}
+
+void ConnectionInspector::addServer(TcpServer* server)
+{
+  MutexLockGuard lock(mutex_);
+  servers_.push_back(server);
+}
+
+void ConnectionInspector::removeServer(TcpServer* server)
+{
+  MutexLockGuard lock(mutex_);
+  servers_.erase(std::remove(servers_.begin(), servers_.end(), server),
+                 servers_.end());
+}
+
+std::vector<Entry> ConnectionInspector::collect()
+{
+  std::vector<EventLoop*> loops;
+  std::shared_ptr<std::vector<LoopConnections>> loopConns(
+      std::make_shared<std::vector<LoopConnections>>());
+  {
+    std::map<EventLoop*, size_t> indexes;
+    MutexLockGuard lock(mutex_);
+    for (TcpServer* server : servers_)
+    {
+      for (const TcpConnectionPtr& conn : server->connections())
+      {
+        std::map<EventLoop*, size_t>::iterator it = indexes.find(conn->getLoop());
+        if (it == indexes.end())
+        {
+          it = indexes.insert(std::make_pair(conn->getLoop(), loops.size())).first;
+          loops.push_back(conn->getLoop());
+          loopConns->push_back(LoopConnections());
+        }
+        LoopConnections& of = (*loopConns)[it->second];
+        of.conns.push_back(conn);
+        of.entries.push_back(Entry());
+        of.entries.back().server = server->name();
+      }
+    }
+  }
+
+  // stats are plain values, read them in each loop, all loops at once,
+  // without the ones which don't answer in time
+  std::vector<bool> finished = runInLoops(loops, std::bind(collectInLoop, loopConns, _1));
+
+  std::vector<Entry> result;
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    if (finished[i])
+    {
+      const std::vector<Entry>& entries = (*loopConns)[i].entries;
+      result.insert(result.end(), entries.begin(), entries.end());
+    }
+  }
+  return result;
+}
+
+string ConnectionInspector::overview(HttpRequest::Method, const Inspector::ArgList&)
+{
+  struct Total
+  {
+    int connections;
+    int readPaused;
+    int64_t bytesReceived;
+    int64_t bytesSent;
+    int64_t readCalls;
+    int64_t writeCalls;
+    int64_t callbackMicroSeconds;
+    size_t outputBytes;
+  };
+  std::map<string, Total> totals;
+  {
+    MutexLockGuard lock(mutex_);
+    for (TcpServer* server : servers_)
+    {
+      totals[server->name()] = Total();
+    }
+  }
+  for (const Entry& entry : collect())
+  {
+    Total& total = totals[entry.server];
+    ++total.connections;
+    total.readPaused += entry.readPaused ? 1 : 0;
+    total.bytesReceived += entry.stats.bytesReceived;
+    total.bytesSent += entry.stats.bytesSent;
+    total.readCalls += entry.stats.readCalls;
+    total.writeCalls += entry.stats.writeCalls;
+    total.callbackMicroSeconds += entry.stats.callbackMicroSeconds;
+    total.outputBytes += entry.outputBytes;
+  }
+
+  string result;
+  for (const auto& it : totals)
+  {
+    const Total& total = it.second;
+    stringPrintf(&result, "%s: %d connections, %d read paused, %zu bytes queued\n",
+                 it.first.c_str(), total.connections, total.readPaused, total.outputBytes);
+    stringPrintf(&result, "  in %" PRId64 " bytes by %" PRId64 " reads,"
+                 " out %" PRId64 " bytes by %" PRId64 " writes,"
+                 " %.3f s in MessageCallback\n",
+                 total.bytesReceived, total.readCalls,
+                 total.bytesSent, total.writeCalls,
+                 static_cast<double>(total.callbackMicroSeconds) / Timestamp::kMicroSecondsPerSecond);
+  }
+  return result;
+}
+
+string ConnectionInspector::top(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  const string order = args.empty() ? "bytes" : args[0];
+  bool (*comp)(const Entry&, const Entry&) = NULL;
+  if (order == "bytes")
+  {
+    comp = moreBytes;
+  }
+  else if (order == "queue")
+  {
+    comp = deeperQueue;
+  }
+  else if (order == "callback")
+  {
+    comp = longerCallback;
+  }
+  else
+  {
+    return "unknown order " + order + ", try bytes, queue or callback\n";
+  }
+  int n = args.size() > 1 ? atoi(args[1].c_str()) : kDefaultTop;
+  if (n <= 0)
+  {
+    n = kDefaultTop;
+  }
+
+  std::vector<Entry> entries = collect();
+  const size_t shown = std::min(entries.size(), static_cast<size_t>(n));
+  std::partial_sort(entries.begin(), entries.begin() + shown, entries.end(), comp);
+
+  string result;
+  stringPrintf(&result, "top %zu of %zu connections by %s\n",
+               shown, entries.size(), order.c_str());
+  stringPrintf(&result, "%12s%12s %8s %8s %8s %11s %10s %6s %10s %6s  %s\n",
+               "BYTES IN", "BYTES OUT", "READS", "WRITES", "QUEUED", "MAX QUEUED",
+               "CALLBACKS", "CB US", "MAX CB US", "AGE S", "NAME (PEER)");
+  const Timestamp now(Timestamp::now());
+  for (size_t i = 0; i < shown; ++i)
+  {
+    const Entry& entry = entries[i];
+    const TcpConnection::Stats& stats = entry.stats;
+    stringPrintf(&result, "%12" PRId64 "%12" PRId64 " %8" PRId64 " %8" PRId64
+                 " %8zu %11zu %10" PRId64 " %6" PRId64 " %10" PRId64 " %6.0f  %s (%s)%s\n",
+                 stats.bytesReceived, stats.bytesSent,
+                 stats.readCalls, stats.writeCalls,
+                 entry.outputBytes, stats.maxOutputBytes,
+                 stats.messageCallbacks, stats.callbackMicroSeconds,
+                 stats.maxCallbackMicroSeconds,
+                 timeDifference(now, stats.creationTime),
+                 entry.name.c_str(), entry.peer.c_str(),
+                 entry.readPaused ? " paused" : "");
+  }
+  return result;
+}
@@ -0,0 +1,52 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_CONNECTIONINSPECTOR_H
+#define MUDUO_NET_INSPECT_CONNECTIONINSPECTOR_H
+
+#include "muduo/net/inspect/Inspector.h"
+#include "muduo/net/TcpConnection.h"
+
+namespace muduo
+{
+namespace net
+{
+
+class TcpServer;
+
+/// Stats of connections of the servers added to the Inspector,
+/// gathered in their own loops on each request.
+class ConnectionInspector : noncopyable
+{
+ public:
+  struct Entry
+  {
+    string server;
+    string name;
+    string peer;
+    TcpConnection::Stats stats;
+    size_t inputBytes;
+    size_t outputBytes;
+    bool readPaused;
+  };
+
+  void registerCommands(Inspector* ins);
+  void addServer(TcpServer* server);
+  void removeServer(TcpServer* server);
+
+  string overview(HttpRequest::Method, const Inspector::ArgList&);
+  string top(HttpRequest::Method, const Inspector::ArgList&);
+
+ private:
+  std::vector<Entry> collect();
+
+  MutexLock mutex_;
+  std::vector<TcpServer*> servers_ GUARDED_BY(mutex_);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_CONNECTIONINSPECTOR_H
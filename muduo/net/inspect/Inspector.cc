@@ -14,6 +14,8 @@
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/http/HttpRequest.h"
 #include "muduo/net/http/HttpResponse.h"
+#include "muduo/net/inspect/ConnectionInspector.h"
+#include "muduo/net/inspect/LoopInspector.h"
 #include "muduo/net/inspect/ProcessInspector.h"
 #include "muduo/net/inspect/PerformanceInspector.h"
 #include "muduo/net/inspect/SystemInspector.h"
@@ -64,7 +66,9 @@ Inspector::Inspector(EventLoop* loop,
                      const string& name)
     : server_(loop, httpAddr, "Inspector:"+name),
       processInspector_(new ProcessInspector),
-      systemInspector_(new SystemInspector)
+      systemInspector_(new SystemInspector),
+      connectionInspector_(new ConnectionInspector),
+      loopInspector_(new LoopInspector)
 {
   assert(CurrentThread::isMainThread());
   assert(g_globalInspector == 0);
@@ -72,6 +76,8 @@ Inspector::Inspector(EventLoop* loop,
   server_.setHttpCallback(std::bind(&Inspector::onRequest, this, _1, _2));
   processInspector_->registerCommands(this);
   systemInspector_->registerCommands(this);
+  connectionInspector_->registerCommands(this);
+  loopInspector_->registerCommands(this);
 #ifdef HAVE_TCMALLOC
   performanceInspector_.reset(new PerformanceInspector);
   performanceInspector_->registerCommands(this);
@@ -106,6 +112,26 @@ void Inspector::remove(const string& module, const string& command)
   }
 }
 
+void Inspector::addServer(TcpServer* server)
+{
+  connectionInspector_->addServer(server);
+}
+
+void Inspector::removeServer(TcpServer* server)
+{
+  connectionInspector_->removeServer(server);
+}
+
+void Inspector::addLoop(EventLoop* loop, const string& name)
+{
+  loopInspector_->addLoop(loop, name);
+}
+
+void Inspector::removeLoop(EventLoop* loop)
+{
+  loopInspector_->removeLoop(loop);
+}
+
 void Inspector::start()
 {
   server_.start();
@@ -22,9 +22,12 @@ namespace muduo
 namespace net
 {
 
+class ConnectionInspector;
+class LoopInspector;
 class ProcessInspector;
 class PerformanceInspector;
 class SystemInspector;
+class TcpServer;
 
 // An internal inspector of the running process, usually a singleton.
 // Better to run in a seperated thread, as some method may block for seconds
@@ -45,6 +48,21 @@ class Inspector : noncopyable
            const string& help);
   void remove(const string& module, const string& command);
 
+  /// Lists connections of @c server in /net/ pages.
+  /// Thread safe.
+  void addServer(TcpServer* server);
+  /// Must be called before destroying an added server.
+  /// Thread safe.
+  void removeServer(TcpServer* server);
+
+  /// Shows EventLoop::healthStats() of @c loop in /loop/ pages,
+  /// enable them in @c loop first.
+  /// Thread safe.
+  void addLoop(EventLoop* loop, const string& name);
+  /// Must be called before destroying an added loop.
+  /// Thread safe.
+  void removeLoop(EventLoop* loop);
+
  private:
   typedef std::map<string, Callback> CommandList;
   typedef std::map<string, string> HelpList;
@@ -56,6 +74,8 @@ class Inspector : noncopyable
   std::unique_ptr<ProcessInspector> processInspector_;
   std::unique_ptr<PerformanceInspector> performanceInspector_;
   std::unique_ptr<SystemInspector> systemInspector_;
+  std::unique_ptr<ConnectionInspector> connectionInspector_;
+  std::unique_ptr<LoopInspector> loopInspector_;
   MutexLock mutex_;
   std::map<string, CommandList> modules_ GUARDED_BY(mutex_);
   std::map<string, HelpList> helps_ GUARDED_BY(mutex_);
@@ -0,0 +1,78 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/inspect/LoopFanOut.h"
+
+#include "muduo/base/Condition.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+
+#include <memory>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// outlives the caller if a loop is late
+struct FanOut
+{
+  explicit FanOut(size_t n)
+    : cond(mutex), remaining(n), finished(n, false)
+  {
+  }
+
+  MutexLock mutex;
+  Condition cond;
+  size_t remaining GUARDED_BY(mutex);
+  std::vector<bool> finished GUARDED_BY(mutex);
+};
+
+void runAndSignal(const std::function<void (size_t)>& func, size_t i,
+                  const std::shared_ptr<FanOut>& fanOut)
+{
+  func(i);
+  MutexLockGuard lock(fanOut->mutex);
+  fanOut->finished[i] = true;
+  if (--fanOut->remaining == 0)
+  {
+    fanOut->cond.notify();
+  }
+}
+
+}  // namespace
+
+std::vector<bool> muduo::net::runInLoops(const std::vector<EventLoop*>& loops,
+                                         const std::function<void (size_t)>& func,
+                                         double timeoutSeconds)
+{
+  std::shared_ptr<FanOut> fanOut(std::make_shared<FanOut>(loops.size()));
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    // never waits for its own loop
+    if (loops[i]->isInLoopThread())
+    {
+      runAndSignal(func, i, fanOut);
+    }
+    else
+    {
+      loops[i]->queueInLoop(std::bind(runAndSignal, func, i, fanOut));
+    }
+  }
+
+  const Timestamp deadline(addTime(Timestamp::now(), timeoutSeconds));
+  MutexLockGuard lock(fanOut->mutex);
+  while (fanOut->remaining > 0)
+  {
+    const double left = timeDifference(deadline, Timestamp::now());
+    if (left <= 0)
+    {
+      LOG_WARN << "runInLoops - " << fanOut->remaining << " of " << loops.size()
+               << " loops did not answer in " << timeoutSeconds << " seconds";
+      break;
+    }
+    fanOut->cond.waitForSeconds(left);
+  }
+  return fanOut->finished;
+}
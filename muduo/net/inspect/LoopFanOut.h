@@ -0,0 +1,35 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_LOOPFANOUT_H
+#define MUDUO_NET_INSPECT_LOOPFANOUT_H
+
+#include <functional>
+#include <vector>
+
+#include <stddef.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Runs func(i) in loops[i], all loops at once, and waits for them
+/// at most @c timeoutSeconds, so that a loop which has quit, or is stuck,
+/// does not hang the caller.
+/// @return whether func(i) has finished, by loop.
+/// A late func(i) still runs, so it must hold what it writes by shared_ptr,
+/// and the caller must only read what the finished ones wrote.
+std::vector<bool> runInLoops(const std::vector<EventLoop*>& loops,
+                             const std::function<void (size_t)>& func,
+                             double timeoutSeconds = 1.0);
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_LOOPFANOUT_H
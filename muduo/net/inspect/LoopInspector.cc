@@ -0,0 +1,158 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/net/inspect/LoopInspector.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/inspect/LoopFanOut.h"
+
+#include <algorithm>
+
+#include <inttypes.h>
+
+namespace muduo
+{
+namespace inspect
+{
+int stringPrintf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+}
+}
+
+using namespace muduo;
+using namespace muduo::net;
+using namespace muduo::inspect;
+
+namespace
+{
+
+struct Snapshot
+{
+  bool enabled;
+  int64_t iteration;
+  size_t queueSize;
+  int numConnections;
+  EventLoop::HealthStats stats;
+};
+
+void snapshotInLoop(const std::vector<EventLoop*>& loops,
+                    const std::shared_ptr<std::vector<Snapshot>>& snapshots,
+                    size_t i)
+{
+  EventLoop* loop = loops[i];
+  Snapshot& snapshot = (*snapshots)[i];
+  snapshot.enabled = loop->healthStatsEnabled();
+  snapshot.iteration = loop->iteration();
+  snapshot.queueSize = loop->queueSize();
+  snapshot.numConnections = loop->numConnections();
+  snapshot.stats = loop->healthStats();
+}
+
+void resetInLoop(const std::vector<EventLoop*>& loops, size_t i)
+{
+  loops[i]->resetHealthStats();
+}
+
+void appendHistogram(string* out, const char* name, const Histogram& histogram)
+{
+  stringPrintf(out, "  %-18s %s\n", name, histogram.toString().c_str());
+}
+
+}  // namespace
+
+void LoopInspector::registerCommands(Inspector* ins)
+{
+  ins->add("loop", "health",
+           std::bind(&LoopInspector::health, this, _1, _2),
+           "print latency histograms of event loops, in microseconds");
+  ins->add("loop", "reset",
+           std::bind(&LoopInspector::reset, this, _1, _2),
+           "reset latency histograms of event loops");
+}
+
+void LoopInspector::addLoop(EventLoop* loop, const string& name)
+{
+  MutexLockGuard lock(mutex_);
+  loops_.push_back(NamedLoop(loop, name));
+}
+
+void LoopInspector::removeLoop(EventLoop* loop)
+{
+  MutexLockGuard lock(mutex_);
+  for (std::vector<NamedLoop>::iterator it = loops_.begin(); it != loops_.end(); )
+  {
+    if (it->first == loop)
+    {
+      it = loops_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+std::vector<LoopInspector::NamedLoop> LoopInspector::loops() const
+{
+  MutexLockGuard lock(mutex_);
+  return loops_;
+}
+
+string LoopInspector::health(HttpRequest::Method, const Inspector::ArgList&)
+{
+  std::vector<NamedLoop> named = loops();
+  std::vector<EventLoop*> loops;
+  for (const NamedLoop& it : named)
+  {
+    loops.push_back(it.first);
+  }
+  std::shared_ptr<std::vector<Snapshot>> snapshots(
+      std::make_shared<std::vector<Snapshot>>(loops.size()));
+  std::vector<bool> finished =
+      runInLoops(loops, std::bind(snapshotInLoop, loops, snapshots, _1));
+
+  string result;
+  for (size_t i = 0; i < named.size(); ++i)
+  {
+    if (!finished[i])
+    {
+      stringPrintf(&result, "%s: no answer, quit or stuck\n", named[i].second.c_str());
+      continue;
+    }
+    const Snapshot& snapshot = (*snapshots)[i];
+    stringPrintf(&result, "%s: iteration %" PRId64 ", %zu functors queued, %d connections\n",
+                 named[i].second.c_str(), snapshot.iteration,
+                 snapshot.queueSize, snapshot.numConnections);
+    if (!snapshot.enabled)
+    {
+      result += "  not enabled, see EventLoop::enableHealthStats()\n";
+      continue;
+    }
+    const EventLoop::HealthStats& stats = snapshot.stats;
+    appendHistogram(&result, "poll wait", stats.pollWait);
+    appendHistogram(&result, "channel callbacks", stats.channelCallbacks);
+    appendHistogram(&result, "pending functors", stats.pendingFunctors);
+    appendHistogram(&result, "functor backlog", stats.functorBacklog);
+    appendHistogram(&result, "timer lateness", stats.timerLateness);
+    stringPrintf(&result, "  %-18s %" PRId64 "\n", "slow callbacks", stats.slowCallbacks);
+  }
+  return result;
+}
+
+string LoopInspector::reset(HttpRequest::Method, const Inspector::ArgList&)
+{
+  std::vector<EventLoop*> loops;
+  for (const NamedLoop& it : this->loops())
+  {
+    loops.push_back(it.first);
+  }
+  std::vector<bool> finished = runInLoops(loops, std::bind(resetInLoop, loops, _1));
+  if (std::find(finished.begin(), finished.end(), false) != finished.end())
+  {
+    return "reset, but not all loops answered\n";
+  }
+  return "reset\n";
+}
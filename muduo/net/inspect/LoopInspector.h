@@ -0,0 +1,40 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+#define MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+
+#include "muduo/net/inspect/Inspector.h"
+
+namespace muduo
+{
+namespace net
+{
+
+/// EventLoop::healthStats() of the loops added to the Inspector,
+/// copied in their own loops on each request.
+class LoopInspector : noncopyable
+{
+ public:
+  void registerCommands(Inspector* ins);
+  void addLoop(EventLoop* loop, const string& name);
+  void removeLoop(EventLoop* loop);
+
+  string health(HttpRequest::Method, const Inspector::ArgList&);
+  string reset(HttpRequest::Method, const Inspector::ArgList&);
+
+ private:
+  typedef std::pair<EventLoop*, string> NamedLoop;
+
+  std::vector<NamedLoop> loops() const;
+
+  mutable MutexLock mutex_;
+  std::vector<NamedLoop> loops_ GUARDED_BY(mutex_);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_LOOPINSPECTOR_H
@@ -8,6 +8,7 @@
 //
 
 #include "muduo/net/inspect/ProcessInspector.h"
+#include "muduo/base/CpuAffinity.h"
 #include "muduo/base/FileUtil.h"
 #include "muduo/base/ProcessInfo.h"
 #include <limits.h>
@@ -128,6 +129,7 @@ void ProcessInspector::registerCommands(Inspector* ins)
   ins->add("proc", "status", ProcessInspector::procStatus, "print /proc/self/status");
   // ins->add("proc", "opened_files", ProcessInspector::openedFiles, "count /proc/self/fd");
   ins->add("proc", "threads", ProcessInspector::threads, "list /proc/self/task");
+  ins->add("proc", "affinity", ProcessInspector::affinity, "print CPU affinity and NUMA node of threads");
 }
 
 string ProcessInspector::overview(HttpRequest::Method, const Inspector::ArgList&)
@@ -209,6 +211,56 @@ string ProcessInspector::openedFiles(HttpRequest::Method, const Inspector::ArgLi
   return buf;
 }
 
+string ProcessInspector::affinity(HttpRequest::Method, const Inspector::ArgList&)
+{
+  std::vector<pid_t> threads = ProcessInfo::threads();
+  string result = "  TID NAME             CPU NODE ALLOWED\n";
+  result.reserve(threads.size() * 64);
+  string stat;
+  string status;
+  for (pid_t tid : threads)
+  {
+    char buf[256];
+    snprintf(buf, sizeof buf, "/proc/%d/task/%d/stat", ProcessInfo::pid(), tid);
+    if (FileUtil::readFile(buf, 65536, &stat) != 0)
+    {
+      continue;
+    }
+    snprintf(buf, sizeof buf, "/proc/%d/task/%d/status", ProcessInfo::pid(), tid);
+    if (FileUtil::readFile(buf, 65536, &status) != 0)
+    {
+      continue;
+    }
+    StringPiece name = ProcessInfo::procname(stat);
+    const char* rp = name.end();
+    assert(*rp == ')');
+    const char* state = rp + 2;
+    *const_cast<char*>(rp) = '\0';  // don't do this at home
+    StringPiece data(stat);
+    data.remove_prefix(static_cast<int>(state - data.data() + 2));
+    // from field 4 (ppid) to field 39 (processor)
+    for (int i = 0; i < 35; ++i)
+    {
+      data = next(data);
+    }
+    int cpu = static_cast<int>(strtol(data.data(), NULL, 10));
+
+    string allowed;
+    size_t pos = status.find("Cpus_allowed_list:");
+    if (pos != string::npos)
+    {
+      pos += strlen("Cpus_allowed_list:");
+      while (status[pos] == '\t')
+        ++pos;
+      size_t eol = status.find('\n', pos);
+      allowed = status.substr(pos, eol == string::npos ? string::npos : eol-pos);
+    }
+    stringPrintf(&result, "%5d %-16s %3d %4d %s\n",
+                 tid, name.data(), cpu, CpuAffinity::numaNodeOf(cpu), allowed.c_str());
+  }
+  return result;
+}
+
 string ProcessInspector::threads(HttpRequest::Method, const Inspector::ArgList&)
 {
   std::vector<pid_t> threads = ProcessInfo::threads();
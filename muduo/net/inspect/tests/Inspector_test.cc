@@ -1,15 +1,28 @@
 #include "muduo/net/inspect/Inspector.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThread.h"
+#include "muduo/net/TcpServer.h"
 
 using namespace muduo;
 using namespace muduo::net;
 
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
 int main()
 {
   EventLoop loop;
   EventLoopThread t;
   Inspector ins(t.startLoop(), InetAddress(12345), "test");
+  // try /net/top/bytes after some traffic
+  TcpServer server(&loop, InetAddress(12346), "EchoServer");
+  server.setMessageCallback(onMessage);
+  server.start();
+  ins.addServer(&server);
+  // try /loop/health
+  loop.enableHealthStats(1000);
+  ins.addLoop(&loop, "main");
   loop.loop();
 }
-
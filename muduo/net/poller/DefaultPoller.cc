@@ -7,21 +7,46 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include "muduo/net/Poller.h"
+
+#include "muduo/base/Logging.h"
 #include "muduo/net/poller/PollPoller.h"
 #include "muduo/net/poller/EPollPoller.h"
+#include "muduo/net/poller/IoUringPoller.h"
+
+#include <atomic>
 
 #include <stdlib.h>
 
 using namespace muduo::net;
 
+#ifdef MUDUO_HAVE_IO_URING
+namespace
+{
+// tried once per process, by the first loop
+std::atomic<bool> g_ioUringUnavailable(false);
+}  // namespace
+#endif
+
 Poller* Poller::newDefaultPoller(EventLoop* loop)
 {
   if (::getenv("MUDUO_USE_POLL"))
   {
     return new PollPoller(loop);
   }
-  else
+#ifdef MUDUO_HAVE_IO_URING
+  if (::getenv("MUDUO_USE_IOURING") && !g_ioUringUnavailable.load())
   {
-    return new EPollPoller(loop);
+    IoUringPoller* poller = new IoUringPoller(loop);
+    if (poller->valid())
+    {
+      return poller;
+    }
+    delete poller;
+    if (!g_ioUringUnavailable.exchange(true))
+    {
+      LOG_WARN << "io_uring is not available, using epoll";
+    }
   }
+#endif
+  return new EPollPoller(loop);
 }
@@ -173,7 +173,12 @@ void EPollPoller::update(int operation, Channel* channel)
 {
   struct epoll_event event;
   memZero(&event, sizeof event);
-  event.events = channel->events();
+  event.events = static_cast<uint32_t>(channel->events());
+  if (channel->isEdgeTriggered() && !channel->isNoneEvent())
+  {
+    // see Channel::updateWriting()
+    event.events |= EPOLLOUT | EPOLLET;
+  }
   event.data.ptr = channel;
   int fd = channel->fd();
   LOG_TRACE << "epoll_ctl op = " << operationToString(operation)
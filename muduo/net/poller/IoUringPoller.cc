@@ -0,0 +1,401 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/poller/IoUringPoller.h"
+
+#ifdef MUDUO_HAVE_IO_URING
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Channel.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+// no liburing dependency, talk to the kernel directly.
+int io_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete,
+                   unsigned flags, const void* arg, size_t argsz)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, arg, argsz));
+}
+
+template<typename T>
+T* ringPtr(void* ring, unsigned offset)
+{
+  return static_cast<T*>(implicit_cast<void*>(static_cast<char*>(ring) + offset));
+}
+
+const uint64_t kCancelToken = 0;
+}  // namespace
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+  : Poller(loop),
+    ringfd_(-1),
+    sqRing_(MAP_FAILED),
+    sqRingSize_(0),
+    cqRing_(MAP_FAILED),
+    cqRingSize_(0),
+    sqes_(NULL),
+    sqesSize_(0),
+    toSubmit_(0),
+    nextToken_(0)
+{
+  if (!setup())
+  {
+    release();
+  }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+  release();
+}
+
+bool IoUringPoller::setup()
+{
+  struct io_uring_params params;
+  memZero(&params, sizeof params);
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = kCompleteEntries;
+  ringfd_ = io_uring_setup(kSubmitEntries, &params);
+  if (ringfd_ < 0)
+  {
+    // eg. ENOSYS, or EPERM by seccomp
+    LOG_SYSERR << "IoUringPoller::setup";
+    return false;
+  }
+  if (!(params.features & IORING_FEAT_EXT_ARG)
+      || !(params.features & IORING_FEAT_NODROP))
+  {
+    LOG_ERROR << "IoUringPoller::setup - kernel too old, features = "
+              << params.features;
+    return false;
+  }
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap)
+  {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = ::mmap(NULL, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED)
+  {
+    LOG_SYSERR << "IoUringPoller::setup - mmap sq";
+    return false;
+  }
+  if (singleMmap)
+  {
+    cqRing_ = sqRing_;
+  }
+  else
+  {
+    cqRing_ = ::mmap(NULL, cqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED)
+    {
+      LOG_SYSERR << "IoUringPoller::setup - mmap cq";
+      return false;
+    }
+  }
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = ::mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    LOG_SYSERR << "IoUringPoller::setup - mmap sqes";
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  sqHead_ = ringPtr<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = ringPtr<unsigned>(sqRing_, params.sq_off.tail);
+  sqMask_ = *ringPtr<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqArray_ = ringPtr<unsigned>(sqRing_, params.sq_off.array);
+  sqEntries_ = params.sq_entries;
+  cqHead_ = ringPtr<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = ringPtr<unsigned>(cqRing_, params.cq_off.tail);
+  cqMask_ = *ringPtr<unsigned>(cqRing_, params.cq_off.ring_mask);
+  cqes_ = ringPtr<struct io_uring_cqe>(cqRing_, params.cq_off.cqes);
+  return true;
+}
+
+void IoUringPoller::release()
+{
+  if (sqes_)
+  {
+    ::munmap(sqes_, sqesSize_);
+    sqes_ = NULL;
+  }
+  if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+  {
+    ::munmap(cqRing_, cqRingSize_);
+  }
+  cqRing_ = MAP_FAILED;
+  if (sqRing_ != MAP_FAILED)
+  {
+    ::munmap(sqRing_, sqRingSize_);
+    sqRing_ = MAP_FAILED;
+  }
+  if (ringfd_ >= 0)
+  {
+    ::close(ringfd_);
+    ringfd_ = -1;
+  }
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  LOG_TRACE << "fd total count " << channels_.size();
+  rearmFired();
+
+  // don't block if completions are already waiting.
+  unsigned ready = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE) - *cqHead_;
+  int ret = enter(toSubmit_, ready > 0 ? 0 : 1, ready > 0 ? 0 : timeoutMs);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  if (ret >= 0 || savedErrno == ETIME)
+  {
+    fillActiveChannels(activeChannels);
+    if (activeChannels->empty())
+    {
+      LOG_TRACE << "nothing happened";
+    }
+    else
+    {
+      LOG_TRACE << activeChannels->size() << " events happened";
+    }
+  }
+  else if (savedErrno != EINTR)
+  {
+    errno = savedErrno;
+    LOG_SYSERR << "IoUringPoller::poll()";
+  }
+  return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+  unsigned head = *cqHead_;
+  const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head)
+  {
+    const struct io_uring_cqe& cqe = cqes_[head & cqMask_];
+    if (cqe.user_data == kCancelToken)
+    {
+      continue;
+    }
+    // stale completions, eg. -ECANCELED of a disarmed poll, are dropped here.
+    int fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+    ChannelMap::const_iterator it = channels_.find(fd);
+    if (it == channels_.end())
+    {
+      continue;
+    }
+    Channel* channel = it->second;
+    PollState& state = states_[channel->index()];
+    if (state.token != cqe.user_data)
+    {
+      continue;
+    }
+    state.token = 0;
+    if (cqe.res >= 0)
+    {
+      channel->set_revents(cqe.res);
+    }
+    else
+    {
+      // the poll itself failed, let the owner see it and close
+      errno = -cqe.res;
+      LOG_SYSERR << "IoUringPoller::fillActiveChannels fd = " << fd;
+      channel->set_revents(POLLERR);
+    }
+    activeChannels->push_back(channel);
+    fired_.push_back(fd);
+  }
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+void IoUringPoller::rearmFired()
+{
+  for (int fd : fired_)
+  {
+    ChannelMap::const_iterator it = channels_.find(fd);
+    if (it != channels_.end())
+    {
+      PollState& state = states_[it->second->index()];
+      if (state.token == 0 && state.events != 0)
+      {
+        arm(&state);
+      }
+    }
+  }
+  fired_.clear();
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  LOG_TRACE << "fd = " << channel->fd() << " events = " << channel->events();
+  if (channel->index() < 0)
+  {
+    // a new one, add to states_
+    assert(channels_.find(channel->fd()) == channels_.end());
+    PollState state = { channel->fd(), channel->events(), 0 };
+    states_.push_back(state);
+    channel->set_index(static_cast<int>(states_.size())-1);
+    channels_[state.fd] = channel;
+    if (!channel->isNoneEvent())
+    {
+      arm(&states_.back());
+    }
+  }
+  else
+  {
+    // update existing one
+    assert(channels_.find(channel->fd()) != channels_.end());
+    assert(channels_[channel->fd()] == channel);
+    int idx = channel->index();
+    assert(0 <= idx && idx < static_cast<int>(states_.size()));
+    PollState& state = states_[idx];
+    assert(state.fd == channel->fd());
+    if (state.token != 0 && state.events == channel->events())
+    {
+      return;
+    }
+    if (state.token != 0)
+    {
+      disarm(&state);
+    }
+    state.events = channel->events();
+    if (!channel->isNoneEvent())
+    {
+      arm(&state);
+    }
+  }
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  LOG_TRACE << "fd = " << channel->fd();
+  assert(channels_.find(channel->fd()) != channels_.end());
+  assert(channels_[channel->fd()] == channel);
+  assert(channel->isNoneEvent());
+  int idx = channel->index();
+  assert(0 <= idx && idx < static_cast<int>(states_.size()));
+  if (states_[idx].token != 0)
+  {
+    disarm(&states_[idx]);
+  }
+  size_t n = channels_.erase(channel->fd());
+  assert(n == 1); (void)n;
+  if (implicit_cast<size_t>(idx) != states_.size()-1)
+  {
+    states_[idx] = states_.back();
+    channels_[states_[idx].fd]->set_index(idx);
+  }
+  states_.pop_back();
+  channel->set_index(-1);
+}
+
+void IoUringPoller::arm(PollState* state)
+{
+  assert(state->token == 0);
+  if (++nextToken_ == 0)
+  {
+    ++nextToken_;
+  }
+  state->token = (static_cast<uint64_t>(nextToken_) << 32)
+                 | static_cast<uint32_t>(state->fd);
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = state->fd;
+  sqe->poll32_events = static_cast<uint32_t>(state->events);
+  sqe->user_data = state->token;
+}
+
+void IoUringPoller::disarm(PollState* state)
+{
+  assert(state->token != 0);
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = state->token;
+  sqe->user_data = kCancelToken;
+  state->token = 0;
+}
+
+struct io_uring_sqe* IoUringPoller::getSqe()
+{
+  unsigned tail = *sqTail_;
+  if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_)
+  {
+    // submission queue is full, flush it without waiting.
+    if (enter(toSubmit_, 0, 0) < 0)
+    {
+      LOG_SYSFATAL << "IoUringPoller::getSqe";
+    }
+  }
+  unsigned idx = tail & sqMask_;
+  struct io_uring_sqe* sqe = &sqes_[idx];
+  memZero(sqe, sizeof *sqe);
+  sqArray_[idx] = idx;
+  __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+  ++toSubmit_;
+  return sqe;
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned minComplete, int timeoutMs)
+{
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  memZero(&arg, sizeof arg);
+  unsigned flags = 0;
+  if (minComplete > 0)
+  {
+    flags |= IORING_ENTER_GETEVENTS;
+    if (timeoutMs >= 0)
+    {
+      ts.tv_sec = timeoutMs / 1000;
+      ts.tv_nsec = (timeoutMs % 1000) * 1000 * 1000;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+      flags |= IORING_ENTER_EXT_ARG;
+    }
+  }
+  const void* argp = (flags & IORING_ENTER_EXT_ARG) ? &arg : NULL;
+  int ret = io_uring_enter(ringfd_, toSubmit, minComplete, flags,
+                           argp, argp ? sizeof arg : 0);
+  if (ret >= 0)
+  {
+    assert(static_cast<unsigned>(ret) <= toSubmit_);
+    toSubmit_ -= static_cast<unsigned>(ret);
+  }
+  else if (errno == ETIME || errno == EINTR)
+  {
+    // all sqes are consumed before waiting
+    toSubmit_ = 0;
+  }
+  return ret;
+}
+
+#endif  // MUDUO_HAVE_IO_URING
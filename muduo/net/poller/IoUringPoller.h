@@ -0,0 +1,109 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_POLLER_IOURINGPOLLER_H
+#define MUDUO_NET_POLLER_IOURINGPOLLER_H
+
+#include "muduo/net/Poller.h"
+
+#include <vector>
+
+#ifndef NO_IO_URING
+#ifdef __has_include
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+#endif
+
+// pre-5.11 headers lack io_uring_getevents_arg, build without it then.
+#ifdef IORING_ENTER_EXT_ARG
+#define MUDUO_HAVE_IO_URING 1
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// IO Multiplexing with io_uring(7).
+///
+/// Readiness is still reported through Channel, so Channel, EventLoop and
+/// TcpConnection work unchanged.  Every interest change is queued as an
+/// IORING_OP_POLL_ADD/POLL_REMOVE sqe and submitted together with the wait,
+/// so a loop iteration costs one io_uring_enter(2) instead of an
+/// epoll_wait(2) plus one epoll_ctl(2) per changed channel.
+///
+/// Polls are one-shot, and re-armed lazily before the next wait,
+/// which keeps the level-triggered semantics muduo relies on.
+class IoUringPoller : public Poller
+{
+ public:
+  /// Logs why if io_uring is not available, see valid().
+  IoUringPoller(EventLoop* loop);
+  ~IoUringPoller() override;
+
+  /// False if the ring couldn't be set up, the poller is unusable then.
+  bool valid() const { return ringfd_ >= 0; }
+
+  Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+  void updateChannel(Channel* channel) override;
+  void removeChannel(Channel* channel) override;
+
+ private:
+  static const unsigned kSubmitEntries = 256;
+  static const unsigned kCompleteEntries = 4096;
+
+  struct PollState
+  {
+    int fd;
+    int events;
+    uint64_t token;  // user_data of the armed poll, 0 if not armed
+  };
+
+  bool setup();
+  void release();
+  void fillActiveChannels(ChannelList* activeChannels);
+  void rearmFired();
+  void arm(PollState* state);
+  void disarm(PollState* state);
+  struct io_uring_sqe* getSqe();
+  int enter(unsigned toSubmit, unsigned minComplete, int timeoutMs);
+
+  typedef std::vector<PollState> PollStateList;
+
+  int ringfd_;
+  // mmap'ed rings, see io_uring_setup(2)
+  void* sqRing_;
+  size_t sqRingSize_;
+  void* cqRing_;
+  size_t cqRingSize_;
+  struct io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned sqMask_;
+  unsigned* sqArray_;
+  unsigned sqEntries_;
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  unsigned cqMask_;
+  struct io_uring_cqe* cqes_;
+
+  unsigned toSubmit_;
+  uint32_t nextToken_;
+  PollStateList states_;
+  std::vector<int> fired_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // IORING_ENTER_EXT_ARG
+#endif  // MUDUO_NET_POLLER_IOURINGPOLLER_H
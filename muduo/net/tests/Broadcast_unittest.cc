@@ -0,0 +1,125 @@
+// broadcast() of one Slice to connections of several loops.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/net/Broadcast.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <set>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2020;
+const int kClients = 10;
+const int kRounds = 3;
+const size_t kMessage = 10*1024;
+
+EventLoop* g_loop;
+MutexLock g_mutex;
+std::set<TcpConnectionPtr> g_audiences GUARDED_BY(g_mutex);
+int g_rounds;
+int g_done;
+
+void publish()
+{
+  string message(kMessage, static_cast<char>('A' + g_rounds));
+  MutexLockGuard lock(g_mutex);
+  assert(g_audiences.size() == kClients);
+  broadcast(g_audiences, Slice(std::move(message)));
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  MutexLockGuard lock(g_mutex);
+  if (conn->connected())
+  {
+    g_audiences.insert(conn);
+    if (g_audiences.size() == kClients)
+    {
+      g_loop->queueInLoop(publish);
+    }
+  }
+  else
+  {
+    g_audiences.erase(conn);
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  if (buf->readableBytes() < kMessage)
+  {
+    return;
+  }
+  assert(buf->readableBytes() == kMessage);
+  string received = buf->retrieveAllAsString();
+  assert(received == string(kMessage, static_cast<char>('A' + g_rounds)));
+  if (++g_done == kClients)
+  {
+    g_done = 0;
+    if (++g_rounds == kRounds)
+    {
+      g_loop->quit();
+    }
+    else
+    {
+      publish();
+    }
+  }
+}
+
+void checkAllGone()
+{
+  MutexLockGuard lock(g_mutex);
+  if (g_audiences.empty())
+  {
+    g_loop->quit();
+  }
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, round %d, %d done\n", g_rounds, g_done);
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(10, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "Hub");
+  server.setThreadNum(3);
+  server.setConnectionCallback(onServerConnection);
+  server.start();
+
+  std::vector<std::unique_ptr<TcpClient>> clients;
+  for (int i = 0; i < kClients; ++i)
+  {
+    clients.emplace_back(new TcpClient(&loop, serverAddr, "Audience"));
+    clients.back()->setMessageCallback(onClientMessage);
+    clients.back()->connect();
+  }
+  loop.loop();
+  printf("%d rounds to %d clients\n", g_rounds, kClients);
+  assert(g_rounds == kRounds);
+  for (const auto& client : clients)
+  {
+    client->disconnect();
+  }
+  // till the server sees them all gone
+  loop.runEvery(0.01, checkAllGone);
+  loop.loop();
+}
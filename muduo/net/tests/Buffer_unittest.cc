@@ -1,4 +1,5 @@
 #include "muduo/net/Buffer.h"
+#include "muduo/net/BufferPool.h"
 
 //#define BOOST_TEST_MODULE BufferTest
 #define BOOST_TEST_MAIN
@@ -7,6 +8,7 @@
 
 using muduo::string;
 using muduo::net::Buffer;
+using muduo::net::BufferPool;
 
 BOOST_AUTO_TEST_CASE(testBufferAppendRetrieve)
 {
@@ -168,3 +170,63 @@ BOOST_AUTO_TEST_CASE(testMove)
   // printf("Buffer at %p, inner %p\n", &buf, inner);
   output(std::move(buf), inner);
 }
+
+BOOST_AUTO_TEST_CASE(testBufferRelease)
+{
+  Buffer buf;
+  buf.append("muduo", 5);
+  BOOST_CHECK(!buf.releaseIfEmpty());
+  buf.retrieveAll();
+  BOOST_CHECK(buf.releaseIfEmpty());
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), 0);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(buf.writableBytes(), 0);
+  BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend);
+
+  Buffer copy(buf);
+  BOOST_CHECK_EQUAL(copy.internalCapacity(), 0);
+
+  buf.append("chen", 4);
+  BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), "chen");
+  buf.prependInt32(1);
+  BOOST_CHECK_EQUAL(buf.readInt32(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferLazy)
+{
+  Buffer buf(0);
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), 0);
+  BOOST_CHECK_EQUAL(buf.writableBytes(), 0);
+  BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend);
+  BOOST_CHECK(!buf.releaseIfEmpty());
+
+  buf.append("muduo", 5);
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), Buffer::kCheapPrepend + Buffer::kInitialSize);
+  BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), "muduo");
+  BOOST_CHECK(buf.releaseIfEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPool)
+{
+  BufferPool pool;
+  BOOST_CHECK_EQUAL(BufferPool::current(), &pool);
+  BOOST_CHECK_EQUAL(BufferPool::blockSize(1), BufferPool::kMinBlockSize);
+  BOOST_CHECK_EQUAL(BufferPool::blockSize(1000), 8+1024);
+  BOOST_CHECK_EQUAL(BufferPool::blockSize(1000000), 1000000);
+
+  {
+    Buffer buf;
+    BOOST_CHECK_EQUAL(pool.misses(), 1);
+    BOOST_CHECK_EQUAL(pool.bytesInUse(), Buffer::kCheapPrepend + Buffer::kInitialSize);
+  }
+  BOOST_CHECK_EQUAL(pool.bytesInUse(), 0);
+  BOOST_CHECK_EQUAL(pool.cachedBytes(), Buffer::kCheapPrepend + Buffer::kInitialSize);
+  {
+    Buffer buf;
+    BOOST_CHECK_EQUAL(pool.hits(), 1);
+    Buffer copy(buf);
+    BOOST_CHECK_EQUAL(pool.misses(), 2);
+  }
+  pool.trim(0);
+  BOOST_CHECK_EQUAL(pool.cachedBytes(), 0);
+}
@@ -0,0 +1,170 @@
+#include "muduo/net/ChainBuffer.h"
+#include "muduo/net/Slice.h"
+
+//#define BOOST_TEST_MODULE ChainBufferTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <sys/uio.h>
+
+using muduo::string;
+using muduo::net::ChainBuffer;
+
+string concat(const ChainBuffer& buf)
+{
+  struct iovec vec[64];
+  int n = buf.peekIovec(vec, 64);
+  string result;
+  for (int i = 0; i < n; ++i)
+  {
+    result.append(static_cast<const char*>(vec[i].iov_base), vec[i].iov_len);
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferAppendRetrieve)
+{
+  ChainBuffer buf;
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK(buf.empty());
+
+  const string str(200, 'x');
+  buf.append(str);
+  buf.append(str);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 2*str.size());
+  BOOST_CHECK_EQUAL(buf.numBlocks(), 1);
+
+  buf.retrieve(50);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 350);
+  BOOST_CHECK_EQUAL(concat(buf), string(350, 'x'));
+
+  buf.retrieveAll();
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK(buf.empty());
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferSlices)
+{
+  ChainBuffer buf;
+  string str;
+  for (size_t i = 0; i < 3*ChainBuffer::kSliceSize + 100; ++i)
+  {
+    str.push_back(static_cast<char>('a' + i % 26));
+  }
+  buf.append(str);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), str.size());
+  BOOST_CHECK_EQUAL(buf.numBlocks(), 4);
+  BOOST_CHECK(concat(buf) == str);
+
+  buf.retrieve(ChainBuffer::kSliceSize + 10);
+  BOOST_CHECK_EQUAL(buf.numBlocks(), 3);
+  BOOST_CHECK(concat(buf) == str.substr(ChainBuffer::kSliceSize + 10));
+
+  // the last slice has room
+  buf.append("hello", 5);
+  BOOST_CHECK_EQUAL(buf.numBlocks(), 3);
+  BOOST_CHECK(concat(buf) == str.substr(ChainBuffer::kSliceSize + 10) + "hello");
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferCallerOwned)
+{
+  ChainBuffer buf;
+  std::shared_ptr<string> block(new string(1000, 'y'));
+  std::weak_ptr<string> weak(block);
+  buf.append("head", 4);
+  buf.append(block, block->data(), block->size());
+  buf.append("tail", 4);
+  BOOST_CHECK_EQUAL(buf.numBlocks(), 3);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 1008);
+  BOOST_CHECK(concat(buf) == "head" + string(1000, 'y') + "tail");
+
+  block.reset();
+  BOOST_CHECK(!weak.expired());
+  buf.retrieve(500);
+  BOOST_CHECK(!weak.expired());
+  buf.retrieve(504);
+  BOOST_CHECK(weak.expired());
+  BOOST_CHECK(concat(buf) == "tail");
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferStream)
+{
+  ChainBuffer buf;
+  std::shared_ptr<string> block(new string("0123456789"));
+  string expected;
+  // never drained, consumed blocks are compacted away
+  for (int i = 0; i < 100; ++i)
+  {
+    buf.append(block, block->data() + i % 10, 10 - i % 10);
+    buf.append(block, block->data(), 3);
+    expected += block->substr(i % 10) + "012";
+    buf.retrieve(7);
+    expected.erase(0, 7);
+    BOOST_CHECK_EQUAL(buf.readableBytes(), expected.size());
+    BOOST_CHECK(concat(buf) == expected);
+  }
+  BOOST_CHECK(!buf.empty());
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferFile)
+{
+  ChainBuffer buf;
+  std::shared_ptr<int> file(new int(0));
+  std::weak_ptr<int> weak(file);
+  buf.append("head", 4);
+  buf.appendFile(file, 7, 100, 1000);
+  buf.append("tail", 4);
+  file.reset();
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 1008);
+
+  int fd = -1;
+  off_t offset = 0;
+  size_t len = 0;
+  BOOST_CHECK(!buf.peekFile(&fd, &offset, &len));
+  BOOST_CHECK(concat(buf) == "head");  // stops at the file
+  buf.retrieve(4);
+
+  BOOST_CHECK(buf.peekFile(&fd, &offset, &len));
+  BOOST_CHECK_EQUAL(fd, 7);
+  BOOST_CHECK_EQUAL(offset, 100);
+  BOOST_CHECK_EQUAL(len, 1000);
+  BOOST_CHECK(concat(buf).empty());
+
+  buf.retrieve(600);
+  BOOST_CHECK(buf.peekFile(&fd, &offset, &len));
+  BOOST_CHECK_EQUAL(offset, 700);
+  BOOST_CHECK_EQUAL(len, 400);
+  BOOST_CHECK(!weak.expired());
+
+  buf.retrieve(400);
+  BOOST_CHECK(weak.expired());
+  BOOST_CHECK(!buf.peekFile(&fd, &offset, &len));
+  BOOST_CHECK(concat(buf) == "tail");
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferZeroCopy)
+{
+  ChainBuffer buf;
+  muduo::net::Slice payload(string(1000, 'z'));
+  std::weak_ptr<const void> weak(payload.holder());
+  buf.append("head", 4);
+  buf.appendZeroCopy(payload.holder(), payload.data(), payload.size());
+  payload = muduo::net::Slice();
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 1004);
+  BOOST_CHECK(concat(buf) == "head");  // stops at the zero-copy block
+
+  const char* data = NULL;
+  size_t len = 0;
+  std::shared_ptr<const void> holder;
+  BOOST_CHECK(!buf.peekZeroCopy(&data, &len, &holder));
+  buf.retrieve(4);
+  BOOST_CHECK(buf.peekZeroCopy(&data, &len, &holder));
+  BOOST_CHECK_EQUAL(len, 1000);
+  BOOST_CHECK(string(data, len) == string(1000, 'z'));
+
+  buf.retrieveAll();
+  BOOST_CHECK(!weak.expired());  // still held by the kernel, say
+  holder.reset();
+  BOOST_CHECK(weak.expired());
+}
@@ -0,0 +1,145 @@
+// Connect storm: many clients connect at once, like reconnecting after a deploy.
+// Compares accepting one connection per readable event with batched accept.
+//
+// Usage: connectstorm_test [connections [accept_batch [client_threads]]]
+// Both ends are in this process, ulimit -n must be over 2 * connections.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpServer.h"
+
+#include <memory>
+#include <vector>
+
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2010;
+
+int g_total = 0;
+int g_connected = 0;
+Timestamp g_allConnected;
+AtomicInt32 g_slowConnects;  // SYN retransmitted, the backlog overflowed
+
+void onConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+  if (conn->connected() && ++g_connected == g_total)
+  {
+    g_allConnected = Timestamp::now();
+    loop->quit();
+  }
+}
+
+// some were shed, eg. out of file descriptors
+void checkShed(EventLoop* loop, const TcpServer* server)
+{
+  TcpServer::AcceptStats stats = server->acceptStats();
+  if (stats.shed > 0 && stats.accepted + stats.shed >= g_total)
+  {
+    g_allConnected = Timestamp::now();
+    loop->quit();
+  }
+}
+
+// echo, so that the accepting loop has other work to do
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+void connectMany(CountDownLatch* start, int n, std::vector<int>* fds)
+{
+  struct sockaddr_in addr;
+  memZero(&addr, sizeof addr);
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(kPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  start->wait();
+  for (int i = 0; i < n; ++i)
+  {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    Timestamp before = Timestamp::now();
+    if (::connect(fd, sockets::sockaddr_cast(&addr), static_cast<socklen_t>(sizeof addr)) < 0)
+    {
+      LOG_SYSFATAL << "connect";
+    }
+    if (timeDifference(Timestamp::now(), before) > 0.5)
+    {
+      g_slowConnects.increment();
+    }
+    if (::write(fd, "hello", 5) != 5)
+    {
+      LOG_SYSERR << "write";
+    }
+    fds->push_back(fd);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  g_total = argc > 1 ? atoi(argv[1]) : 5000;
+  int batch = argc > 2 ? atoi(argv[2]) : 64;
+  int numThreads = argc > 3 ? atoi(argv[3]) : 8;
+  Logger::setLogLevel(Logger::WARN);
+
+  EventLoop loop;
+  TcpServer server(&loop, InetAddress(kPort), "ConnectStorm");
+  server.setConnectionCallback(std::bind(onConnection, &loop, _1));
+  server.setMessageCallback(onMessage);
+  server.setAcceptBatch(batch);
+  server.start();
+  loop.runEvery(0.1, std::bind(checkShed, &loop, &server));
+
+  CountDownLatch start(1);
+  std::vector<std::vector<int>> fds(numThreads);
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < numThreads; ++i)
+  {
+    int n = g_total / numThreads + (i < g_total % numThreads ? 1 : 0);
+    threads.emplace_back(new Thread(std::bind(connectMany, &start, n, &fds[i])));
+    threads.back()->start();
+  }
+
+  Timestamp begin = Timestamp::now();
+  start.countDown();
+  loop.loop();
+  double seconds = timeDifference(g_allConnected, begin);
+
+  TcpServer::AcceptStats stats = server.acceptStats();
+  printf("batch %d: %d connections in %.3f seconds, %.0f per second\n",
+         batch, g_total, seconds, g_total / seconds);
+  printf("accepted %" PRId64 " shed %" PRId64 " in %" PRId64 " batches,"
+         " %.1f per batch, max %" PRId64 ", slow connects %d\n",
+         stats.accepted, stats.shed, stats.batches,
+         static_cast<double>(stats.accepted) / static_cast<double>(stats.batches),
+         stats.maxBatch, g_slowConnects.get());
+
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  for (const auto& threadFds : fds)
+  {
+    for (int fd : threadFds)
+    {
+      ::close(fd);
+    }
+  }
+}
@@ -0,0 +1,201 @@
+// ConnectionPool against an echo server in the same loop.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/ConnectionPool.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpServer.h"
+
+#include <vector>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2015;
+const uint16_t kClosedPort = 2016;
+
+EventLoop* g_loop;
+ConnectionPool* g_pool;
+int g_connected;
+std::vector<TcpConnectionPtr> g_leased;
+string g_echoed;
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+void onPoolConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected() && ++g_connected == 2)
+  {
+    g_loop->quit();
+  }
+}
+
+void onLeased(const TcpConnectionPtr& conn)
+{
+  g_leased.push_back(conn);
+}
+
+void onLeasedAndQuit(const TcpConnectionPtr& conn)
+{
+  g_leased.push_back(conn);
+  g_loop->quit();
+}
+
+void leaseThree(const InetAddress& serverAddr)
+{
+  g_pool->lease(serverAddr, onLeased);
+  g_pool->lease(serverAddr, onLeased);
+  // idle ones within lease()
+  assert(g_leased.size() == 2);
+  g_pool->lease(serverAddr, onLeasedAndQuit);
+  assert(g_leased.size() == 2);
+}
+
+void onEcho(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  g_echoed += buf->retrieveAllAsString();
+  if (g_echoed.size() == 5)
+  {
+    g_loop->quit();
+  }
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout\n");
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::ERROR);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(10, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "EchoServer");
+  server.setMessageCallback(onServerMessage);
+  server.start();
+
+  std::unique_ptr<ConnectionPool> pool(new ConnectionPool(&loop, "Pool"));
+  g_pool = pool.get();
+  pool->setMinIdle(2);
+  pool->setMaxIdle(2);
+  pool->setMaxConnections(3);
+  pool->setLeaseTimeout(0.3);
+  pool->setConnectionCallback(onPoolConnection);
+
+  // pre-warmed
+  pool->warmUp(serverAddr);
+  loop.loop();
+  ConnectionPool::Stats stats = pool->stats();
+  assert(stats.connects == 2 && stats.idle == 2);
+
+  // two idle ones, one more connects
+  loop.runAfter(0, std::bind(leaseThree, serverAddr));
+  loop.loop();
+  stats = pool->stats();
+  assert(g_leased.size() == 3);
+  assert(stats.leases == 3 && stats.reused == 2 && stats.waited == 1);
+  assert(stats.connects == 3 && stats.leased == 3 && stats.idle == 0);
+
+  // at maxConnections, waits for a release
+  pool->lease(serverAddr, onLeasedAndQuit);
+  assert(g_leased.size() == 3);
+  TcpConnectionPtr released = g_leased[0];
+  g_leased.erase(g_leased.begin());
+  loop.runAfter(0.05, std::bind(&ConnectionPool::release, g_pool, released));
+  loop.loop();
+  assert(g_leased.size() == 3 && g_leased.back() == released);
+  assert(pool->stats().connects == 3);
+
+  // the leaseholder's own message callback
+  TcpConnectionPtr conn = g_leased.back();
+  conn->setMessageCallback(onEcho);
+  conn->send("hello");
+  loop.loop();
+  assert(g_echoed == "hello");
+
+  // beyond maxIdle, closed
+  for (const TcpConnectionPtr& leased : g_leased)
+  {
+    pool->release(leased);
+  }
+  g_leased.clear();
+  loop.runAfter(0.1, quit);
+  loop.loop();
+  stats = pool->stats();
+  assert(stats.idle == 2 && stats.leased == 0 && stats.retired == 1);
+
+  // minIdle kept while leased
+  pool->lease(serverAddr, onLeased);
+  loop.runAfter(0.1, quit);
+  loop.loop();
+  stats = pool->stats();
+  assert(stats.leased == 1 && stats.idle == 2 && stats.connects == 4);
+  TcpConnectionPtr kept = g_leased[0];
+  g_leased.clear();
+
+  // unreachable, times out
+  pool->lease(InetAddress("127.0.0.1", kClosedPort), onLeasedAndQuit);
+  loop.loop();
+  assert(g_leased.size() == 1 && !g_leased[0]);
+  assert(pool->stats().timeouts == 1);
+  g_leased.clear();
+
+  stats = pool->stats();
+  printf("leases %" PRId64 ", reused %" PRId64 ", waited %" PRId64 ", connects %" PRId64 "\n",
+         stats.leases, stats.reused, stats.waited, stats.connects);
+
+  // the pool's callbacks again after release
+  pool->lease(serverAddr, onLeased);
+  assert(g_leased.size() == 1);
+  TcpConnectionPtr returned = g_leased[0];
+  g_leased.clear();
+  returned->setMessageCallback(onEcho);
+  returned->setWriteCompleteCallback(onLeased);
+  pool->release(returned);
+  g_echoed.clear();
+  returned->send("again");
+  loop.runAfter(0.1, quit);
+  loop.loop();
+  assert(g_echoed.empty() && g_leased.empty());
+
+  // one retired, which closes after the pool
+  pool->lease(serverAddr, onLeased);
+  pool->release(kept);
+  for (const TcpConnectionPtr& leased : g_leased)
+  {
+    pool->release(leased);
+  }
+  g_leased.clear();
+  assert(pool->stats().retired == 2);
+  // TcpClient closes a connection at destruction only if nobody else holds it
+  released.reset();
+  conn.reset();
+  kept.reset();
+  returned.reset();
+  pool.reset();
+  // connectDestroyed() of all
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
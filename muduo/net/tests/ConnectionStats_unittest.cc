@@ -0,0 +1,116 @@
+// TcpConnection::stats() of both ends of an echo.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2018;
+const int kRounds = 100;
+const size_t kMessage = 1000;
+
+EventLoop* g_loop;
+int g_rounds;
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->send(string(kMessage, 'S'));
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  if (buf->readableBytes() < kMessage)
+  {
+    return;
+  }
+  buf->retrieve(kMessage);
+  if (++g_rounds < kRounds)
+  {
+    conn->send(string(kMessage, 'S'));
+  }
+  else
+  {
+    g_loop->quit();
+  }
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, %d rounds\n", g_rounds);
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(10, timeout);
+  loop.enableHealthStats();  // times MessageCallback
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "EchoServer");
+  server.setMessageCallback(onServerMessage);
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "StatsClient");
+  client.setConnectionCallback(onClientConnection);
+  client.setMessageCallback(onClientMessage);
+  client.connect();
+  loop.loop();
+
+  const int64_t total = kRounds * kMessage;
+  std::vector<TcpConnectionPtr> conns = server.connections();
+  assert(conns.size() == 1);
+  const TcpConnection::Stats& serverStats = conns[0]->stats();
+  const TcpConnection::Stats& clientStats = client.connection()->stats();
+  printf("server: in %" PRId64 " out %" PRId64 " reads %" PRId64 " writes %" PRId64
+         " callbacks %" PRId64 " in %" PRId64 " us\n",
+         serverStats.bytesReceived, serverStats.bytesSent,
+         serverStats.readCalls, serverStats.writeCalls,
+         serverStats.messageCallbacks, serverStats.callbackMicroSeconds);
+  assert(serverStats.bytesReceived == total);
+  assert(serverStats.bytesSent == total);
+  assert(serverStats.readCalls >= serverStats.messageCallbacks);
+  assert(serverStats.messageCallbacks >= kRounds);
+  assert(serverStats.writeCalls >= kRounds);
+  assert(serverStats.callbackMicroSeconds >= serverStats.maxCallbackMicroSeconds);
+  assert(serverStats.creationTime.valid());
+  assert(!(serverStats.lastReceiveTime < serverStats.creationTime));
+
+  assert(clientStats.bytesSent == total);
+  assert(clientStats.bytesReceived == total);
+  assert(clientStats.messageCallbacks >= kRounds);
+  client.disconnect();
+  conns.clear();
+  // connectDestroyed() of both
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
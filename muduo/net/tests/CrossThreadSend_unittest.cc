@@ -0,0 +1,160 @@
+// TcpConnection::send() from another thread, by move, in order,
+// with sendFile() and functors which send in the loop in between.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2019;
+const int kMessages = 20000;
+const size_t kFileSize = 64*1024;
+
+EventLoop* g_loop;
+char g_file[] = "/tmp/muduo_crossthread_XXXXXX";
+string g_expected;
+string g_received;
+
+// every 4th message is large, every 3rd is a Buffer
+string message(int i)
+{
+  char buf[32];
+  snprintf(buf, sizeof buf, "%d,", i);
+  return i % 4 == 0 ? string(4096, static_cast<char>('a' + i % 26)) + buf : buf;
+}
+
+string fileContent()
+{
+  return string(kFileSize - 1, 'F') + ",";
+}
+
+// some by sendFile(), some by functors in the loop
+string expected(int i)
+{
+  return i % 1000 == 500 ? fileContent() : message(i);
+}
+
+void sendMessage(const TcpConnectionPtr& conn, const string& message)
+{
+  conn->send(message);
+}
+
+void produce(const TcpConnectionPtr& conn)
+{
+  for (int i = 0; i < kMessages; ++i)
+  {
+    if (i % 1000 == 500)
+    {
+      conn->sendFile(::open(g_file, O_RDONLY | O_CLOEXEC), 0, kFileSize);
+    }
+    else if (i % 100 == 50)
+    {
+      conn->getLoop()->runInLoop(std::bind(sendMessage, conn, message(i)));
+    }
+    else if (i % 3 == 0)
+    {
+      Buffer buf;
+      buf.append(message(i));
+      conn->send(std::move(buf));
+    }
+    else if (i % 3 == 1)
+    {
+      conn->send(message(i));
+    }
+    else
+    {
+      Buffer buf;
+      buf.append(message(i));
+      conn->send(&buf);
+      assert(buf.readableBytes() == 0);
+    }
+  }
+}
+
+std::unique_ptr<Thread> g_producer;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    g_producer.reset(new Thread(std::bind(produce, conn), "producer"));
+    g_producer->start();
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  g_received += buf->retrieveAllAsString();
+  if (g_received.size() >= g_expected.size())
+  {
+    g_loop->quit();
+  }
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, received %zu of %zu\n", g_received.size(), g_expected.size());
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  int fd = ::mkstemp(g_file);
+  assert(fd >= 0);
+  const string content = fileContent();
+  assert(::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+  ::close(fd);
+  for (int i = 0; i < kMessages; ++i)
+  {
+    g_expected += expected(i);
+  }
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(30, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "Server");
+  server.setConnectionCallback(onServerConnection);
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "Client");
+  client.setMessageCallback(onClientMessage);
+  client.connect();
+  loop.loop();
+  g_producer->join();
+  g_producer.reset();  // holds the server connection
+  ::unlink(g_file);
+
+  assert(g_received == g_expected);
+  std::vector<TcpConnectionPtr> conns = server.connections();
+  assert(conns.size() == 1);
+  printf("%d sends in %" PRId64 " writes\n", kMessages, conns[0]->stats().writeCalls);
+  client.disconnect();
+  conns.clear();
+  // connectDestroyed() of both
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
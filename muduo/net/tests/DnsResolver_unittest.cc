@@ -0,0 +1,358 @@
+// DnsResolver against a stub DNS server in the same loop.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/net/DnsResolver.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+#include "muduo/net/UdpSocket.h"
+
+#include <map>
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kDnsPort = 2013;
+const uint16_t kTcpPort = 2014;
+
+EventLoop* g_loop;
+
+void append16(string* out, uint16_t x)
+{
+  out->push_back(static_cast<char>(x >> 8));
+  out->push_back(static_cast<char>(x & 0xff));
+}
+
+void append32(string* out, uint32_t x)
+{
+  append16(out, static_cast<uint16_t>(x >> 16));
+  append16(out, static_cast<uint16_t>(x & 0xffff));
+}
+
+string encodeName(const string& name)
+{
+  string encoded;
+  size_t start = 0;
+  while (start < name.size())
+  {
+    size_t dot = name.find('.', start);
+    if (dot == string::npos)
+    {
+      dot = name.size();
+    }
+    encoded.push_back(static_cast<char>(dot - start));
+    encoded.append(name, start, dot - start);
+    start = dot + 1;
+  }
+  encoded.push_back('\0');
+  return encoded;
+}
+
+// Answers A queries of its records, with an optional CNAME,
+// NXDOMAIN for other names, and nothing for "silent.test".
+class StubDnsServer : noncopyable
+{
+ public:
+  struct Record
+  {
+    string ip;
+    uint32_t ttl;
+    string alias;  // answers with a CNAME to alias first
+  };
+
+  StubDnsServer(EventLoop* loop, const InetAddress& addr)
+    : socket_(loop)
+  {
+    bool ok = socket_.bind(addr);
+    assert(ok); (void)ok;
+    socket_.setMessageCallback(
+        std::bind(&StubDnsServer::onMessage, this, _1, _2, _3));
+    socket_.startReading();
+  }
+
+  void add(const string& name, const string& ip, uint32_t ttl, const string& alias = string())
+  {
+    records_[name] = Record{ ip, ttl, alias };
+  }
+
+  int queries(const string& name) { return queries_[name]; }
+
+ private:
+  void onMessage(UdpSocket* socket, const std::vector<UdpDatagram>& datagrams, Timestamp)
+  {
+    for (const UdpDatagram& datagram : datagrams)
+    {
+      const unsigned char* msg = reinterpret_cast<const unsigned char*>(datagram.data);
+      string name;
+      size_t pos = 12;
+      while (pos < datagram.size && msg[pos] != 0)
+      {
+        if (!name.empty())
+        {
+          name.push_back('.');
+        }
+        name.append(datagram.data + pos + 1, msg[pos]);
+        pos += 1 + msg[pos];
+      }
+      const size_t questionEnd = pos + 5;  // the root, qtype and qclass
+      ++queries_[name];
+      if (name == "silent.test")
+      {
+        continue;
+      }
+
+      std::map<string, Record>::const_iterator it = records_.find(name);
+      const bool found = it != records_.end();
+      string response(datagram.data, 2);  // id
+      append16(&response, found ? 0x8180 : 0x8183);
+      append16(&response, 1);
+      append16(&response, found ? (it->second.alias.empty() ? 1 : 2) : 0);
+      append16(&response, 0);
+      append16(&response, 0);
+      response.append(datagram.data + 12, questionEnd - 12);
+      if (found)
+      {
+        uint16_t owner = 0xc00c;  // the question
+        if (!it->second.alias.empty())
+        {
+          string target = encodeName(it->second.alias);
+          append16(&response, owner);
+          append16(&response, 5);  // CNAME
+          append16(&response, 1);
+          append32(&response, it->second.ttl);
+          append16(&response, static_cast<uint16_t>(target.size()));
+          owner = static_cast<uint16_t>(0xc000 | response.size());
+          response += target;
+        }
+        struct in_addr ip;
+        ::inet_pton(AF_INET, it->second.ip.c_str(), &ip);
+        append16(&response, owner);
+        append16(&response, 1);  // A
+        append16(&response, 1);
+        append32(&response, it->second.ttl);
+        append16(&response, 4);
+        response.append(reinterpret_cast<const char*>(&ip.s_addr), 4);
+      }
+      socket->sendTo(response.data(), response.size(), datagram.peer);
+    }
+  }
+
+  UdpSocket socket_;
+  std::map<string, Record> records_;
+  std::map<string, int> queries_;
+};
+
+struct Result
+{
+  int calls;
+  bool resolved;
+  InetAddress addr;
+};
+
+int g_pending;
+
+void onResolved(Result* result, bool resolved, const InetAddress& addr)
+{
+  ++result->calls;
+  result->resolved = resolved;
+  result->addr = addr;
+  if (--g_pending == 0)
+  {
+    g_loop->quit();
+  }
+}
+
+void startLookup(DnsResolver* resolver, const string& hostname, uint16_t port, Result* result)
+{
+  resolver->resolve(hostname, port, std::bind(onResolved, result, _1, _2));
+  assert(result->calls == 0);  // never within resolve()
+}
+
+// queued in the loop, as it's not the loop thread
+void resolveFromThread(DnsResolver* resolver, const string& hostname, Result* result)
+{
+  resolver->resolve(hostname, 80, std::bind(onResolved, result, _1, _2));
+}
+
+// from a timer, like from other events of a running loop
+Result lookup(DnsResolver* resolver, const string& hostname, uint16_t port)
+{
+  Result result = Result();
+  g_pending = 1;
+  g_loop->runAfter(0, std::bind(startLookup, resolver, hostname, port, &result));
+  g_loop->loop();
+  assert(result.calls == 1);
+  return result;
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout\n");
+  abort();
+}
+
+void onConnection(bool* connected, const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    *connected = true;
+    g_loop->quit();
+  }
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(10, timeout);
+
+  InetAddress dnsAddr("127.0.0.1", kDnsPort);
+  StubDnsServer stub(&loop, dnsAddr);
+  stub.add("a.test", "10.0.0.1", 60);
+  stub.add("b.test", "10.0.0.2", 60);
+  stub.add("www.test", "10.0.0.3", 60, "cdn.test");
+  stub.add("zero.test", "10.0.0.4", 0);
+  stub.add("server.test", "127.0.0.1", 60);
+
+  char hostsFile[] = "/tmp/muduo_resolver_hostsXXXXXX";
+  int fd = ::mkstemp(hostsFile);
+  assert(fd >= 0);
+  const char hosts[] = "# comment\n10.1.1.1 Gateway.test gw  # trailing\n::1 ip6-localhost\n"
+                       "10.1.1.2 first.test ;not-a-comment second.test\n";
+  ssize_t n = ::write(fd, hosts, sizeof hosts - 1);
+  assert(n == static_cast<ssize_t>(sizeof hosts - 1)); (void)n;
+  ::close(fd);
+
+  std::unique_ptr<DnsResolver> owner(new DnsResolver(&loop, dnsAddr, hostsFile));
+  DnsResolver* resolver = owner.get();
+  resolver->setTimeout(200, 1);
+  loop.setResolver(std::move(owner));
+  assert(loop.resolver() == resolver);
+  ::unlink(hostsFile);
+
+  // numeric
+  Result r = lookup(resolver, "192.168.0.1", 80);
+  assert(r.resolved && r.addr.toIpPort() == "192.168.0.1:80");
+
+  // hosts file, case insensitive
+  r = lookup(resolver, "GW", 22);
+  assert(r.resolved && r.addr.toIpPort() == "10.1.1.1:22");
+  r = lookup(resolver, "gateway.test.", 22);
+  assert(r.resolved && r.addr.toIp() == "10.1.1.1");
+  // ';' starts a comment in resolv.conf only
+  r = lookup(resolver, "second.test", 22);
+  assert(r.resolved && r.addr.toIp() == "10.1.1.2");
+  assert(resolver->stats().hostsHits == 3);
+
+  // name server, then cache
+  r = lookup(resolver, "a.test", 80);
+  assert(r.resolved && r.addr.toIpPort() == "10.0.0.1:80");
+  r = lookup(resolver, "A.test", 8080);
+  assert(r.resolved && r.addr.toIpPort() == "10.0.0.1:8080");
+  assert(stub.queries("a.test") == 1);
+  assert(resolver->stats().cacheHits == 1);
+
+  // concurrent lookups share one query
+  Result results[3] = { Result(), Result(), Result() };
+  g_pending = 3;
+  for (int i = 0; i < 3; ++i)
+  {
+    loop.runAfter(0, std::bind(startLookup, resolver, "b.test",
+                               static_cast<uint16_t>(1000 + i), &results[i]));
+  }
+  loop.loop();
+  for (int i = 0; i < 3; ++i)
+  {
+    assert(results[i].calls == 1 && results[i].resolved);
+    assert(results[i].addr.toIp() == "10.0.0.2" && results[i].addr.toPort() == 1000 + i);
+  }
+  assert(stub.queries("b.test") == 1);
+  assert(resolver->stats().coalesced == 2);
+
+  // CNAME, with a compressed owner name of the A record
+  r = lookup(resolver, "www.test", 443);
+  assert(r.resolved && r.addr.toIpPort() == "10.0.0.3:443");
+
+  // zero TTL is not cached
+  lookup(resolver, "zero.test", 80);
+  r = lookup(resolver, "zero.test", 80);
+  assert(r.resolved && r.addr.toIp() == "10.0.0.4");
+  assert(stub.queries("zero.test") == 2);
+
+  // NXDOMAIN, cached for a while
+  r = lookup(resolver, "missing.test", 80);
+  assert(!r.resolved);
+  r = lookup(resolver, "missing.test", 80);
+  assert(!r.resolved);
+  assert(stub.queries("missing.test") == 1);
+
+  // no answer, retried once
+  r = lookup(resolver, "silent.test", 80);
+  assert(!r.resolved);
+  assert(stub.queries("silent.test") == 2);
+  assert(resolver->stats().timeouts == 1);
+
+  // invalid names are not sent
+  r = lookup(resolver, "bad..test", 80);
+  assert(!r.resolved);
+  assert(stub.queries("bad..test") == 0);
+
+  // TcpClient by hostname
+  TcpServer server(&loop, InetAddress("127.0.0.1", kTcpPort), "ResolverTest");
+  server.start();
+  bool connected = false;
+  TcpClient client(&loop, "server.test", kTcpPort, "ResolverTestClient");
+  client.setConnectionCallback(std::bind(onConnection, &connected, _1));
+  client.connect();
+  loop.loop();
+  assert(connected);
+  assert(client.connection()->peerAddress().toIpPort() == "127.0.0.1:2014");
+  client.disconnect();
+
+  printf("queries %" PRId64 ", cache hits %" PRId64 ", coalesced %" PRId64 "\n",
+         resolver->stats().queries, resolver->stats().cacheHits,
+         resolver->stats().coalesced);
+
+  // lookups in flight fail when their resolver goes
+  Result dropped = Result();
+  g_pending = 1;
+  resolver->resolve("silent.test", 80, std::bind(onResolved, &dropped, _1, _2));
+  loop.setResolver(std::unique_ptr<DnsResolver>(new DnsResolver(&loop, dnsAddr, "")));
+  assert(dropped.calls == 0);
+  loop.loop();
+  assert(dropped.calls == 1 && !dropped.resolved);
+
+  // and so do those queued by other threads, which find it gone
+  Result queued = Result();
+  g_pending = 1;
+  Thread other(std::bind(resolveFromThread, loop.resolver(), "a.test", &queued), "Resolve");
+  other.start();
+  other.join();
+  loop.setResolver(std::unique_ptr<DnsResolver>(new DnsResolver(&loop, dnsAddr, "")));
+  loop.loop();
+  assert(queued.calls == 1 && !queued.resolved);
+
+  // connectDestroyed() of both
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
@@ -0,0 +1,146 @@
+// TcpServer::setEdgeTriggered(), bulk echo to a client which stops
+// reading for a while, so that the server runs out of its read budget,
+// and its writes hit EAGAIN.  Level-triggered with pollers that can't
+// do edges, eg. with MUDUO_USE_IOURING, the echo is the same.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2022;
+const size_t kIoBudget = 16*1024;
+const size_t kTotal = 32*1024*1024;
+const size_t kChunk = 64*1024;
+
+EventLoop* g_loop;
+TcpConnectionPtr g_serverConn;
+size_t g_sent;
+size_t g_echoed;
+int g_overBudget;  // reads stopped by the budget, continued later
+size_t g_stalledOutput;
+
+// the byte at offset i of the stream
+char expected(size_t i)
+{
+  return static_cast<char>('a' + (i / kChunk) % 26);
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    assert(conn->isEdgeTriggered() == conn->getLoop()->supportsEdgeTriggered());
+    g_serverConn = conn;
+  }
+}
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  if (buf->readableBytes() >= kIoBudget)
+  {
+    ++g_overBudget;
+  }
+  conn->send(buf);
+}
+
+void sendChunk(const TcpConnectionPtr& conn)
+{
+  if (g_sent < kTotal)
+  {
+    conn->send(string(kChunk, expected(g_sent)));
+    g_sent += kChunk;
+  }
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->stopRead();
+    sendChunk(conn);
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  for (size_t i = 0; i < buf->readableBytes(); ++i)
+  {
+    assert(buf->peek()[i] == expected(g_echoed + i));
+  }
+  g_echoed += buf->readableBytes();
+  buf->retrieveAll();
+  if (g_echoed == kTotal)
+  {
+    g_loop->quit();
+  }
+}
+
+void stalled(TcpClient* client)
+{
+  // the kernel buffers in between are full, the rest waits in the server
+  g_stalledOutput = g_serverConn->outputBytes();
+  printf("stalled: sent %zu, server output %zu\n", g_sent, g_stalledOutput);
+  assert(g_stalledOutput > 0);
+  client->connection()->startRead();
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, sent %zu echoed %zu\n", g_sent, g_echoed);
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(30, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "EchoServer");
+  server.setEdgeTriggered(kIoBudget);
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "BulkClient");
+  client.setConnectionCallback(onClientConnection);
+  client.setMessageCallback(onClientMessage);
+  client.setWriteCompleteCallback(sendChunk);
+  client.connect();
+  loop.runAfter(1.0, std::bind(stalled, &client));
+  loop.loop();
+
+  const TcpConnection::Stats& stats = g_serverConn->stats();
+  printf("echoed %zu, %d reads over budget, %" PRId64 " message callbacks\n",
+         g_echoed, g_overBudget, stats.messageCallbacks);
+  assert(g_echoed == kTotal);
+  assert(g_overBudget > 0 || !loop.supportsEdgeTriggered());
+  assert(g_serverConn->outputBytes() == 0);
+
+  client.disconnect();
+  g_serverConn.reset();
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
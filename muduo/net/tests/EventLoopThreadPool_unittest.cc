@@ -1,5 +1,6 @@
 #include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Thread.h"
 
 #include <stdio.h>
@@ -20,6 +21,12 @@ void init(EventLoop* p)
          getpid(), CurrentThread::tid(), p);
 }
 
+void block(CountDownLatch* running, CountDownLatch* blocking)
+{
+  running->countDown();
+  blocking->wait();
+}
+
 int main()
 {
   print();
@@ -63,6 +70,33 @@ int main()
     assert(nextLoop == model.getNextLoop());
   }
 
+  {
+    printf("Least queue size:\n");
+    CountDownLatch running(1);
+    CountDownLatch blocking(1);
+    EventLoopThreadPool model(&loop, "least");
+    model.setThreadNum(3);
+    model.setLoopSelector(&EventLoopThreadPool::leastQueueSize);
+    model.start(init);
+    std::vector<EventLoop*> loops = model.getAllLoops();
+    // keeps loops[0] busy, so that functors queued after are pending.
+    loops[0]->runInLoop(std::bind(block, &running, &blocking));
+    running.wait();
+    loops[0]->queueInLoop(std::bind(print, loops[0]));
+    assert(loops[0]->queueSize() == 1);
+    assert(model.getNextLoop() != loops[0]);
+    assert(EventLoopThreadPool::powerOfTwoChoices(loops) != NULL);
+    // two distinct choices, so of two loops the less loaded one always
+    std::vector<EventLoop*> two(loops.begin(), loops.begin() + 2);
+    two[0]->countConnection(1);
+    for (int i = 0; i < 100; ++i)
+    {
+      assert(EventLoopThreadPool::powerOfTwoChoices(two) == two[1]);
+    }
+    two[0]->countConnection(-1);
+    blocking.countDown();
+  }
+
   loop.loop();
 }
 
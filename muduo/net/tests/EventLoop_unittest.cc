@@ -1,8 +1,13 @@
 #include "muduo/net/EventLoop.h"
+#include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Thread.h"
 
+#include <memory>
+#include <vector>
+
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -27,8 +32,79 @@ void threadFunc()
   loop.loop();
 }
 
-int main()
+// contention benchmark: producers queueInLoop() into one loop.
+
+int g_done;
+int g_total;
+
+void count()
+{
+  if (++g_done == g_total)
+  {
+    g_loop->quit();
+  }
+}
+
+void produce(CountDownLatch* start, int n, int batch)
+{
+  start->wait();
+  if (batch <= 1)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      g_loop->queueInLoop(count);
+    }
+  }
+  else
+  {
+    for (int i = 0; i < n; i += batch)
+    {
+      std::vector<EventLoop::Functor> cbs(batch, count);
+      g_loop->queueAllInLoop(std::move(cbs));
+    }
+  }
+}
+
+void bench(int nthreads, int n, int batch)
+{
+  EventLoop loop;
+  g_loop = &loop;
+  g_done = 0;
+  g_total = nthreads * n;
+  CountDownLatch start(1);
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < nthreads; ++i)
+  {
+    threads.emplace_back(new Thread(std::bind(produce, &start, n, batch)));
+    threads.back()->start();
+  }
+
+  Timestamp begin(Timestamp::now());
+  start.countDown();
+  loop.loop();
+  double seconds = timeDifference(Timestamp::now(), begin);
+  printf("%d threads, batch %3d: %.3f seconds, %.0f functors/s, iterations %jd\n",
+         nthreads, batch, seconds, g_total / seconds, loop.iteration());
+  for (const auto& thr : threads)
+  {
+    thr->join();
+  }
+  g_loop = NULL;
+}
+
+int main(int argc, char* argv[])
 {
+  if (argc > 1)
+  {
+    // eventloop_unittest threads [functors_per_thread]
+    int nthreads = atoi(argv[1]);
+    int n = argc > 2 ? atoi(argv[2]) : 1000*1000;
+    n = n / 64 * 64;
+    bench(nthreads, n, 1);
+    bench(nthreads, n, 64);
+    return 0;
+  }
+
   printf("main(): pid = %d, tid = %d\n", getpid(), CurrentThread::tid());
 
   assert(EventLoop::getEventLoopOfCurrentThread() == NULL);
@@ -0,0 +1,158 @@
+// TcpConnection::setFlowControl(), an echo server to a client
+// which stops reading for a while.  The server's own startRead() and
+// stopRead() neither override nor get overridden by the pause.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2017;
+const size_t kHighWaterMark = 256*1024;
+const size_t kLowWaterMark = 64*1024;
+const size_t kTotal = 64*1024*1024;
+const size_t kChunk = 64*1024;
+
+EventLoop* g_loop;
+TcpConnectionPtr g_serverConn;
+size_t g_maxOutput;
+size_t g_sent;
+size_t g_echoed;
+size_t g_pausedOutput;
+size_t g_stoppedEchoed;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->setFlowControl(kHighWaterMark, kLowWaterMark);
+    g_serverConn = conn;
+  }
+}
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+  g_maxOutput = std::max(g_maxOutput, conn->outputBytes());
+}
+
+void sendChunk(const TcpConnectionPtr& conn)
+{
+  if (g_sent < kTotal)
+  {
+    conn->send(string(kChunk, 'F'));
+    g_sent += kChunk;
+  }
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->stopRead();  // a slow consumer
+    sendChunk(conn);
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  g_echoed += buf->readableBytes();
+  buf->retrieveAll();
+  if (g_echoed == kTotal)
+  {
+    g_loop->quit();
+  }
+}
+
+void restarted()
+{
+  // not resumed by flow control alone
+  assert(g_echoed == g_stoppedEchoed);
+  g_serverConn->startRead();
+}
+
+void drained()
+{
+  assert(!g_serverConn->isReadPaused());
+  assert(!g_serverConn->isReading());
+  assert(g_serverConn->outputBytes() == 0);
+  g_stoppedEchoed = g_echoed;
+  g_loop->runAfter(0.2, restarted);
+}
+
+void stillPaused(TcpClient* client)
+{
+  // startRead() didn't override the pause
+  assert(g_serverConn->isReadPaused());
+  assert(g_serverConn->outputBytes() <= g_pausedOutput);
+  g_serverConn->stopRead();
+  client->connection()->startRead();
+  g_loop->runAfter(0.5, drained);
+}
+
+void stalled(TcpClient* client)
+{
+  // everything in between is full, the server stops reading
+  assert(g_serverConn->isReadPaused());
+  assert(g_serverConn->isReading());
+  g_pausedOutput = g_serverConn->outputBytes();
+  printf("stalled: sent %zu, server output %zu, max %zu\n",
+         g_sent, g_pausedOutput, g_maxOutput);
+  g_serverConn->startRead();
+  g_loop->runAfter(0.2, std::bind(stillPaused, client));
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, sent %zu echoed %zu\n", g_sent, g_echoed);
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(30, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "EchoServer");
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "SlowClient");
+  client.setConnectionCallback(onClientConnection);
+  client.setMessageCallback(onClientMessage);
+  client.setWriteCompleteCallback(sendChunk);
+  client.connect();
+  loop.runAfter(1.0, std::bind(stalled, &client));
+  loop.loop();
+
+  printf("echoed %zu, max server output %zu\n", g_echoed, g_maxOutput);
+  assert(g_echoed == kTotal);
+  // one read beyond the high water mark at most
+  assert(g_maxOutput < kHighWaterMark + 2*kChunk);
+  assert(!g_serverConn->isReadPaused());
+  client.disconnect();
+  g_serverConn.reset();
+  // connectDestroyed() of both
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
@@ -0,0 +1,124 @@
+// TcpServer::setIdleTimeout(), an idle client is closed, a busy one
+// stays until it stops writing, an exempted one stays.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2021;
+const double kIdleTimeout = 0.3;
+const double kBusyFor = 1.0;
+
+enum Client { kIdle, kBusy, kExempt, kNumClients };
+
+EventLoop* g_loop;
+Timestamp g_start;
+double g_closedAt[kNumClients];
+TcpClient* g_clients[kNumClients];
+int g_serverConnections;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  g_serverConnections += conn->connected() ? 1 : -1;
+}
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  if (buf->retrieveAllAsString() == "exempt")
+  {
+    conn->setIdleTimeout(0);
+  }
+}
+
+void onClientConnection(Client client, const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    if (client == kExempt)
+    {
+      conn->send("exempt");
+    }
+  }
+  else
+  {
+    g_closedAt[client] = timeDifference(Timestamp::now(), g_start);
+  }
+}
+
+void sendBusy()
+{
+  TcpConnectionPtr conn = g_clients[kBusy]->connection();
+  if (conn && timeDifference(Timestamp::now(), g_start) < kBusyFor)
+  {
+    conn->send("x");
+  }
+}
+
+void check()
+{
+  printf("idle closed at %.3f, busy at %.3f, exempt at %.3f\n",
+         g_closedAt[kIdle], g_closedAt[kBusy], g_closedAt[kExempt]);
+  assert(g_closedAt[kIdle] >= kIdleTimeout && g_closedAt[kIdle] < kIdleTimeout + 0.3);
+  assert(g_closedAt[kBusy] >= kBusyFor && g_closedAt[kBusy] < kBusyFor + kIdleTimeout + 0.3);
+  assert(g_closedAt[kExempt] == 0);
+  assert(g_serverConnections == 1);
+  g_loop->quit();
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout\n");
+  abort();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(10, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "IdleServer");
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.setIdleTimeout(kIdleTimeout);
+  server.start();
+
+  TcpClient idle(&loop, serverAddr, "Idle");
+  TcpClient busy(&loop, serverAddr, "Busy");
+  TcpClient exempt(&loop, serverAddr, "Exempt");
+  g_clients[kIdle] = &idle;
+  g_clients[kBusy] = &busy;
+  g_clients[kExempt] = &exempt;
+  g_start = Timestamp::now();
+  for (int i = 0; i < kNumClients; ++i)
+  {
+    g_clients[i]->setConnectionCallback(
+        std::bind(onClientConnection, static_cast<Client>(i), _1));
+    g_clients[i]->connect();
+  }
+  loop.runEvery(0.1, sendBusy);
+  loop.runAfter(kBusyFor + kIdleTimeout + 0.5, check);
+  loop.loop();
+
+  exempt.disconnect();
+  // connectDestroyed() of both
+  loop.runAfter(0.1, quit);
+  loop.loop();
+}
@@ -33,6 +33,24 @@ BOOST_AUTO_TEST_CASE(testInetAddress)
   BOOST_CHECK_EQUAL(addr3.toPort(), 65535);
 }
 
+BOOST_AUTO_TEST_CASE(testUnixDomain)
+{
+  InetAddress path = InetAddress::unixDomain("/tmp/muduo.sock");
+  BOOST_CHECK(path.isUnixDomain());
+  BOOST_CHECK_EQUAL(path.toIpPort(), string("unix:/tmp/muduo.sock"));
+  BOOST_CHECK_EQUAL(path.toPort(), 0);
+  BOOST_CHECK_EQUAL(path.getSockAddrLength(), offsetof(struct sockaddr_un, sun_path) + 16);
+
+  InetAddress abstract = InetAddress::unixDomain("@muduo");
+  BOOST_CHECK(abstract.isUnixDomain());
+  BOOST_CHECK_EQUAL(abstract.toIpPort(), string("unix:@muduo"));
+  BOOST_CHECK_EQUAL(abstract.getSockAddrLength(), offsetof(struct sockaddr_un, sun_path) + 6);
+
+  InetAddress addr(1234);
+  BOOST_CHECK(!addr.isUnixDomain());
+  BOOST_CHECK_EQUAL(addr.getSockAddrLength(), sizeof(struct sockaddr_in));
+}
+
 BOOST_AUTO_TEST_CASE(testInetAddressResolve)
 {
   InetAddress addr(80);
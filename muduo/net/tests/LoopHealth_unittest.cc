@@ -0,0 +1,70 @@
+// EventLoop::healthStats() of a loop running timers and functors.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kSlowMicroSeconds = 2000;
+
+EventLoop* g_loop;
+int g_functors;
+
+void functor()
+{
+  ++g_functors;
+}
+
+void slowTimer()
+{
+  ::usleep(2 * kSlowMicroSeconds);
+  for (int i = 0; i < 10; ++i)
+  {
+    g_loop->queueInLoop(functor);
+  }
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::ERROR);
+  EventLoop loop;
+  g_loop = &loop;
+  assert(!loop.healthStatsEnabled());
+  assert(loop.healthStats().pollWait.count() == 0);
+
+  loop.enableHealthStats(kSlowMicroSeconds);
+  loop.runAfter(0.01, slowTimer);
+  loop.runAfter(0.05, slowTimer);
+  loop.runAfter(0.15, quit);
+  loop.loop();
+
+  EventLoop::HealthStats stats = loop.healthStats();
+  printf("poll wait         %s\n", stats.pollWait.toString().c_str());
+  printf("channel callbacks %s\n", stats.channelCallbacks.toString().c_str());
+  printf("pending functors  %s\n", stats.pendingFunctors.toString().c_str());
+  printf("functor backlog   %s\n", stats.functorBacklog.toString().c_str());
+  printf("timer lateness    %s\n", stats.timerLateness.toString().c_str());
+  assert(g_functors == 20);
+  assert(stats.slowCallbacks == 2);
+  assert(stats.timerLateness.count() == 3);
+  assert(stats.channelCallbacks.max() >= 2 * kSlowMicroSeconds);
+  assert(stats.functorBacklog.max() >= 10);
+  assert(stats.pollWait.count() > 0);
+  assert(stats.pendingFunctors.count() == stats.channelCallbacks.count());
+
+  loop.resetHealthStats();
+  assert(loop.healthStats().timerLateness.count() == 0);
+  assert(loop.healthStats().slowCallbacks == 0);
+}
@@ -0,0 +1,149 @@
+// TcpConnection::sendFile(), a whole file, then one that is shorter
+// than asked for, which closes the connection after the file ends.
+// A pipe can't be sent from, which closes the connection too, whether
+// it's sent at once or queued after other output.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2023;
+const size_t kFileSize = 4*1024*1024;
+
+enum Mode { kFiles, kPipe, kQueuedPipe };
+
+EventLoop* g_loop;
+char g_file[] = "/tmp/muduo_sendfile_XXXXXX";
+string g_content;  // of the file
+Mode g_mode;
+size_t g_received;
+bool g_serverClosed;
+
+// the read end goes to sendFile(), which closes it
+int openPipe()
+{
+  int fds[2];
+  assert(::pipe(fds) == 0);
+  assert(::write(fds[1], "pipe", 4) == 4);
+  ::close(fds[1]);
+  return fds[0];
+}
+
+char expected(size_t offset)
+{
+  return static_cast<char>(offset % kFileSize % 251);
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    if (g_mode == kFiles)
+    {
+      conn->sendFile(::open(g_file, O_RDONLY | O_CLOEXEC), 0, kFileSize);
+      // asks for more than there is
+      conn->sendFile(::open(g_file, O_RDONLY | O_CLOEXEC), 0, kFileSize + 4096);
+    }
+    else
+    {
+      if (g_mode == kQueuedPipe)
+      {
+        // more than the socket takes at once
+        conn->send(g_content);
+        assert(conn->outputBytes() > 0);
+      }
+      conn->sendFile(openPipe(), 0, 4);
+    }
+    conn->send("never sent");
+  }
+  else
+  {
+    g_serverClosed = true;
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  for (size_t i = 0; i < buf->readableBytes(); ++i)
+  {
+    assert(buf->peek()[i] == expected(g_received + i));
+  }
+  g_received += buf->readableBytes();
+  buf->retrieveAll();
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (!conn->connected())
+  {
+    g_loop->quit();
+  }
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, received %zu\n", g_received);
+  abort();
+}
+
+int main()
+{
+  int fd = ::mkstemp(g_file);
+  assert(fd >= 0);
+  for (size_t i = 0; i < kFileSize; ++i)
+  {
+    g_content.push_back(expected(i));
+  }
+  assert(::write(fd, g_content.data(), g_content.size()) == static_cast<ssize_t>(g_content.size()));
+  ::close(fd);
+
+  Logger::setLogLevel(Logger::FATAL);
+  EventLoop loop;
+  g_loop = &loop;
+  loop.runAfter(10, timeout);
+
+  InetAddress serverAddr("127.0.0.1", kPort);
+  TcpServer server(&loop, serverAddr, "FileServer");
+  server.setConnectionCallback(onServerConnection);
+  server.start();
+
+  const Mode modes[] = { kFiles, kPipe, kQueuedPipe };
+  // both files, and nothing after the short one, nor after the pipe
+  const size_t expectedBytes[] = { 2 * kFileSize, 0, kFileSize };
+  for (int i = 0; i < 3; ++i)
+  {
+    g_mode = modes[i];
+    g_received = 0;
+    g_serverClosed = false;
+    TcpClient client(&loop, serverAddr, "FileClient");
+    client.setConnectionCallback(onClientConnection);
+    client.setMessageCallback(onClientMessage);
+    client.connect();
+    loop.loop();
+    // connectDestroyed() of both
+    loop.runAfter(0.1, quit);
+    loop.loop();
+
+    printf("mode %d received %zu\n", g_mode, g_received);
+    assert(g_received == expectedBytes[i]);
+    assert(g_serverClosed);
+  }
+  ::unlink(g_file);
+}
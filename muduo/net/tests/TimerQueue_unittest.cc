@@ -2,7 +2,11 @@
 #include "muduo/net/EventLoopThread.h"
 #include "muduo/base/Thread.h"
 
+#include <vector>
+
+#include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -32,8 +36,81 @@ void cancel(TimerId timer)
   printf("cancelled at %s\n", Timestamp::now().toString().c_str());
 }
 
-int main()
+// timer benchmark, of std::set and TimingWheel, only with a number of timers
+
+int g_fired;
+int g_early;
+int g_expected;
+
+void onTimer(Timestamp when)
+{
+  if (Timestamp::now() < when)
+  {
+    ++g_early;
+  }
+  if (++g_fired == g_expected)
+  {
+    g_loop->quit();
+  }
+}
+
+void bench(bool wheel, int n)
 {
+  if (wheel)
+  {
+    ::setenv("MUDUO_USE_TIMING_WHEEL", "1", 1);
+  }
+  else
+  {
+    ::unsetenv("MUDUO_USE_TIMING_WHEEL");
+  }
+  EventLoop loop;
+  g_loop = &loop;
+  g_fired = 0;
+  g_early = 0;
+  g_expected = n - n / 2;
+
+  std::vector<TimerId> timers;
+  timers.reserve(n);
+  Timestamp start(Timestamp::now());
+  Timestamp last;
+  for (int i = 0; i < n; ++i)
+  {
+    // spreads over one second
+    Timestamp when(addTime(start, 0.5 + (i % 1000) / 1000.0));
+    timers.push_back(loop.runAt(when, std::bind(onTimer, when)));
+    last = std::max(last, when);
+  }
+  Timestamp added(Timestamp::now());
+  for (int i = 0; i < n; i += 2)
+  {
+    loop.cancel(timers[i]);
+  }
+  Timestamp canceled(Timestamp::now());
+  loop.loop();
+  Timestamp done(Timestamp::now());
+
+  printf("%s: add %d %.3fs, cancel %d %.3fs, all fired %.3fs after the last deadline\n",
+         wheel ? "TimingWheel" : "std::set   ",
+         n, timeDifference(added, start),
+         n / 2, timeDifference(canceled, added),
+         timeDifference(done, last));
+  assert(g_fired == g_expected);
+  assert(g_early == 0);
+  g_loop = NULL;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+  {
+    // timerqueue_unittest number_of_timers
+    int n = atoi(argv[1]);
+    bench(false, n);
+    bench(true, n);
+    return 0;
+  }
+
   printTid();
   sleep(1);
   {
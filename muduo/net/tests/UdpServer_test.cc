@@ -0,0 +1,159 @@
+// Blasts small datagrams at a UdpServer, like telemetry ingest,
+// and counts system calls per datagram on both ends.
+//
+// Usage: udpserver_test [datagrams [size [threads [batch [gso [gro]]]]]]
+// Loopback drops datagrams if the receiver is slower, compare received/sent.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/UdpServer.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2012;
+
+AtomicInt64 g_received;
+AtomicInt64 g_bytes;
+AtomicInt32 g_clientDone;
+
+void onMessage(UdpSocket*, const std::vector<UdpDatagram>& datagrams, Timestamp)
+{
+  int64_t bytes = 0;
+  for (const UdpDatagram& datagram : datagrams)
+  {
+    bytes += static_cast<int64_t>(datagram.size);
+  }
+  g_received.add(static_cast<int64_t>(datagrams.size()));
+  g_bytes.add(bytes);
+}
+
+class Blaster : noncopyable
+{
+ public:
+  Blaster(EventLoop* loop, const InetAddress& serverAddr,
+          int total, int size, int batch, bool gso)
+    : loop_(loop),
+      socket_(loop),
+      message_(size, 'U'),
+      total_(total),
+      sent_(0)
+  {
+    socket_.setBatch(batch);
+    if (gso)
+    {
+      socket_.setSegmentOffload(true);
+    }
+    socket_.connect(serverAddr);
+  }
+
+  void start()
+  {
+    loop_->runInLoop(std::bind(&Blaster::sendBurst, this));
+  }
+
+  UdpSocket::Stats stats() const { return socket_.stats(); }
+
+ private:
+  void sendBurst()
+  {
+    // one sendmmsg(2) per burst, flushed after this functor
+    for (int i = 0; i < socket_.batch() && sent_ < total_; ++i)
+    {
+      socket_.send(message_.data(), message_.size());
+      ++sent_;
+    }
+    if (sent_ < total_)
+    {
+      loop_->queueInLoop(std::bind(&Blaster::sendBurst, this));
+    }
+    else
+    {
+      g_clientDone.getAndSet(1);
+    }
+  }
+
+  EventLoop* loop_;
+  UdpSocket socket_;
+  const string message_;
+  const int total_;
+  int sent_;
+};
+
+void resetAndCountDown(std::unique_ptr<Blaster>* blaster, CountDownLatch* latch)
+{
+  blaster->reset();
+  latch->countDown();
+}
+
+void check(EventLoop* loop, int64_t* lastReceived)
+{
+  int64_t received = g_received.get();
+  if (g_clientDone.get() && received == *lastReceived)
+  {
+    loop->quit();
+  }
+  *lastReceived = received;
+}
+
+int main(int argc, char* argv[])
+{
+  int total = argc > 1 ? atoi(argv[1]) : 1000000;
+  int size = argc > 2 ? atoi(argv[2]) : 64;
+  int numThreads = argc > 3 ? atoi(argv[3]) : 0;
+  int batch = argc > 4 ? atoi(argv[4]) : UdpSocket::kDefaultBatch;
+  bool gso = argc > 5 && atoi(argv[5]) != 0;
+  bool gro = argc > 6 && atoi(argv[6]) != 0;
+  Logger::setLogLevel(Logger::WARN);
+
+  EventLoop loop;
+  InetAddress serverAddr("127.0.0.1", kPort);
+  UdpServer server(&loop, serverAddr, "UdpServer");
+  server.setThreadNum(numThreads);
+  server.setBatch(batch);
+  server.setOffload(false, gro);
+  server.setMessageCallback(onMessage);
+  server.start();
+
+  EventLoopThread clientThread;
+  EventLoop* clientLoop = clientThread.startLoop();
+  std::unique_ptr<Blaster> blaster(new Blaster(clientLoop, serverAddr, total, size, batch, gso));
+  Timestamp begin = Timestamp::now();
+  blaster->start();
+
+  int64_t lastReceived = -1;
+  loop.runEvery(0.2, std::bind(check, &loop, &lastReceived));
+  loop.loop();
+  double seconds = timeDifference(Timestamp::now(), begin) - 0.2;
+
+  UdpSocket::Stats client = blaster->stats();
+  UdpSocket::Stats serverStats = server.stats();
+  printf("batch %d gso %d gro %d: sent %" PRId64 " in %" PRId64 " sendmmsg, dropped %" PRId64 "\n",
+         batch, gso, gro, client.sent, client.sendCalls, client.dropped);
+  // none if all were dropped
+  const double perCall = serverStats.receiveCalls > 0
+      ? static_cast<double>(serverStats.received) / static_cast<double>(serverStats.receiveCalls)
+      : 0.0;
+  printf("received %" PRId64 " (%.1f%%) in %" PRId64 " recvmmsg, %.1f per call, truncated %" PRId64 "\n",
+         serverStats.received, 100.0 * static_cast<double>(serverStats.received) / total,
+         serverStats.receiveCalls, perCall, serverStats.truncated);
+  printf("%.3f seconds, %.0f datagrams per second, %.1f MiB/s\n",
+         seconds, static_cast<double>(g_received.get()) / seconds,
+         static_cast<double>(g_bytes.get()) / seconds / 1024 / 1024);
+
+  // UdpSocket must be destructed in its loop
+  CountDownLatch latch(1);
+  clientLoop->runInLoop(std::bind(resetAndCountDown, &blaster, &latch));
+  latch.wait();
+}
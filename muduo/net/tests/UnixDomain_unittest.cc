@@ -0,0 +1,156 @@
+// TcpServer and TcpClient over Unix domain sockets, echo through a socket
+// file which a crashed run left behind, then through an abstract one.
+// A second server on the path of a live one dies, the first one stays.
+
+#undef NDEBUG  // asserts are the checks, in release builds too
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t kMessageSize = 1024*1024;
+
+EventLoop* g_loop;
+string g_message;
+size_t g_echoed;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    assert(conn->localAddress().isUnixDomain());
+    assert(conn->peerAddress().isUnixDomain());
+  }
+}
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->send(g_message);
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  assert(buf->readableBytes() <= kMessageSize - g_echoed);
+  assert(memcmp(buf->peek(), g_message.data() + g_echoed, buf->readableBytes()) == 0);
+  g_echoed += buf->readableBytes();
+  buf->retrieveAll();
+  if (g_echoed == kMessageSize)
+  {
+    g_loop->quit();
+  }
+}
+
+void quit()
+{
+  g_loop->quit();
+}
+
+void timeout()
+{
+  fprintf(stderr, "timeout, echoed %zu\n", g_echoed);
+  abort();
+}
+
+bool isSocketFile(const char* path)
+{
+  struct stat st;
+  return ::stat(path, &st) == 0 && S_ISSOCK(st.st_mode);
+}
+
+void discard(const char*, int)
+{
+}
+
+void startSecondServer(const InetAddress& serverAddr)
+{
+  fflush(stdout);
+  pid_t pid = ::fork();
+  assert(pid >= 0);
+  if (pid == 0)
+  {
+    struct rlimit noCore = { 0, 0 };
+    ::setrlimit(RLIMIT_CORE, &noCore);
+    Logger::setOutput(discard);
+    TcpServer second(g_loop, serverAddr, "SecondServer");
+    _exit(0);
+  }
+  int status = 0;
+  assert(::waitpid(pid, &status, 0) == pid);
+  // bind(2) failed with EADDRINUSE
+  assert(!(WIFEXITED(status) && WEXITSTATUS(status) == 0));
+}
+
+void echo(const InetAddress& serverAddr)
+{
+  g_echoed = 0;
+  TcpServer server(g_loop, serverAddr, "UnixServer");
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.start();
+  startSecondServer(serverAddr);
+
+  TcpClient client(g_loop, serverAddr, "UnixClient");
+  client.setConnectionCallback(onClientConnection);
+  client.setMessageCallback(onClientMessage);
+  client.connect();
+  TimerId timer = g_loop->runAfter(5, timeout);
+  g_loop->loop();
+  g_loop->cancel(timer);
+  printf("%s echoed %zu\n", serverAddr.toIpPort().c_str(), g_echoed);
+
+  client.disconnect();
+  // connectDestroyed() of both
+  g_loop->runAfter(0.1, quit);
+  g_loop->loop();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  for (size_t i = 0; i < kMessageSize; ++i)
+  {
+    g_message.push_back(static_cast<char>(i % 251));
+  }
+
+  char path[64];
+  snprintf(path, sizeof path, "/tmp/muduo_unix_%d.sock", static_cast<int>(::getpid()));
+  InetAddress pathAddr = InetAddress::unixDomain(path);
+
+  // bound but never listened on, as if its server crashed
+  int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  assert(::bind(stale, pathAddr.getSockAddr(), pathAddr.getSockAddrLength()) == 0);
+  ::close(stale);
+  assert(isSocketFile(path));
+
+  echo(pathAddr);
+  // removed by the Acceptor
+  assert(!isSocketFile(path));
+
+  char name[64];
+  snprintf(name, sizeof name, "@muduo_unix_%d", static_cast<int>(::getpid()));
+  echo(InetAddress::unixDomain(name));
+}